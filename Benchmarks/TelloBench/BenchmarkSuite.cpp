@@ -0,0 +1,132 @@
+#include "BenchmarkSuite.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace Tello {
+
+void BenchmarkSuite::run(const std::string& name, const Body& body, usize ops_per_call)
+{
+    if (!m_config.filter.empty() && name.find(m_config.filter) == std::string::npos)
+        return;
+
+    auto time = [&](usize ops) {
+        auto start = std::chrono::steady_clock::now();
+        m_sink += body(ops);
+        return std::chrono::steady_clock::now() - start;
+    };
+    usize ops = 1;
+    while (time(ops) < m_config.min_sample_time)
+        ops *= 2;
+
+    std::vector<double> ns_per_op;
+    for (usize sample = 0; sample < std::max<usize>(m_config.samples, 1); ++sample)
+        ns_per_op.push_back(std::chrono::duration<double, std::nano>(time(ops)).count() / (ops * ops_per_call));
+    std::sort(ns_per_op.begin(), ns_per_op.end());
+    m_results.push_back({ name, ns_per_op[ns_per_op.size() / 2], ns_per_op.front(), ops * ops_per_call * ns_per_op.size() });
+
+    auto& result = m_results.back();
+    std::cout << std::left << std::setw(36) << result.name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(14) << result.ns_per_op << " ns/op" << std::setw(14) << result.min_ns_per_op << " min"
+              << std::endl;
+}
+
+std::string BenchmarkSuite::to_json() const
+{
+    std::ostringstream json;
+    json << std::setprecision(6) << "{\n  \"version\": 1,\n  \"machine\": \"" << machine_description()
+         << "\",\n  \"results\": [";
+    for (usize i = 0; i < m_results.size(); ++i) {
+        auto& result = m_results[i];
+        json << (i == 0 ? "\n" : ",\n") << "    { \"name\": \"" << result.name << "\", \"ns_per_op\": " << result.ns_per_op
+             << ", \"min_ns_per_op\": " << result.min_ns_per_op << ", \"ops\": " << result.ops << " }";
+    }
+    json << "\n  ]\n}\n";
+    return json.str();
+}
+
+// Finds `"key": ` after `position` within the current object and returns where its value starts
+static std::optional<usize> find_value(const std::string& json, const std::string& key, usize position, usize object_end)
+{
+    auto key_position = json.find("\"" + key + "\"", position);
+    if (key_position == std::string::npos || key_position > object_end)
+        return {};
+    auto colon = json.find(':', key_position);
+    if (colon == std::string::npos || colon > object_end)
+        return {};
+    return json.find_first_not_of(" \t\n", colon + 1);
+}
+
+std::optional<BenchmarkBaseline> BenchmarkSuite::read_json(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+        return {};
+    std::stringstream contents;
+    contents << file.rdbuf();
+    auto json = contents.str();
+
+    BenchmarkBaseline baseline;
+    auto results_start = json.find("\"results\"");
+    if (results_start == std::string::npos)
+        return {};
+    if (auto machine = find_value(json, "machine", 0, results_start); machine && json[*machine] == '"')
+        baseline.machine = json.substr(*machine + 1, json.find('"', *machine + 1) - *machine - 1);
+    auto& results = baseline.results;
+    for (auto object_start = json.find('{', results_start); object_start != std::string::npos;
+         object_start = json.find('{', object_start + 1)) {
+        auto object_end = json.find('}', object_start);
+        if (object_end == std::string::npos)
+            return {};
+        auto name = find_value(json, "name", object_start, object_end);
+        auto ns_per_op = find_value(json, "ns_per_op", object_start, object_end);
+        if (!name || !ns_per_op || json[*name] != '"')
+            return {};
+        BenchmarkResult result;
+        auto name_end = json.find('"', *name + 1);
+        result.name = json.substr(*name + 1, name_end - *name - 1);
+        result.ns_per_op = std::strtod(json.c_str() + *ns_per_op, nullptr);
+        if (auto min_ns_per_op = find_value(json, "min_ns_per_op", object_start, object_end))
+            result.min_ns_per_op = std::strtod(json.c_str() + *min_ns_per_op, nullptr);
+        if (auto ops = find_value(json, "ops", object_start, object_end))
+            result.ops = std::strtoull(json.c_str() + *ops, nullptr, 10);
+        results.push_back(std::move(result));
+        object_start = object_end;
+    }
+    return baseline;
+}
+
+std::string BenchmarkSuite::machine_description()
+{
+    std::string cpu_model = "unknown CPU";
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    for (std::string line; std::getline(cpuinfo, line);) {
+        if (line.starts_with("model name")) {
+            if (auto colon = line.find(':'); colon != std::string::npos && colon + 2 <= line.size())
+                cpu_model = line.substr(colon + 2);
+            break;
+        }
+    }
+    // Kept valid as a JSON string
+    std::erase_if(cpu_model, [](char c) { return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20; });
+    return cpu_model + ", " + std::to_string(std::thread::hardware_concurrency()) + " threads";
+}
+
+std::vector<BaselineComparison> BenchmarkSuite::compare(const std::vector<BenchmarkResult>& baseline, double tolerance) const
+{
+    std::vector<BaselineComparison> comparisons;
+    for (auto& result : m_results) {
+        auto it = std::find_if(baseline.begin(), baseline.end(), [&](auto& entry) { return entry.name == result.name; });
+        if (it == baseline.end() || it->ns_per_op <= 0)
+            continue;
+        auto change = result.ns_per_op / it->ns_per_op - 1;
+        comparisons.push_back({ result.name, it->ns_per_op, result.ns_per_op, change, change > tolerance });
+    }
+    return comparisons;
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Utils/Types.h>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Tello {
+
+struct BenchmarkResult {
+    std::string name;
+    // Median over the samples
+    double ns_per_op { 0 };
+    // Fastest sample, how close to the median it is tells how noisy the run was
+    double min_ns_per_op { 0 };
+    u64 ops { 0 };
+};
+
+// Results as written by BenchmarkSuite::to_json, along with the machine they were measured on
+struct BenchmarkBaseline {
+    // Empty if the file does not say
+    std::string machine;
+    std::vector<BenchmarkResult> results;
+};
+
+struct BaselineComparison {
+    std::string name;
+    double baseline_ns_per_op { 0 };
+    double ns_per_op { 0 };
+    // Positive is slower than the baseline
+    double change { 0 };
+    bool regressed { false };
+};
+
+struct BenchmarkSuiteConfig {
+    // Every benchmark is timed in this many samples of at least `min_sample_time` each
+    usize samples { 7 };
+    std::chrono::milliseconds min_sample_time { 20 };
+    // Only names containing this run, everything if empty
+    std::string filter {};
+};
+
+// Times benchmarks the same way each: the op count per sample is doubled until a sample takes at least
+// min_sample_time, then the median of the samples is the result
+class BenchmarkSuite {
+public:
+    // Runs `ops` operations per call and returns something derived from their results, so the work cannot be
+    // optimized away
+    using Body = std::function<u64(usize ops)>;
+
+    explicit BenchmarkSuite(BenchmarkSuiteConfig config)
+        : m_config(std::move(config))
+    {
+    }
+
+    // `ops_per_call` is for bodies that do a fixed batch of operations per call
+    void run(const std::string& name, const Body& body, usize ops_per_call = 1);
+
+    [[nodiscard]] const std::vector<BenchmarkResult>& results() const { return m_results; }
+
+    // {"version": 1, "machine": ..., "results": [{"name": ..., "ns_per_op": ..., "min_ns_per_op": ..., "ops": ...}, ...]}
+    [[nodiscard]] std::string to_json() const;
+    // Reads back what to_json writes, nothing if the file is missing or malformed
+    static std::optional<BenchmarkBaseline> read_json(const std::string& path);
+
+    // The CPU model and the number of hardware threads. Absolute timings are only comparable between runs on
+    // the same machine.
+    static std::string machine_description();
+
+    // Benchmarks missing from either side are left out. A benchmark regressed once it got slower by more than
+    // `tolerance`, e.g. 0.2 for 20%.
+    [[nodiscard]] std::vector<BaselineComparison> compare(const std::vector<BenchmarkResult>& baseline, double tolerance) const;
+
+private:
+    BenchmarkSuiteConfig m_config;
+    std::vector<BenchmarkResult> m_results;
+    u64 m_sink { 0 };
+};
+
+}
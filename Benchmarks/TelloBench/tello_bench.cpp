@@ -0,0 +1,327 @@
+#include "BenchmarkSuite.h"
+#include <DronePacket.h>
+#include <FramePool.h>
+#include <PacketCapture.h>
+#include <PacketReplay.h>
+#include <SimulatorProcess.h>
+#include <TelloDrone.h>
+#include <Utils/CRCHelpers.h>
+#include <VideoReassembler.h>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+// The hot path microbenchmarks: packet serialization and parsing, the CRCs, video reassembly, and the flight
+// and log data decoding through the cmd receive path. The cmd inputs are recorded from the simulator (or taken
+// from a capture file), the video stream is synthetic. Results are written as JSON and compared against the
+// stored baseline, any benchmark slower than the tolerance allows fails the run.
+//
+// The baseline holds absolute timings, so it is only meaningful on the machine it was recorded on, which it
+// names. Against a baseline from any other machine the comparison is printed but never fails the run: record
+// one for the machine that does the comparing with `tello_bench --update-baseline` (in a Release build) first.
+//
+// Usage: tello_bench [--baseline <file>] [--output <file>] [--update-baseline] [--tolerance <fraction>]
+//                    [--filter <substring>] [--capture <file>]
+
+static constexpr u16 SIMULATOR_PORT = 29500;
+static constexpr std::chrono::seconds RECORDING_DURATION { 1 };
+static constexpr u32 RECORDING_RATE_HZ = 500;
+static constexpr usize VIDEO_FRAME_COUNT = 256;
+static constexpr usize VIDEO_SEGMENT_PAYLOAD_SIZE = 1458;
+
+using Datagram = std::vector<u8>;
+
+struct Options {
+    std::string baseline_path { TELLO_BENCH_BASELINE };
+    std::string output_path;
+    std::string capture_path;
+    bool update_baseline { false };
+    double tolerance { 0.25 };
+    Tello::BenchmarkSuiteConfig suite;
+};
+
+// A non-negative fraction, -1 if `text` is anything else
+static double parse_tolerance(char const* text)
+{
+    char* end;
+    double tolerance = std::strtod(text, &end);
+    if (end == text || *end != '\0' || !std::isfinite(tolerance) || tolerance < 0)
+        return -1;
+    return tolerance;
+}
+
+static std::optional<Options> parse_options(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        bool has_value = i + 1 < argc;
+        if (argument == "--baseline" && has_value)
+            options.baseline_path = argv[++i];
+        else if (argument == "--output" && has_value)
+            options.output_path = argv[++i];
+        else if (argument == "--capture" && has_value)
+            options.capture_path = argv[++i];
+        else if (argument == "--tolerance" && has_value)
+            options.tolerance = parse_tolerance(argv[++i]);
+        else if (argument == "--filter" && has_value)
+            options.suite.filter = argv[++i];
+        else if (argument == "--update-baseline")
+            options.update_baseline = true;
+        else
+            return {};
+    }
+    if (options.tolerance < 0)
+        return {};
+    return options;
+}
+
+// Runs the simulator in a child process and captures what a drone receives from it
+static bool record_simulated_flight(const std::string& path)
+{
+    Tello::SimulatorConfig simulator_config;
+    simulator_config.cmd_port = SIMULATOR_PORT;
+    simulator_config.flight_data_rate_hz = RECORDING_RATE_HZ;
+    simulator_config.log_data_rate_hz = RECORDING_RATE_HZ;
+    simulator_config.video_fps = 0;
+    auto simulator = Tello::SimulatorProcess::spawn(simulator_config);
+    if (!simulator)
+        return false;
+
+    bool success = false;
+    {
+        Tello::DroneConfig config;
+        config.drone_ip = "127.0.0.1";
+        config.drone_cmd_port = SIMULATOR_PORT;
+        config.video_port = 0;
+        config.forward_video = false;
+        Tello::Drone drone(config);
+        drone.wait_until_connected();
+        if (drone.start_capture(path)) {
+            std::this_thread::sleep_for(RECORDING_DURATION);
+            drone.stop_capture();
+            success = true;
+        }
+    }
+    simulator->stop();
+    return success;
+}
+
+// The cmd datagrams of the capture with the given command
+static std::vector<Datagram> read_cmd_datagrams(const std::string& path, Tello::CommandID cmd_id)
+{
+    std::vector<Datagram> datagrams;
+    auto reader = Tello::PacketCaptureReader::open(path);
+    if (!reader)
+        return datagrams;
+    while (auto record = reader->next()) {
+        if (record->source != Tello::CaptureSource::CmdSocket)
+            continue;
+        auto packet = Tello::DronePacketView::parse(record->data);
+        if (packet && packet->cmd_id == cmd_id)
+            datagrams.emplace_back(record->data.begin(), record->data.end());
+    }
+    return datagrams;
+}
+
+static bool write_capture(const std::string& path, const std::vector<Datagram>& datagrams)
+{
+    auto writer = Tello::PacketCaptureWriter::open(path);
+    if (!writer)
+        return false;
+    auto timestamp = std::chrono::system_clock::now();
+    for (auto& datagram : datagrams)
+        writer->append(Tello::CaptureSource::CmdSocket, timestamp, datagram);
+    writer->close();
+    return true;
+}
+
+// Frame numbers run through all 256 values, so the stream can be fed again and again without a discontinuity
+static std::vector<Datagram> generate_video_stream()
+{
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<usize> p_frame_size(4000, 20000);
+    std::vector<Datagram> stream;
+    for (usize frame = 0; frame < VIDEO_FRAME_COUNT; ++frame) {
+        usize size = frame % 30 == 0 ? 60000 : p_frame_size(random);
+        usize segments = (size + VIDEO_SEGMENT_PAYLOAD_SIZE - 1) / VIDEO_SEGMENT_PAYLOAD_SIZE;
+        for (usize segment = 0; segment < segments; ++segment) {
+            auto payload_size = std::min(VIDEO_SEGMENT_PAYLOAD_SIZE, size - segment * VIDEO_SEGMENT_PAYLOAD_SIZE);
+            Datagram datagram(2 + payload_size, static_cast<u8>(random()));
+            datagram[0] = frame;
+            datagram[1] = segment | (segment == segments - 1 ? 128 : 0);
+            stream.push_back(std::move(datagram));
+        }
+    }
+    return stream;
+}
+
+static void run_packet_benchmarks(Tello::BenchmarkSuite& suite, const std::vector<Datagram>& flight_data)
+{
+    Tello::PacketPayload controls_payload(11);
+    Tello::DronePacket controls(96, Tello::CommandID::SET_CURRENT_FLIGHT_CONTROLS, std::move(controls_payload));
+    u8 buffer[256];
+    suite.run("packet/encode_controls", [&](usize ops) {
+        u64 total = 0;
+        for (usize i = 0; i < ops; ++i)
+            total += controls.encode(buffer);
+        return total;
+    });
+    suite.run("packet/serialize_controls", [&](usize ops) {
+        u64 total = 0;
+        for (usize i = 0; i < ops; ++i)
+            total += controls.serialize().size();
+        return total;
+    });
+    if (flight_data.empty())
+        return;
+    suite.run("packet/deserialize_flight_data", [&](usize ops) {
+        u64 total = 0;
+        for (usize i = 0; i < ops; ++i)
+            total += Tello::DronePacket::deserialize(flight_data[i % flight_data.size()]).has_value();
+        return total;
+    });
+    suite.run("packet/parse_flight_data", [&](usize ops) {
+        u64 total = 0;
+        for (usize i = 0; i < ops; ++i)
+            total += Tello::DronePacketView::parse(flight_data[i % flight_data.size()]).has_value();
+        return total;
+    });
+}
+
+static void run_crc_benchmarks(Tello::BenchmarkSuite& suite)
+{
+    std::mt19937 random(1234);
+    std::vector<u8> bytes(1460);
+    for (auto& byte : bytes)
+        byte = random();
+    suite.run("crc/fast_crc8_3B", [&](usize ops) {
+        u64 total = 0;
+        for (usize i = 0; i < ops; ++i) {
+            bytes[0] = i;
+            total += fast_crc8(std::span<const u8>(bytes).subspan(0, 3));
+        }
+        return total;
+    });
+    for (usize size : { 64, 1460 }) {
+        suite.run("crc/fast_crc16_" + std::to_string(size) + "B", [&](usize ops) {
+            u64 total = 0;
+            for (usize i = 0; i < ops; ++i) {
+                bytes[0] = i;
+                total += fast_crc16(std::span<const u8>(bytes).subspan(0, size));
+            }
+            return total;
+        });
+    }
+}
+
+static void run_video_benchmarks(Tello::BenchmarkSuite& suite)
+{
+    auto stream = generate_video_stream();
+    auto frame_pool = Tello::FramePool::create({ .buffer_count = 8 });
+    u64 frames = 0;
+    Tello::VideoReassembler reassembler(frame_pool, 4, [&](Tello::VideoFrame frame) { frames += frame.size() > 0; });
+    auto receive_time = std::chrono::steady_clock::now();
+    usize next_datagram = 0;
+    suite.run("video/reassemble_segment", [&](usize ops) {
+        for (usize i = 0; i < ops; ++i) {
+            reassembler.add_segment(stream[next_datagram], receive_time);
+            next_datagram = (next_datagram + 1) % stream.size();
+        }
+        return frames;
+    });
+}
+
+// Replays the datagrams as fast as possible through a drone's cmd receive path, from the parsing to the
+// telemetry being published
+static void run_decode_benchmark(Tello::BenchmarkSuite& suite, const std::string& name, const std::vector<Datagram>& datagrams)
+{
+    if (datagrams.empty()) {
+        std::cerr << "No input for " << name << std::endl;
+        return;
+    }
+    auto path = (std::filesystem::temp_directory_path() / "tello_bench_input.cap").string();
+    if (!write_capture(path, datagrams))
+        return;
+    Tello::DroneConfig config;
+    config.forward_video = false;
+    auto replay = Tello::PacketReplay::open(path, config);
+    std::filesystem::remove(path);
+    if (!replay)
+        return;
+    suite.run(name, [&](usize ops) {
+        u64 total = 0;
+        for (usize i = 0; i < ops; ++i)
+            total += replay->run({ .speed = 0 }).bytes;
+        return total;
+    }, datagrams.size());
+}
+
+int main(int argc, char** argv)
+{
+    auto options = parse_options(argc, argv);
+    if (!options) {
+        std::cerr << "Usage: " << argv[0] << " [--baseline <file>] [--output <file>] [--update-baseline] "
+                  << "[--tolerance <fraction>] [--filter <substring>] [--capture <file>]" << std::endl;
+        return 2;
+    }
+
+    auto capture_path = options->capture_path;
+    if (capture_path.empty()) {
+        capture_path = (std::filesystem::temp_directory_path() / "tello_bench_recording.cap").string();
+        if (!record_simulated_flight(capture_path))
+            return 1;
+    }
+    auto flight_data = read_cmd_datagrams(capture_path, Tello::CommandID::FLIGHT_DATA);
+    auto log_data = read_cmd_datagrams(capture_path, Tello::CommandID::DRONE_LOG_DATA);
+    if (options->capture_path.empty())
+        std::filesystem::remove(capture_path);
+    std::cout << "Inputs: " << flight_data.size() << " flight data and " << log_data.size() << " log data datagrams"
+              << std::endl;
+
+    Tello::BenchmarkSuite suite(options->suite);
+    run_packet_benchmarks(suite, flight_data);
+    run_crc_benchmarks(suite);
+    run_video_benchmarks(suite);
+    run_decode_benchmark(suite, "decode/flight_data", flight_data);
+    run_decode_benchmark(suite, "decode/log_data", log_data);
+
+    auto json = suite.to_json();
+    if (!options->output_path.empty())
+        std::ofstream(options->output_path) << json;
+    if (options->update_baseline) {
+        std::ofstream(options->baseline_path) << json;
+        std::cout << "Baseline written to " << options->baseline_path << std::endl;
+        return 0;
+    }
+
+    auto baseline = Tello::BenchmarkSuite::read_json(options->baseline_path);
+    if (!baseline) {
+        std::cout << "No baseline at " << options->baseline_path << ", nothing to compare against" << std::endl;
+        return 0;
+    }
+    // Timings from another machine say nothing about this change
+    auto machine = Tello::BenchmarkSuite::machine_description();
+    bool same_machine = baseline->machine == machine;
+    if (!same_machine) {
+        std::cout << "\nThe baseline was recorded on " << (baseline->machine.empty() ? "an unnamed machine" : baseline->machine)
+                  << ", not on this " << machine << ". Only comparing for information, run with --update-baseline to "
+                  << "record a baseline for this machine." << std::endl;
+    }
+    bool regressed = false;
+    std::cout << "\n" << std::left << std::setw(36) << "benchmark" << std::right << std::setw(14) << "baseline ns"
+              << std::setw(14) << "ns" << std::setw(10) << "change" << std::endl;
+    for (auto& comparison : suite.compare(baseline->results, options->tolerance)) {
+        std::cout << std::left << std::setw(36) << comparison.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(14) << comparison.baseline_ns_per_op << std::setw(14) << comparison.ns_per_op
+                  << std::setw(9) << std::showpos << std::setprecision(1) << comparison.change * 100 << "%"
+                  << std::noshowpos << (comparison.regressed ? "  REGRESSION" : "") << std::endl;
+        regressed |= comparison.regressed;
+    }
+    return regressed && same_machine ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+#include <Fleet.h>
+#include <SimulatorProcess.h>
+#include <TelloDrone.h>
+#include <atomic>
+#include <iostream>
+#include <memory>
+
+// Flies the same mission (take off, flip, land, repeated) on every drone of a Fleet, all driven from the main
+// thread: once with the blocking actions, one drone after the other, and once with the awaitable actions, all
+// drones at once. The simulators delay their responses like a WIFI link would.
+
+static constexpr u16 SIMULATOR_BASE_PORT = 29100;
+static constexpr usize DRONE_COUNT = 16;
+static constexpr usize MISSION_ROUNDS = 10;
+static constexpr std::chrono::milliseconds RESPONSE_DELAY { 5 };
+
+static bool fly_mission(Tello::Drone& drone)
+{
+    bool success = true;
+    for (usize round = 0; round < MISSION_ROUNDS; ++round) {
+        success &= drone.take_off();
+        success &= drone.flip(Tello::FlipDirection::Forward);
+        success &= drone.land();
+    }
+    return success;
+}
+
+static Tello::Task<void> fly_mission_async(Tello::Drone& drone, std::atomic<usize>& failures)
+{
+    for (usize round = 0; round < MISSION_ROUNDS; ++round) {
+        failures += !co_await drone.take_off_async();
+        failures += !co_await drone.flip_async(Tello::FlipDirection::Forward);
+        failures += !co_await drone.land_async();
+    }
+}
+
+int main()
+{
+    std::vector<Tello::SimulatorConfig> simulator_configs;
+    for (usize i = 0; i < DRONE_COUNT; ++i) {
+        Tello::SimulatorConfig config;
+        config.cmd_port = SIMULATOR_BASE_PORT + i;
+        config.video_fps = 0;
+        config.response_delay = RESPONSE_DELAY;
+        simulator_configs.push_back(config);
+    }
+    auto simulator = Tello::SimulatorProcess::spawn(std::move(simulator_configs));
+    if (!simulator)
+        return 1;
+
+    bool success = true;
+    {
+        Tello::Fleet fleet({ 1 });
+        std::vector<Tello::Drone*> drones;
+        for (usize i = 0; i < DRONE_COUNT; ++i) {
+            Tello::DroneConfig config;
+            config.drone_ip = "127.0.0.1";
+            config.drone_cmd_port = SIMULATOR_BASE_PORT + i;
+            config.video_port = 0;
+            config.forward_video = false;
+            if (auto* drone = fleet.add_drone(config))
+                drones.push_back(drone);
+        }
+        for (auto* drone : drones)
+            drone->wait_until_connected();
+
+        auto start = std::chrono::steady_clock::now();
+        for (auto* drone : drones)
+            success &= fly_mission(*drone);
+        auto blocking_time = std::chrono::steady_clock::now() - start;
+
+        std::atomic<usize> failures { 0 };
+        start = std::chrono::steady_clock::now();
+        std::vector<Tello::Task<void>> missions;
+        for (auto* drone : drones)
+            missions.push_back(fly_mission_async(*drone, failures));
+        Tello::sync_wait(Tello::when_all(std::move(missions)));
+        auto async_time = std::chrono::steady_clock::now() - start;
+        success &= failures == 0;
+
+        auto ms = [](std::chrono::nanoseconds duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+        usize commands = drones.size() * MISSION_ROUNDS * 3;
+        std::cout << drones.size() << " drones, " << commands << " commands, " << RESPONSE_DELAY.count()
+                  << " ms response delay\n"
+                  << "blocking, one drone after the other: " << ms(blocking_time) << " ms\n"
+                  << "awaitable, all drones at once: " << ms(async_time) << " ms, " << failures << " failures" << std::endl;
+    }
+
+    simulator->stop();
+    return success ? 0 : 1;
+}
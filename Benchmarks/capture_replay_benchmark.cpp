@@ -0,0 +1,87 @@
+#include <PacketReplay.h>
+#include <SimulatorProcess.h>
+#include <TelloDrone.h>
+#include <atomic>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+
+// Captures a few seconds of a simulated flight (telemetry and video), then replays the capture in real time and
+// as fast as possible. Reports how much faster than real time the receive paths run offline, and checks that
+// the replays see the same video frames and flight data as the live drone did.
+
+static constexpr u16 SIMULATOR_PORT = 29400;
+static constexpr std::chrono::seconds CAPTURE_DURATION { 3 };
+
+struct Seen {
+    u64 frames { 0 };
+    u64 flight_data { 0 };
+};
+
+int main()
+{
+    Tello::SimulatorConfig simulator_config;
+    simulator_config.cmd_port = SIMULATOR_PORT;
+    auto simulator = Tello::SimulatorProcess::spawn(simulator_config);
+    if (!simulator)
+        return 1;
+
+    auto path = (std::filesystem::temp_directory_path() / "tello_capture_replay_benchmark.cap").string();
+    Seen live;
+    Tello::PacketCaptureStatistics capture_statistics;
+    {
+        Tello::DroneConfig config;
+        config.drone_ip = "127.0.0.1";
+        config.drone_cmd_port = SIMULATOR_PORT;
+        config.video_port = 0;
+        config.forward_video = false;
+        Tello::Drone drone(config);
+        drone.wait_until_connected();
+        auto capture = drone.start_capture(path);
+        if (!capture)
+            return 1;
+        // Counted while capturing, and the video from the keyframe the capture requests on, like a replay sees it
+        std::atomic<bool> capturing { true };
+        auto idr_frames_before = drone.get_video_stream_statistics().idr_frames_received;
+        auto frames_subscription = drone.subscribe_video_frames([&](const Tello::VideoFrame&) {
+            live.frames += capturing && drone.get_video_stream_statistics().idr_frames_received > idr_frames_before;
+        });
+        auto flight_data_subscription = drone.get_flight_data_stream().subscribe([&](const auto&) { live.flight_data += capturing; });
+        std::this_thread::sleep_for(CAPTURE_DURATION);
+        capturing = false;
+        drone.stop_capture();
+        drone.unsubscribe_video_frames(frames_subscription);
+        drone.get_flight_data_stream().unsubscribe(flight_data_subscription);
+        capture_statistics = capture->get_statistics();
+    }
+    simulator->stop();
+
+    bool success = capture_statistics.records_dropped == 0;
+    std::cout << "captured " << capture_statistics.records_written << " datagrams, " << capture_statistics.bytes_written / 1024
+              << " KiB, live: " << live.frames << " frames, " << live.flight_data << " flight data\n";
+    std::cout << std::setw(8) << "speed" << std::setw(10) << "frames" << std::setw(8) << "flight" << std::setw(12)
+              << "replay ms" << std::setw(12) << "max lag ms" << std::setw(12) << "x realtime" << std::setw(10)
+              << "MB/s" << std::endl;
+    for (double speed : { 1.0, 0.0 }) {
+        Tello::DroneConfig config;
+        config.forward_video = false;
+        auto replay = Tello::PacketReplay::open(path, config);
+        if (!replay)
+            return 1;
+        Seen replayed;
+        replay->drone().subscribe_video_frames([&](const Tello::VideoFrame&) { replayed.frames++; });
+        replay->drone().get_flight_data_stream().subscribe([&](const auto&) { replayed.flight_data++; });
+        auto statistics = replay->run({ .speed = speed });
+
+        auto ms = [](std::chrono::nanoseconds duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+        std::cout << std::setw(8) << (speed > 0 ? "1" : "max") << std::setw(10) << replayed.frames << std::setw(8)
+                  << replayed.flight_data << std::fixed << std::setprecision(1) << std::setw(12)
+                  << ms(statistics.replay_duration) << std::setw(12) << ms(statistics.max_lag) << std::setw(12)
+                  << ms(statistics.capture_duration) / ms(statistics.replay_duration) << std::setw(10)
+                  << statistics.bytes / (ms(statistics.replay_duration) * 1000) << std::endl;
+        // The live counts may include a frame or sample that was being handled when the capture stopped
+        success &= replayed.frames + 1 >= live.frames && replayed.flight_data + 1 >= live.flight_data;
+    }
+    std::filesystem::remove(path);
+    return success ? 0 : 1;
+}
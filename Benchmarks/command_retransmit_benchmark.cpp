@@ -0,0 +1,71 @@
+#include <SimulatorProcess.h>
+#include <TelloDrone.h>
+#include <iomanip>
+#include <iostream>
+
+// Runs blocking requests against simulators that lose a growing fraction of commands and responses, once
+// without retransmission (and a shortened ack_timeout, so the run does not take minutes) and once with the
+// default retransmit policy, and reports the request latency. The setter asserts its ack, so lost requests
+// without retransmission only pass in a Release build.
+
+static constexpr u16 SIMULATOR_BASE_PORT = 28900;
+static constexpr double COMMAND_LOSSES[] = { 0, 0.02, 0.10 };
+static constexpr usize REQUEST_COUNT = 100;
+static constexpr std::chrono::milliseconds NO_RETRANSMIT_ACK_TIMEOUT { 1000 };
+
+int main()
+{
+    std::vector<Tello::SimulatorConfig> simulator_configs;
+    for (usize i = 0; i < std::size(COMMAND_LOSSES); ++i) {
+        Tello::SimulatorConfig config;
+        config.cmd_port = SIMULATOR_BASE_PORT + i;
+        config.video_fps = 0;
+        config.command_loss = COMMAND_LOSSES[i];
+        simulator_configs.push_back(config);
+    }
+    auto simulator = Tello::SimulatorProcess::spawn(std::move(simulator_configs));
+    if (!simulator)
+        return 1;
+
+    bool success = true;
+    std::cout << std::setw(8) << "loss %" << std::setw(14) << "retransmit" << std::setw(12) << "p50 us"
+              << std::setw(12) << "p99 us" << std::setw(12) << "max us" << std::setw(13) << "retransmits"
+              << std::setw(10) << "timeouts" << std::setw(10) << "rto us" << std::endl;
+    for (usize i = 0; i < std::size(COMMAND_LOSSES); ++i) {
+        for (bool retransmit : { false, true }) {
+            Tello::DroneConfig config;
+            config.drone_ip = "127.0.0.1";
+            config.drone_cmd_port = SIMULATOR_BASE_PORT + i;
+            config.video_port = 0;
+            config.forward_video = false;
+            if (!retransmit) {
+                config.retransmit_policies[Tello::CommandID::SET_LOW_BATTERY_WARNING] = { 0 };
+                config.ack_timeout = NO_RETRANSMIT_ACK_TIMEOUT;
+            }
+            Tello::Drone drone(config);
+            drone.wait_until_connected();
+
+            Tello::LatencyHistogram latency_histogram;
+            for (usize request = 0; request < REQUEST_COUNT; ++request) {
+                auto start = std::chrono::steady_clock::now();
+                drone.set_low_battery_warning(10);
+                latency_histogram.record(std::chrono::steady_clock::now() - start);
+            }
+
+            auto latency = latency_histogram.summary();
+            auto requests = drone.get_request_statistics();
+            auto round_trip = drone.get_round_trip_statistics();
+            auto us = [](std::chrono::nanoseconds duration) { return std::chrono::duration<double, std::micro>(duration).count(); };
+            std::cout << std::setw(8) << std::fixed << std::setprecision(0) << COMMAND_LOSSES[i] * 100 << std::setw(14)
+                      << (retransmit ? "on" : "off") << std::setprecision(1) << std::setw(12) << us(latency.p50)
+                      << std::setw(12) << us(latency.p99) << std::setw(12) << us(latency.max) << std::setw(13)
+                      << requests.retransmits << std::setw(10) << requests.timeouts << std::setw(10)
+                      << us(round_trip.retransmit_timeout) << std::endl;
+            if (retransmit)
+                success &= requests.timeouts == 0;
+        }
+    }
+
+    simulator->stop();
+    return success ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+#include <DronePacket.h>
+#include <Utils/Types.h>
+#include <Utils/CRCHelpers.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Verifies the sliced CRC16 bit-exact against the byte-at-a-time reference, then compares their
+// throughput across the packet sizes seen on the cmd channel.
+
+static constexpr usize PACKET_SIZES[] = { 3, 11, 20, 64, 213, 1024, 4096 };
+static constexpr usize BYTES_PER_SIZE = 64 * 1024 * 1024;
+
+template<typename Callback>
+static double nanoseconds_per_call(usize iterations, Callback callback)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (usize i = 0; i < iterations; ++i)
+        callback();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+static bool verify()
+{
+    std::mt19937 random;
+    std::vector<u8> bytes(4096 + 16);
+    for (auto& byte : bytes)
+        byte = random();
+
+    for (usize length = 0; length <= 4096; ++length) {
+        for (usize offset = 0; offset < 8; ++offset) {
+            u16 seed = random();
+            std::span<const u8> span(bytes.data() + offset, length);
+            if (crc16_update(seed, span) != crc16_update_bytewise(seed, span)) {
+                std::cerr << "CRC16 mismatch at length " << length << ", offset " << offset << std::endl;
+                return false;
+            }
+        }
+    }
+
+    Tello::DronePacketTemplate controls(96, Tello::CommandID::SET_CURRENT_FLIGHT_CONTROLS, 0, 11);
+    for (usize i = 0; i < 1000; ++i) {
+        Tello::PacketPayload payload(11);
+        for (usize j = 0; j < payload.size(); ++j)
+            payload[j] = controls.payload()[j] = random();
+        Tello::DronePacket packet(96, Tello::CommandID::SET_CURRENT_FLIGHT_CONTROLS, std::move(payload));
+        packet.seq_num = 0;
+        auto expected = packet.serialize();
+        auto actual = controls.finalize();
+        if (!std::equal(expected.begin(), expected.end(), actual.begin(), actual.end())) {
+            std::cerr << "Controls packet template does not match DronePacket::encode" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    if (!verify())
+        return 1;
+    std::cout << "Sliced CRC16 and packet template are bit-exact with the reference" << std::endl;
+
+    std::vector<u8> bytes(4096);
+    std::mt19937 random;
+    for (auto& byte : bytes)
+        byte = random();
+
+    std::cout << std::setw(8) << "bytes" << std::setw(16) << "bytewise ns" << std::setw(16) << "sliced ns"
+              << std::setw(16) << "bytewise MB/s" << std::setw(16) << "sliced MB/s" << std::endl;
+    volatile u16 sink = 0;
+    for (auto size : PACKET_SIZES) {
+        std::span<const u8> span(bytes.data(), size);
+        usize iterations = BYTES_PER_SIZE / size;
+        auto bytewise = nanoseconds_per_call(iterations, [&] { sink = crc16_update_bytewise(sink, span); });
+        auto sliced = nanoseconds_per_call(iterations, [&] { sink = crc16_update(sink, span); });
+        std::cout << std::setw(8) << size << std::fixed << std::setprecision(1) << std::setw(16) << bytewise
+                  << std::setw(16) << sliced << std::setw(16) << size * 1e3 / bytewise << std::setw(16)
+                  << size * 1e3 / sliced << std::endl;
+    }
+
+    u8 buffer[Tello::DronePacket::MAX_PACKET_LENGTH];
+    Tello::DronePacketTemplate controls(96, Tello::CommandID::SET_CURRENT_FLIGHT_CONTROLS, 0, 11);
+    auto encode = nanoseconds_per_call(1'000'000, [&] {
+        Tello::DronePacket packet(96, Tello::CommandID::SET_CURRENT_FLIGHT_CONTROLS, Tello::PacketPayload(11));
+        packet.seq_num = 0;
+        sink = packet.encode(buffer);
+    });
+    auto template_finalize = nanoseconds_per_call(1'000'000, [&] {
+        controls.payload()[0] = sink;
+        sink = controls.finalize().size();
+    });
+    std::cout << "controls packet: encode " << encode << " ns, template " << template_finalize << " ns" << std::endl;
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <SimulatorProcess.h>
+#include <TelloDrone.h>
+#include <iomanip>
+#include <iostream>
+
+// Loads the whole DroneInfo of a freshly connected drone, once through the blocking getters one after the
+// other and once through refresh_info, and reports how long it took. The simulator delays its responses like a
+// WIFI link would. It sends no flight data, so the drone never sends its initialization sequence, which would
+// fill in the info on its own.
+
+static constexpr u16 SIMULATOR_BASE_PORT = 29000;
+static constexpr double COMMAND_LOSSES[] = { 0, 0.05 };
+static constexpr std::chrono::milliseconds RESPONSE_DELAY { 5 };
+static constexpr usize ITERATIONS = 50;
+static constexpr std::chrono::seconds REFRESH_TIMEOUT { 5 };
+
+int main()
+{
+    std::vector<Tello::SimulatorConfig> simulator_configs;
+    for (usize i = 0; i < std::size(COMMAND_LOSSES); ++i) {
+        Tello::SimulatorConfig config;
+        config.cmd_port = SIMULATOR_BASE_PORT + i;
+        config.flight_data_rate_hz = 0;
+        config.log_data_rate_hz = 0;
+        config.wifi_state_rate_hz = 0;
+        config.video_fps = 0;
+        config.command_loss = COMMAND_LOSSES[i];
+        config.response_delay = RESPONSE_DELAY;
+        simulator_configs.push_back(config);
+    }
+    auto simulator = Tello::SimulatorProcess::spawn(std::move(simulator_configs));
+    if (!simulator)
+        return 1;
+
+    bool success = true;
+    std::cout << std::setw(8) << "loss %" << std::setw(14) << "method" << std::setw(12) << "p50 ms" << std::setw(12)
+              << "p99 ms" << std::setw(12) << "max ms" << std::setw(12) << "complete" << std::endl;
+    for (usize i = 0; i < std::size(COMMAND_LOSSES); ++i) {
+        for (bool pipelined : { false, true }) {
+            Tello::LatencyHistogram latency_histogram;
+            usize complete = 0;
+            for (usize iteration = 0; iteration < ITERATIONS; ++iteration) {
+                Tello::DroneConfig config;
+                config.drone_ip = "127.0.0.1";
+                config.drone_cmd_port = SIMULATOR_BASE_PORT + i;
+                config.video_port = 0;
+                config.forward_video = false;
+                Tello::Drone drone(config);
+                // Gives the connection request time to reach the simulator
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+                auto start = std::chrono::steady_clock::now();
+                if (pipelined) {
+                    complete += drone.refresh_info(start + REFRESH_TIMEOUT).is_complete();
+                } else {
+                    (void)drone.get_ssid();
+                    (void)drone.get_firmware_version();
+                    (void)drone.get_loader_version();
+                    (void)drone.get_bitrate();
+                    (void)drone.get_flight_height_limit();
+                    (void)drone.get_low_battery_warning();
+                    (void)drone.get_attitude_angle();
+                    (void)drone.get_country_code();
+                    (void)drone.get_unique_identifier();
+                    (void)drone.get_activation_status();
+                    complete++;
+                }
+                latency_histogram.record(std::chrono::steady_clock::now() - start);
+            }
+
+            auto latency = latency_histogram.summary();
+            auto ms = [](std::chrono::nanoseconds duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+            std::cout << std::setw(8) << std::fixed << std::setprecision(0) << COMMAND_LOSSES[i] * 100 << std::setw(14)
+                      << (pipelined ? "refresh_info" : "getters") << std::setprecision(1) << std::setw(12)
+                      << ms(latency.p50) << std::setw(12) << ms(latency.p99) << std::setw(12) << ms(latency.max)
+                      << std::setw(12) << complete << std::endl;
+            success &= complete == ITERATIONS;
+        }
+    }
+
+    simulator->stop();
+    return success ? 0 : 1;
+}
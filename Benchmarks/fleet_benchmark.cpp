@@ -0,0 +1,138 @@
+#include <Fleet.h>
+#include <SimulatorProcess.h>
+#include <TelloDrone.h>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sys/resource.h>
+
+// Compares the CPU cost per drone of the thread-per-socket model against the Fleet reactor.
+// The simulated drones run in a child process so that only the library's CPU time is measured.
+
+static constexpr u16 SIMULATOR_BASE_PORT = 28000;
+
+struct Options {
+    usize drone_count { 12 };
+    usize worker_count { 1 };
+    u32 seconds { 5 };
+    u32 video_fps { 30 };
+};
+
+struct Measurement {
+    double cpu_seconds;
+    long context_switches;
+};
+
+static Measurement measure_usage()
+{
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    auto to_seconds = [](timeval time) { return time.tv_sec + time.tv_usec / 1e6; };
+    return { to_seconds(usage.ru_utime) + to_seconds(usage.ru_stime), usage.ru_nvcsw + usage.ru_nivcsw };
+}
+
+static Tello::DroneConfig drone_config(usize index)
+{
+    Tello::DroneConfig config;
+    config.drone_ip = "127.0.0.1";
+    config.drone_cmd_port = SIMULATOR_BASE_PORT + index;
+    config.video_port = 0;
+    config.video_forward_port = SIMULATOR_BASE_PORT + 1000 + index;
+    return config;
+}
+
+static bool wait_until_all_connected(const std::vector<Tello::Drone*>& drones)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (auto* drone : drones) {
+        while (!drone->is_connected()) {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    // Let the initialization sequence settle before measuring steady state
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    return true;
+}
+
+static void report(char const* model, const Options& options, Measurement start, Measurement end)
+{
+    auto cpu_ms_per_second = (end.cpu_seconds - start.cpu_seconds) * 1000 / options.seconds;
+    auto switches_per_second = static_cast<double>(end.context_switches - start.context_switches) / options.seconds;
+    std::cout << model << ": " << cpu_ms_per_second << " ms CPU/s total, "
+              << cpu_ms_per_second / options.drone_count << " ms CPU/s per drone, "
+              << switches_per_second << " context switches/s" << std::endl;
+}
+
+static bool run_threads(const Options& options)
+{
+    std::vector<std::unique_ptr<Tello::Drone>> drones;
+    std::vector<Tello::Drone*> drone_pointers;
+    for (usize i = 0; i < options.drone_count; ++i) {
+        drones.push_back(std::make_unique<Tello::Drone>(drone_config(i)));
+        drone_pointers.push_back(drones.back().get());
+    }
+    if (!wait_until_all_connected(drone_pointers))
+        return false;
+
+    auto start = measure_usage();
+    std::this_thread::sleep_for(std::chrono::seconds(options.seconds));
+    report("threads", options, start, measure_usage());
+    return true;
+}
+
+static bool run_fleet(const Options& options)
+{
+    Tello::Fleet fleet({ options.worker_count });
+    std::vector<Tello::Drone*> drone_pointers;
+    for (usize i = 0; i < options.drone_count; ++i) {
+        auto* drone = fleet.add_drone(drone_config(i));
+        if (drone == nullptr)
+            return false;
+        drone_pointers.push_back(drone);
+    }
+    if (!wait_until_all_connected(drone_pointers))
+        return false;
+
+    auto start = measure_usage();
+    std::this_thread::sleep_for(std::chrono::seconds(options.seconds));
+    report("fleet", options, start, measure_usage());
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--drones") == 0)
+            options.drone_count = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--workers") == 0)
+            options.worker_count = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seconds") == 0)
+            options.seconds = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--fps") == 0)
+            options.video_fps = atoi(argv[i + 1]);
+    }
+
+    std::vector<Tello::SimulatorConfig> simulator_configs;
+    for (usize i = 0; i < options.drone_count; ++i) {
+        Tello::SimulatorConfig config;
+        config.cmd_port = SIMULATOR_BASE_PORT + i;
+        config.video_fps = options.video_fps;
+        simulator_configs.push_back(config);
+    }
+    auto simulator = Tello::SimulatorProcess::spawn(std::move(simulator_configs));
+    if (!simulator)
+        return 1;
+
+    std::cout << options.drone_count << " drones, " << options.worker_count << " fleet workers, "
+              << options.video_fps << " fps video, " << options.seconds << "s per model" << std::endl;
+    bool success = run_threads(options) && run_fleet(options);
+    if (!success)
+        std::cerr << "Drones failed to connect to the simulator" << std::endl;
+
+    simulator->stop();
+    return success ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include <VideoFrameQueue.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Pushes frames through a VideoFrameQueue for each policy, once with a consumer that keeps up and once
+// with one that takes 5ms per frame, and reports what the producer (the video receive thread) pays per
+// push along with the time frames spend queued.
+
+static constexpr usize FAST_FRAME_COUNT = 1'000'000;
+static constexpr usize SLOW_FRAME_COUNT = 400;
+static constexpr std::chrono::microseconds SLOW_PRODUCER_INTERVAL { 1000 };
+static constexpr std::chrono::milliseconds SLOW_CONSUMER_WORK { 5 };
+
+struct Result {
+    double push_ns_average;
+    double push_ns_max;
+    double residency_us_average;
+    u64 popped;
+    u64 dropped;
+};
+
+static Result run(Tello::FrameQueuePolicy policy, bool slow_consumer)
+{
+    auto pool = Tello::FramePool::create({ .buffer_count = 32, .initial_buffer_capacity = 1024 });
+    Tello::VideoFrameQueue queue(8, policy);
+    auto frame_count = slow_consumer ? SLOW_FRAME_COUNT : FAST_FRAME_COUNT;
+
+    std::chrono::nanoseconds residency {};
+    std::thread consumer([&] {
+        while (auto frame = queue.pop()) {
+            residency += frame->queue_residency;
+            if (slow_consumer)
+                std::this_thread::sleep_for(SLOW_CONSUMER_WORK);
+        }
+    });
+
+    std::chrono::nanoseconds push_total {};
+    std::chrono::nanoseconds push_max {};
+    for (usize i = 0; i < frame_count; ++i) {
+        auto frame = pool->acquire();
+        while (!frame) {
+            std::this_thread::yield();
+            frame = pool->acquire();
+        }
+        pool->finish(frame, i & 255, 1024, {});
+
+        auto start = std::chrono::steady_clock::now();
+        queue.push(std::move(frame));
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        push_total += elapsed;
+        push_max = std::max(push_max, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed));
+        if (slow_consumer)
+            std::this_thread::sleep_for(SLOW_PRODUCER_INTERVAL);
+    }
+
+    // Lets the consumer drain what is left before closing
+    while (queue.get_statistics().frames_popped + queue.get_statistics().frames_dropped < frame_count)
+        std::this_thread::yield();
+    queue.close();
+    consumer.join();
+
+    auto statistics = queue.get_statistics();
+    return { static_cast<double>(push_total.count()) / frame_count, static_cast<double>(push_max.count()),
+        std::chrono::duration<double, std::micro>(residency).count() / std::max<u64>(statistics.frames_popped, 1),
+        statistics.frames_popped, statistics.frames_dropped };
+}
+
+int main()
+{
+    std::pair<char const*, Tello::FrameQueuePolicy> policies[] = {
+        { "block", Tello::FrameQueuePolicy::Block },
+        { "drop oldest", Tello::FrameQueuePolicy::DropOldest },
+        { "latest only", Tello::FrameQueuePolicy::LatestOnly },
+    };
+
+    std::cout << std::setw(12) << "policy" << std::setw(10) << "consumer" << std::setw(14) << "push avg ns"
+              << std::setw(14) << "push max ns" << std::setw(16) << "residency us" << std::setw(10) << "popped"
+              << std::setw(10) << "dropped" << std::endl;
+    for (auto [name, policy] : policies) {
+        for (bool slow_consumer : { false, true }) {
+            auto result = run(policy, slow_consumer);
+            std::cout << std::setw(12) << name << std::setw(10) << (slow_consumer ? "slow" : "fast") << std::fixed
+                      << std::setprecision(1) << std::setw(14) << result.push_ns_average << std::setw(14)
+                      << result.push_ns_max << std::setw(16) << result.residency_us_average << std::setw(10)
+                      << result.popped << std::setw(10) << result.dropped << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include <DronePacket.h>
+#include <SimulatorProcess.h>
+#include <TelloDrone.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+// Counts heap allocations on the steady-state packet paths and fails if there are any:
+// encoding controls/acks into stack buffers, parsing short packets, and a connected drone's
+// control, ack and video traffic against the simulator (with log streaming disabled).
+
+static std::atomic<bool> s_counting { false };
+static std::atomic<u64> s_allocations { 0 };
+
+void* operator new(std::size_t size)
+{
+    if (s_counting.load(std::memory_order_relaxed))
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = malloc(size == 0 ? 1 : size))
+        return pointer;
+    abort();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    free(pointer);
+}
+
+static constexpr u16 SIMULATOR_PORT = 28500;
+static constexpr usize ITERATIONS = 100'000;
+
+template<typename Callback>
+static u64 count_allocations(Callback callback)
+{
+    s_allocations = 0;
+    s_counting = true;
+    callback();
+    s_counting = false;
+    return s_allocations;
+}
+
+static bool check(char const* name, u64 allocations)
+{
+    std::cout << name << ": " << allocations << " allocations" << std::endl;
+    return allocations == 0;
+}
+
+int main()
+{
+    bool success = true;
+
+    u8 buffer[Tello::DronePacket::MAX_PACKET_LENGTH];
+    // Reference point for the counter, serialize() returns a fresh vector per call
+    std::cout << "serialize flight controls (reference): " << count_allocations([&] {
+        for (usize i = 0; i < ITERATIONS; ++i) {
+            Tello::DronePacket packet(96, Tello::CommandID::SET_CURRENT_FLIGHT_CONTROLS, Tello::PacketPayload(11));
+            asm volatile("" : : "r"(packet.serialize().size()) : "memory");
+        }
+    }) << " allocations" << std::endl;
+
+    success &= check("encode flight controls", count_allocations([&] {
+        for (usize i = 0; i < ITERATIONS; ++i) {
+            Tello::PacketPayload controls(11);
+            controls[0] = i & 0xFF;
+            Tello::DronePacket packet(96, Tello::CommandID::SET_CURRENT_FLIGHT_CONTROLS, std::move(controls));
+            packet.seq_num = 0;
+            asm volatile("" : : "r"(packet.encode(buffer)) : "memory");
+        }
+    }));
+
+    success &= check("encode log header response", count_allocations([&] {
+        for (usize i = 0; i < ITERATIONS; ++i) {
+            Tello::DronePacket packet(80, Tello::CommandID::DRONE_LOG_HEADER, { 0x00, static_cast<u8>(i), 0x00 });
+            packet.seq_num = i;
+            asm volatile("" : : "r"(packet.encode(buffer)) : "memory");
+        }
+    }));
+
+    Tello::DronePacket flight_data(0, 80, Tello::CommandID::FLIGHT_DATA, Tello::PacketPayload(24));
+    auto flight_data_length = flight_data.encode(buffer);
+    success &= check("parse flight data", count_allocations([&] {
+        for (usize i = 0; i < ITERATIONS; ++i) {
+            auto packet = Tello::DronePacket::deserialize({ buffer, flight_data_length });
+            asm volatile("" : : "r"(packet.has_value()) : "memory");
+        }
+    }));
+
+    Tello::DronePacket log_data(0, 80, Tello::CommandID::DRONE_LOG_DATA, Tello::PacketPayload(213));
+    auto log_data_length = log_data.encode(buffer);
+    success &= check("parse log data view", count_allocations([&] {
+        for (usize i = 0; i < ITERATIONS; ++i) {
+            auto packet = Tello::DronePacketView::parse({ buffer, log_data_length });
+            asm volatile("" : : "r"(packet.has_value()) : "memory");
+        }
+    }));
+
+    Tello::SimulatorConfig simulator_config;
+    simulator_config.cmd_port = SIMULATOR_PORT;
+    simulator_config.log_data_rate_hz = 0;
+    auto simulator = Tello::SimulatorProcess::spawn(simulator_config);
+    if (!simulator)
+        return 1;
+
+    {
+        Tello::DroneConfig config;
+        config.drone_ip = "127.0.0.1";
+        config.drone_cmd_port = SIMULATOR_PORT;
+        config.video_port = 0;
+        Tello::Drone drone(config);
+        drone.wait_until_connected();
+        // Lets the frame pool grow its buffers to the largest access unit first
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        success &= check("connected drone over 2s", count_allocations([] {
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+        }));
+    }
+
+    simulator->stop();
+
+    if (!success)
+        std::cerr << "Steady-state packet paths allocated!" << std::endl;
+    return success ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#include <SimulatorProcess.h>
+#include <TelloDrone.h>
+#include <cstring>
+#include <iostream>
+#include <sys/resource.h>
+
+// Measures receive syscalls per datagram and CPU time for several recvmmsg() batch depths, with
+// the simulated drone (running in a child process) streaming high bitrate video.
+
+static constexpr u16 SIMULATOR_PORT = 28600;
+static constexpr usize BATCH_DEPTHS[] = { 1, 4, 16, 64 };
+
+static double cpu_seconds()
+{
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    auto to_seconds = [](timeval time) { return time.tv_sec + time.tv_usec / 1e6; };
+    return to_seconds(usage.ru_utime) + to_seconds(usage.ru_stime);
+}
+
+int main(int argc, char** argv)
+{
+    u32 seconds = 5;
+    Tello::SimulatorConfig simulator_config;
+    simulator_config.cmd_port = SIMULATOR_PORT;
+    simulator_config.video_fps = 60;
+    simulator_config.video_bitrate_kbps = 20000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--seconds") == 0)
+            seconds = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--fps") == 0)
+            simulator_config.video_fps = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--bitrate") == 0)
+            simulator_config.video_bitrate_kbps = atoi(argv[i + 1]);
+    }
+
+    auto simulator = Tello::SimulatorProcess::spawn(simulator_config);
+    if (!simulator)
+        return 1;
+
+    std::cout << simulator_config.video_fps << " fps, " << simulator_config.video_bitrate_kbps << " kbps video, "
+              << seconds << "s per batch depth" << std::endl;
+    for (auto depth : BATCH_DEPTHS) {
+        Tello::DroneConfig config;
+        config.drone_ip = "127.0.0.1";
+        config.drone_cmd_port = SIMULATOR_PORT;
+        config.video_port = 0;
+        config.receive_batch_depth = depth;
+        Tello::Drone drone(config);
+        drone.wait_until_connected();
+
+        auto video_start = drone.get_video_socket_statistics();
+        auto cmd_start = drone.get_cmd_socket_statistics();
+        auto cpu_start = cpu_seconds();
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        auto cpu = cpu_seconds() - cpu_start;
+        auto video_end = drone.get_video_socket_statistics();
+        auto cmd_end = drone.get_cmd_socket_statistics();
+
+        auto calls = (video_end.receive_calls - video_start.receive_calls) + (cmd_end.receive_calls - cmd_start.receive_calls);
+        auto datagrams = (video_end.datagrams_received - video_start.datagrams_received)
+            + (cmd_end.datagrams_received - cmd_start.datagrams_received);
+        std::cout << "depth " << depth << ": " << datagrams << " datagrams, " << calls << " receive calls, "
+                  << static_cast<double>(calls) / datagrams << " syscalls/datagram, "
+                  << cpu * 1000 / seconds << " ms CPU/s" << std::endl;
+    }
+
+    simulator->stop();
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <SimulatorProcess.h>
+#include <TelloDrone.h>
+#include <iomanip>
+#include <iostream>
+#include <sys/resource.h>
+#include <vector>
+
+// Runs blocking requests from a growing number of threads against the simulator, which also streams flight
+// data at a high rate, and reports the request rate, round trip latency and the context switches per request.
+
+static constexpr u16 SIMULATOR_PORT = 28800;
+static constexpr usize THREAD_COUNTS[] = { 1, 4, 16, 64 };
+static constexpr std::chrono::seconds DURATION { 2 };
+
+static long context_switches()
+{
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+int main()
+{
+    Tello::SimulatorConfig simulator_config;
+    simulator_config.cmd_port = SIMULATOR_PORT;
+    simulator_config.flight_data_rate_hz = 1000;
+    simulator_config.video_fps = 0;
+    auto simulator = Tello::SimulatorProcess::spawn(simulator_config);
+    if (!simulator)
+        return 1;
+
+    bool success = true;
+    {
+        Tello::DroneConfig config;
+        config.drone_ip = "127.0.0.1";
+        config.drone_cmd_port = SIMULATOR_PORT;
+        config.video_port = 0;
+        config.forward_video = false;
+        Tello::Drone drone(config);
+        drone.wait_until_connected();
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        std::cout << std::setw(8) << "threads" << std::setw(14) << "requests/s" << std::setw(12) << "p50 us"
+                  << std::setw(12) << "p99 us" << std::setw(12) << "max us" << std::setw(16) << "switches/req"
+                  << std::setw(10) << "timeouts" << std::endl;
+        for (auto thread_count : THREAD_COUNTS) {
+            Tello::LatencyHistogram latency_histograms[64];
+            std::atomic<bool> stop { false };
+            auto timeouts_before = drone.get_request_statistics().timeouts;
+            auto switches_before = context_switches();
+
+            std::vector<std::thread> threads;
+            for (usize i = 0; i < thread_count; ++i) {
+                threads.emplace_back([&, i] {
+                    while (!stop) {
+                        auto start = std::chrono::steady_clock::now();
+                        drone.set_low_battery_warning(10);
+                        latency_histograms[i].record(std::chrono::steady_clock::now() - start);
+                    }
+                });
+            }
+            std::this_thread::sleep_for(DURATION);
+            stop = true;
+            for (auto& thread : threads)
+                thread.join();
+
+            Tello::LatencySummary worst;
+            u64 requests = 0;
+            std::chrono::nanoseconds p50_sum {};
+            for (usize i = 0; i < thread_count; ++i) {
+                auto summary = latency_histograms[i].summary();
+                requests += summary.count;
+                p50_sum += summary.p50;
+                worst.p99 = std::max(worst.p99, summary.p99);
+                worst.max = std::max(worst.max, summary.max);
+            }
+            auto timeouts = drone.get_request_statistics().timeouts - timeouts_before;
+            auto us = [](std::chrono::nanoseconds duration) { return std::chrono::duration<double, std::micro>(duration).count(); };
+            std::cout << std::setw(8) << thread_count << std::fixed << std::setprecision(0) << std::setw(14)
+                      << requests / std::chrono::duration<double>(DURATION).count() << std::setprecision(1)
+                      << std::setw(12) << us(p50_sum / thread_count) << std::setw(12) << us(worst.p99) << std::setw(12)
+                      << us(worst.max) << std::setw(16)
+                      << static_cast<double>(context_switches() - switches_before) / std::max<u64>(requests, 1)
+                      << std::setw(10) << timeouts << std::endl;
+            success &= timeouts == 0;
+        }
+    }
+
+    simulator->stop();
+    return success ? 0 : 1;
+}
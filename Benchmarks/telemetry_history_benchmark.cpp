@@ -0,0 +1,158 @@
+#include <DroneData.h>
+#include <TelemetryHistory.h>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Fills a flight data history with jittered 50 Hz samples and reports the cost of recording, of looking up a
+// time range (next to binary searching every kept sample), and of averaging the height over the last minute
+// copied out of the column compared to copying the samples out of a mutex protected deque of structs. The
+// looked up ranges are checked against the binary search, then once more while another thread keeps
+// recording.
+
+static constexpr usize CAPACITY = 16384;
+static constexpr std::chrono::milliseconds RESOLUTION { 50 };
+static constexpr std::chrono::milliseconds SAMPLE_PERIOD { 20 };
+static constexpr usize SAMPLE_COUNT = 1'000'000;
+static constexpr usize QUERY_COUNT = 100'000;
+static constexpr std::chrono::seconds ANALYTICS_WINDOW { 60 };
+
+using Clock = std::chrono::steady_clock;
+using History = Tello::TelemetryHistory<Tello::FlightDataColumn>;
+
+static double ns_per(Clock::duration duration, usize count)
+{
+    return std::chrono::duration<double, std::nano>(duration).count() / count;
+}
+
+int main()
+{
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<i64> jitter_us(-5000, 5000);
+    History history(CAPACITY, RESOLUTION);
+    std::mutex deque_mutex;
+    std::deque<Tello::TelemetrySnapshot<Tello::FlightData>> deque;
+
+    std::vector<Clock::time_point> timestamps(SAMPLE_COUNT);
+    auto origin = Clock::now();
+    for (usize i = 0; i < SAMPLE_COUNT; ++i)
+        timestamps[i] = origin + i * SAMPLE_PERIOD + std::chrono::microseconds(jitter_us(random));
+
+    auto start = Clock::now();
+    for (usize i = 0; i < SAMPLE_COUNT; ++i)
+        history.record(timestamps[i], { static_cast<float>(i % 100), 1, 2, 3, 50 });
+    auto record_time = Clock::now() - start;
+    for (usize i = SAMPLE_COUNT - CAPACITY; i < SAMPLE_COUNT; ++i) {
+        Tello::TelemetrySnapshot<Tello::FlightData> snapshot;
+        snapshot.data.height = static_cast<i16>(i % 100);
+        snapshot.version = i + 1;
+        snapshot.timestamp = timestamps[i];
+        deque.push_back(snapshot);
+    }
+
+    std::vector<i64> kept(CAPACITY);
+    if (!history.copy_timestamps(history.latest(CAPACITY), kept))
+        return 1;
+    auto newest = kept.back();
+    auto oldest = kept.front();
+    std::uniform_int_distribution<i64> query_time(oldest - 1'000'000'000, newest + 1'000'000'000);
+    std::vector<Clock::time_point> queries(QUERY_COUNT);
+    for (auto& query : queries)
+        query = Clock::time_point(std::chrono::nanoseconds(query_time(random)));
+
+    usize mismatches = 0;
+    for (auto query : queries) {
+        auto range = history.range(query, query + std::chrono::seconds(1));
+        auto from = std::chrono::duration_cast<std::chrono::nanoseconds>(query.time_since_epoch()).count();
+        auto expected = std::lower_bound(kept.begin(), kept.end(), from) - kept.begin();
+        mismatches += range.begin != SAMPLE_COUNT - CAPACITY + expected;
+    }
+
+    usize sink = 0;
+    start = Clock::now();
+    for (auto query : queries)
+        sink += history.range(query, query + std::chrono::seconds(1)).size();
+    auto range_time = Clock::now() - start;
+
+    start = Clock::now();
+    for (auto query : queries) {
+        auto from = std::chrono::duration_cast<std::chrono::nanoseconds>(query.time_since_epoch()).count();
+        auto to = from + 1'000'000'000;
+        sink += std::lower_bound(kept.begin(), kept.end(), to) - std::lower_bound(kept.begin(), kept.end(), from);
+    }
+    auto binary_search_time = Clock::now() - start;
+
+    double sum = 0;
+    auto analytics_start = Clock::time_point(std::chrono::nanoseconds(newest)) - ANALYTICS_WINDOW;
+    std::vector<float> heights(CAPACITY);
+    start = Clock::now();
+    for (usize i = 0; i < 1000; ++i) {
+        auto range = history.range(analytics_start, Clock::time_point::max());
+        std::span<float> range_heights(heights.data(), range.size());
+        if (!history.copy_column(Tello::FlightDataColumn::Height, range, range_heights))
+            return 1;
+        float total = 0;
+        for (auto height : range_heights)
+            total += height;
+        sum += total / range_heights.size();
+    }
+    auto column_time = Clock::now() - start;
+
+    start = Clock::now();
+    for (usize i = 0; i < 1000; ++i) {
+        std::vector<Tello::TelemetrySnapshot<Tello::FlightData>> copy;
+        {
+            std::lock_guard lock(deque_mutex);
+            auto first = std::lower_bound(deque.begin(), deque.end(), analytics_start,
+                [](auto& snapshot, auto time) { return snapshot.timestamp < time; });
+            copy.assign(first, deque.end());
+        }
+        float total = 0;
+        for (auto& snapshot : copy)
+            total += snapshot.data.height;
+        sum -= total / copy.size();
+    }
+    auto deque_time = Clock::now() - start;
+
+    // Another thread records while ranges are looked up, every copy has to come back sorted and within the
+    // range unless it reports that the range was overwritten meanwhile
+    std::atomic<bool> running { true };
+    std::thread writer([&] {
+        for (usize i = SAMPLE_COUNT; running.load(std::memory_order_relaxed); ++i)
+            history.record(origin + i * SAMPLE_PERIOD, { static_cast<float>(i % 100), 1, 2, 3, 50 });
+    });
+    usize concurrent_queries = 0;
+    usize concurrent_errors = 0;
+    auto concurrent_end = Clock::now() + std::chrono::seconds(1);
+    while (Clock::now() < concurrent_end) {
+        auto latest = history.latest(CAPACITY);
+        concurrent_queries++;
+        if (!history.copy_timestamps(latest, kept))
+            continue;
+        auto from = Clock::time_point(std::chrono::nanoseconds(kept[latest.size() / 2]));
+        auto range = history.range(from, from + std::chrono::seconds(10));
+        std::span<i64> range_stamps(kept.data(), range.size());
+        if (!history.copy_timestamps(range, range_stamps))
+            continue;
+        bool sorted = std::is_sorted(range_stamps.begin(), range_stamps.end());
+        bool within = range.empty() || range_stamps.front() >= from.time_since_epoch().count();
+        concurrent_errors += !sorted || !within;
+    }
+    running = false;
+    writer.join();
+
+    std::cout << std::fixed << std::setprecision(1) << "record: " << ns_per(record_time, SAMPLE_COUNT) << " ns/sample\n"
+              << "range lookup: " << ns_per(range_time, QUERY_COUNT) << " ns (binary search " << ns_per(binary_search_time, QUERY_COUNT)
+              << " ns), " << mismatches << " mismatches\n"
+              << "mean height over " << ANALYTICS_WINDOW.count() << " s: column " << ns_per(column_time, 1000) / 1000
+              << " us, copied deque " << ns_per(deque_time, 1000) / 1000 << " us\n"
+              << "concurrent lookups: " << concurrent_queries << ", " << concurrent_errors << " errors" << std::endl;
+    (void)sink;
+    return mismatches == 0 && concurrent_errors == 0 && std::abs(sum) < 1e-3 ? 0 : 1;
+}
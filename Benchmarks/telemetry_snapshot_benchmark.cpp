@@ -0,0 +1,112 @@
+#include <DroneData.h>
+#include <Utils/LatencyHistogram.h>
+#include <Utils/Seqlock.h>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One thread publishes IMU snapshots whose fields all carry the same counter while a growing number of threads
+// poll them, once through a Seqlock and once through a mutex. Reports the read rate, how long the writer took
+// per publish and how many reads came back torn (fields from different publishes).
+
+static constexpr usize READER_COUNTS[] = { 1, 4, 16 };
+static constexpr std::chrono::seconds DURATION { 1 };
+
+using Snapshot = Tello::TelemetrySnapshot<Tello::IMUData>;
+
+static Snapshot make_snapshot(u64 version)
+{
+    Snapshot snapshot;
+    auto value = static_cast<float>(version);
+    snapshot.data = { value, value, value, value, static_cast<i16>(version) };
+    snapshot.version = version;
+    return snapshot;
+}
+
+static bool is_torn(const Snapshot& snapshot)
+{
+    auto value = static_cast<float>(snapshot.version);
+    return snapshot.data.quaternion_w != value || snapshot.data.quaternion_x != value || snapshot.data.quaternion_y != value
+        || snapshot.data.quaternion_z != value || snapshot.data.temperature != static_cast<i16>(snapshot.version);
+}
+
+class MutexPublisher {
+public:
+    void store(const Snapshot& snapshot)
+    {
+        std::lock_guard lock(m_mutex);
+        m_snapshot = snapshot;
+    }
+    Snapshot load() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_snapshot;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    Snapshot m_snapshot;
+};
+
+template<typename Publisher>
+static bool run(const char* name, usize reader_count)
+{
+    Publisher publisher;
+    std::atomic<bool> running { true };
+    std::atomic<u64> reads { 0 };
+    std::atomic<u64> torn_reads { 0 };
+    Tello::LatencyHistogram store_histogram;
+
+    std::vector<std::thread> readers;
+    for (usize i = 0; i < reader_count; ++i) {
+        readers.emplace_back([&] {
+            u64 thread_reads = 0;
+            u64 thread_torn_reads = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                thread_torn_reads += is_torn(publisher.load());
+                thread_reads++;
+            }
+            reads += thread_reads;
+            torn_reads += thread_torn_reads;
+        });
+    }
+    std::thread writer([&] {
+        for (u64 version = 1; running.load(std::memory_order_relaxed); ++version) {
+            auto snapshot = make_snapshot(version);
+            auto start = std::chrono::steady_clock::now();
+            publisher.store(snapshot);
+            store_histogram.record(std::chrono::steady_clock::now() - start);
+        }
+    });
+
+    std::this_thread::sleep_for(DURATION);
+    running = false;
+    writer.join();
+    for (auto& reader : readers)
+        reader.join();
+
+    auto store_latency = store_histogram.summary();
+    auto us = [](std::chrono::nanoseconds duration) { return std::chrono::duration<double, std::micro>(duration).count(); };
+    std::cout << std::setw(10) << name << std::setw(10) << reader_count << std::setw(14) << std::fixed
+              << std::setprecision(2) << reads / std::chrono::duration<double>(DURATION).count() / 1e6 << std::setw(14)
+              << store_latency.count / std::chrono::duration<double>(DURATION).count() / 1e6 << std::setw(14)
+              << us(store_latency.p99) << std::setw(14) << us(store_latency.max) << std::setw(8) << torn_reads
+              << std::endl;
+    return torn_reads == 0;
+}
+
+int main()
+{
+    bool success = true;
+    std::cout << std::setw(10) << "publisher" << std::setw(10) << "readers" << std::setw(14) << "M reads/s"
+              << std::setw(14) << "M writes/s" << std::setw(14) << "write p99 us" << std::setw(14) << "write max us"
+              << std::setw(8) << "torn" << std::endl;
+    for (auto reader_count : READER_COUNTS) {
+        success &= run<Tello::Seqlock<Snapshot>>("seqlock", reader_count);
+        success &= run<MutexPublisher>("mutex", reader_count);
+    }
+    return success ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+#include <SimulatorProcess.h>
+#include <TelloDrone.h>
+#include <iomanip>
+#include <iostream>
+#include <time.h>
+
+// Follows the flight data the simulator streams at a control loop's rate, once by polling get_flight_data for
+// a new version and once by waiting on the flight data stream, and reports the samples seen and missed, how long
+// after arriving the consumer saw them and how much CPU the consumer thread burned doing so.
+
+static constexpr u16 SIMULATOR_PORT = 29200;
+static constexpr u32 FLIGHT_DATA_RATE_HZ = 200;
+static constexpr std::chrono::seconds DURATION { 2 };
+
+static std::chrono::nanoseconds thread_cpu_time()
+{
+    timespec time {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+}
+
+int main()
+{
+    Tello::SimulatorConfig simulator_config;
+    simulator_config.cmd_port = SIMULATOR_PORT;
+    simulator_config.flight_data_rate_hz = FLIGHT_DATA_RATE_HZ;
+    simulator_config.video_fps = 0;
+    auto simulator = Tello::SimulatorProcess::spawn(simulator_config);
+    if (!simulator)
+        return 1;
+
+    bool success = true;
+    {
+        Tello::DroneConfig config;
+        config.drone_ip = "127.0.0.1";
+        config.drone_cmd_port = SIMULATOR_PORT;
+        config.video_port = 0;
+        config.forward_video = false;
+        Tello::Drone drone(config);
+        drone.wait_until_connected();
+        // Lets the flight data stream settle after connecting before measuring
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+        std::cout << std::setw(8) << "method" << std::setw(10) << "samples" << std::setw(10) << "missed"
+                  << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(10) << "cpu %" << std::endl;
+        for (bool waiting : { false, true }) {
+            Tello::LatencyHistogram latency_histogram;
+            u64 samples = 0;
+            u64 missed = 0;
+            auto last = drone.get_flight_data();
+            auto start = std::chrono::steady_clock::now();
+            auto cpu_start = thread_cpu_time();
+            while (std::chrono::steady_clock::now() - start < DURATION) {
+                Tello::TelemetrySnapshot<Tello::FlightData> snapshot;
+                if (waiting) {
+                    auto next = drone.get_flight_data_stream().wait_for_next(last.version, start + DURATION);
+                    if (!next)
+                        break;
+                    snapshot = *next;
+                } else {
+                    snapshot = drone.get_flight_data();
+                    if (snapshot.version == last.version)
+                        continue;
+                }
+                latency_histogram.record(std::chrono::steady_clock::now() - snapshot.timestamp);
+                samples++;
+                missed += snapshot.version - last.version - 1;
+                last = snapshot;
+            }
+            auto cpu_time = thread_cpu_time() - cpu_start;
+
+            auto latency = latency_histogram.summary();
+            auto us = [](std::chrono::nanoseconds duration) { return std::chrono::duration<double, std::micro>(duration).count(); };
+            std::cout << std::setw(8) << (waiting ? "wait" : "poll") << std::setw(10) << samples << std::setw(10)
+                      << missed << std::fixed << std::setprecision(1) << std::setw(12) << us(latency.p50)
+                      << std::setw(12) << us(latency.p99) << std::setw(10)
+                      << 100.0 * cpu_time.count() / std::chrono::nanoseconds(DURATION).count() << std::endl;
+            success &= samples > 0;
+        }
+    }
+
+    simulator->stop();
+    return success ? 0 : 1;
+}
@@ -0,0 +1,56 @@
+#include <SimulatorProcess.h>
+#include <TelloDrone.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+// Streams video from the simulator over loopback for a few seconds and prints the latency of every stage
+// a frame goes through, from the kernel receiving its first segment to the frame reaching a subscriber.
+
+static constexpr u16 SIMULATOR_PORT = 28700;
+static constexpr std::chrono::seconds WARM_UP { 1 };
+static constexpr std::chrono::seconds DURATION { 5 };
+
+static void print(char const* stage, const Tello::LatencySummary& summary)
+{
+    auto us = [](std::chrono::nanoseconds duration) { return std::chrono::duration<double, std::micro>(duration).count(); };
+    std::cout << std::setw(18) << stage << std::setw(10) << summary.count << std::fixed << std::setprecision(1)
+              << std::setw(12) << us(summary.mean) << std::setw(12) << us(summary.p50) << std::setw(12)
+              << us(summary.p99) << std::setw(12) << us(summary.max) << std::endl;
+}
+
+int main()
+{
+    Tello::SimulatorConfig simulator_config;
+    simulator_config.cmd_port = SIMULATOR_PORT;
+    auto simulator = Tello::SimulatorProcess::spawn(simulator_config);
+    if (!simulator)
+        return 1;
+
+    {
+        Tello::DroneConfig config;
+        config.drone_ip = "127.0.0.1";
+        config.drone_cmd_port = SIMULATOR_PORT;
+        config.video_port = 0;
+        config.forward_video = false;
+        Tello::Drone drone(config);
+        drone.subscribe_video_frames([](const Tello::VideoFrame&) { });
+        drone.wait_until_connected();
+        std::this_thread::sleep_for(WARM_UP);
+        drone.reset_latency_statistics();
+        std::this_thread::sleep_for(DURATION);
+
+        auto video = drone.get_video_latency_statistics();
+        std::cout << std::setw(18) << "stage" << std::setw(10) << "count" << std::setw(12) << "mean us"
+                  << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(12) << "max us" << std::endl;
+        print("segment receive", video.segment_receive);
+        print("frame span", video.frame_span);
+        print("reassembly", video.reassembly);
+        print("delivery", video.delivery);
+        print("end to end", video.end_to_end);
+        print("cmd receive", drone.get_cmd_receive_latency());
+    }
+
+    simulator->stop();
+    return 0;
+}
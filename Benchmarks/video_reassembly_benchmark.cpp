@@ -0,0 +1,241 @@
+#include <FramePool.h>
+#include <VideoReassembler.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Feeds the same synthetic video stream, with datagrams reordered and lost at several rates, through the
+// windowed VideoReassembler and through a copy of the previous strict in-order logic, and compares how many
+// frames each of them delivers. Before that, checks that windows whose size does not divide 256 keep frames on
+// both sides of the 255 -> 0 wrap apart.
+
+static constexpr usize FRAME_COUNT = 20000;
+static constexpr usize SEGMENT_PAYLOAD_SIZE = 1458;
+static constexpr usize GOP_LENGTH = 30;
+static constexpr usize WINDOW_SIZES[] = { 1, 2, 4, 8 };
+
+struct Scenario {
+    char const* name;
+    // Chance for a datagram to be delayed, and by up to how many datagrams
+    double reorder_probability;
+    usize max_displacement;
+    double loss_probability;
+};
+
+static constexpr Scenario SCENARIOS[] = {
+    { "clean", 0, 0, 0 },
+    { "1% reordered by <= 4", 0.01, 4, 0 },
+    { "5% reordered by <= 8", 0.05, 8, 0 },
+    { "5% reordered by <= 32", 0.05, 32, 0 },
+    { "0.1% lost", 0, 0, 0.001 },
+    { "5% reordered, 0.1% lost", 0.05, 8, 0.001 },
+};
+
+using Datagram = std::vector<u8>;
+
+static std::vector<Datagram> generate_stream(std::mt19937& random)
+{
+    std::vector<Datagram> stream;
+    std::uniform_int_distribution<usize> p_frame_size(4000, 20000);
+    for (usize frame = 0; frame < FRAME_COUNT; ++frame) {
+        usize size = frame % GOP_LENGTH == 0 ? 60000 : p_frame_size(random);
+        usize segments = (size + SEGMENT_PAYLOAD_SIZE - 1) / SEGMENT_PAYLOAD_SIZE;
+        for (usize segment = 0; segment < segments; ++segment) {
+            auto payload_size = std::min(SEGMENT_PAYLOAD_SIZE, size - segment * SEGMENT_PAYLOAD_SIZE);
+            Datagram datagram(2 + payload_size, static_cast<u8>(frame));
+            datagram[0] = frame & 255;
+            datagram[1] = segment | (segment == segments - 1 ? 128 : 0);
+            stream.push_back(std::move(datagram));
+        }
+    }
+    return stream;
+}
+
+static std::vector<const Datagram*> network(const std::vector<Datagram>& stream, const Scenario& scenario, std::mt19937& random)
+{
+    std::uniform_real_distribution<double> chance(0, 1);
+    std::vector<std::pair<double, const Datagram*>> arrivals;
+    for (usize i = 0; i < stream.size(); ++i) {
+        if (chance(random) < scenario.loss_probability)
+            continue;
+        double arrival = i;
+        if (chance(random) < scenario.reorder_probability)
+            arrival += 1 + std::uniform_int_distribution<usize>(0, scenario.max_displacement - 1)(random) + 0.5;
+        arrivals.emplace_back(arrival, &stream[i]);
+    }
+    std::stable_sort(arrivals.begin(), arrivals.end(), [](auto& a, auto& b) { return a.first < b.first; });
+
+    std::vector<const Datagram*> received;
+    for (auto& arrival : arrivals)
+        received.push_back(arrival.second);
+    return received;
+}
+
+// The reassembly logic before the windowed reassembler: any gap in the segment numbers, or a frame number
+// change before the last segment, discards the frame
+class StrictReassembler {
+public:
+    usize frames_delivered { 0 };
+
+    void add_segment(std::span<const u8> packet_buffer)
+    {
+        int frame_num = packet_buffer[0];
+        isize segment_num = packet_buffer[1] & 127;
+        bool last_segment_in_frame = (packet_buffer[1] & 128) == 128;
+
+        if (frame_num != m_current_frame_num) {
+            m_current_frame_num = frame_num;
+            m_last_segment_num_received = segment_num - 1;
+            m_discard_current_frame = segment_num != 0;
+            m_current_frame.clear();
+        }
+        if (((m_last_segment_num_received + 1) & 127) != segment_num)
+            m_discard_current_frame = true;
+
+        m_last_segment_num_received = segment_num;
+        if (!m_discard_current_frame)
+            m_current_frame.insert(m_current_frame.end(), packet_buffer.begin() + 2, packet_buffer.end());
+
+        if (last_segment_in_frame) {
+            if (!m_discard_current_frame)
+                frames_delivered++;
+            m_current_frame.clear();
+            m_current_frame_num = (m_current_frame_num + 1) & 255;
+            m_last_segment_num_received = -1;
+            m_discard_current_frame = false;
+        }
+    }
+
+private:
+    std::vector<u8> m_current_frame;
+    int m_current_frame_num { 0 };
+    isize m_last_segment_num_received { -1 };
+    bool m_discard_current_frame { false };
+};
+
+// Frames 250 to 9 with two segments each, every frame's last segment arriving after the next frame's first one,
+// so two frames across the wrap are in flight at once. Every frame has to come out whole and with its own data.
+static bool check_window_wrap(usize window)
+{
+    static constexpr usize WRAP_FRAME_COUNT = 16;
+    static constexpr usize FIRST_FRAME = 250;
+    auto segment = [](usize frame, usize segment_num, bool last) {
+        Datagram datagram(2 + SEGMENT_PAYLOAD_SIZE, static_cast<u8>(frame));
+        datagram[0] = frame & 255;
+        datagram[1] = segment_num | (last ? 128 : 0);
+        return datagram;
+    };
+    std::vector<Datagram> received;
+    for (usize frame = FIRST_FRAME; frame < FIRST_FRAME + WRAP_FRAME_COUNT; ++frame) {
+        received.push_back(segment(frame, 0, false));
+        if (frame > FIRST_FRAME)
+            received.push_back(segment(frame - 1, 1, true));
+    }
+    received.push_back(segment(FIRST_FRAME + WRAP_FRAME_COUNT - 1, 1, true));
+
+    usize delivered = 0;
+    bool intact = true;
+    Tello::VideoReassembler reassembler(Tello::FramePool::create({}), window, [&](Tello::VideoFrame frame) {
+        u8 expected_frame_num = FIRST_FRAME + delivered++;
+        intact &= frame.frame_num() == expected_frame_num && frame.size() == 2 * SEGMENT_PAYLOAD_SIZE
+            && std::all_of(frame.data().begin(), frame.data().end(), [&](u8 byte) { return byte == expected_frame_num; });
+    });
+    for (auto& datagram : received)
+        reassembler.add_segment(datagram, {});
+    if (delivered == WRAP_FRAME_COUNT && intact)
+        return true;
+    std::cerr << "window " << window << ": " << delivered << " of " << WRAP_FRAME_COUNT
+              << " frames delivered across the frame number wrap" << (intact ? "" : ", some of them corrupted") << std::endl;
+    return false;
+}
+
+// A frame still open when the segment payload size changes holds segments laid out at the old size, so it
+// must be dropped rather than delivered. Frames sent entirely at the new size come through again.
+static bool check_payload_size_change()
+{
+    static constexpr usize NEW_PAYLOAD_SIZE = SEGMENT_PAYLOAD_SIZE - 100;
+    static constexpr usize LAST_PAYLOAD_SIZE = 50;
+    auto segment = [](u8 frame, u8 segment_num, bool last, usize payload_size) {
+        Datagram datagram(2 + payload_size, frame);
+        datagram[0] = frame;
+        datagram[1] = segment_num | (last ? 128 : 0);
+        return datagram;
+    };
+    std::vector<Datagram> received {
+        segment(1, 0, false, SEGMENT_PAYLOAD_SIZE),
+        segment(2, 0, false, NEW_PAYLOAD_SIZE),
+        segment(1, 1, true, LAST_PAYLOAD_SIZE),
+        segment(2, 1, true, LAST_PAYLOAD_SIZE),
+        segment(3, 0, false, NEW_PAYLOAD_SIZE),
+        segment(3, 1, true, LAST_PAYLOAD_SIZE),
+    };
+
+    bool intact = true;
+    bool resumed = false;
+    Tello::VideoReassembler reassembler(Tello::FramePool::create({}), 4, [&](Tello::VideoFrame frame) {
+        auto payload_size = frame.frame_num() == 1 ? SEGMENT_PAYLOAD_SIZE : NEW_PAYLOAD_SIZE;
+        intact &= frame.size() == payload_size + LAST_PAYLOAD_SIZE
+            && std::all_of(frame.data().begin(), frame.data().end(), [&](u8 byte) { return byte == frame.frame_num(); });
+        resumed |= frame.frame_num() == 3;
+    });
+    for (auto& datagram : received)
+        reassembler.add_segment(datagram, {});
+    if (intact && resumed)
+        return true;
+    std::cerr << "segment payload size change: "
+              << (intact ? "no frame delivered at the new size" : "corrupted frame delivered") << std::endl;
+    return false;
+}
+
+int main()
+{
+    bool wrap_ok = true;
+    for (usize window = 2; window <= 8; ++window)
+        wrap_ok &= check_window_wrap(window);
+    if (!wrap_ok || !check_payload_size_change())
+        return 1;
+
+    std::mt19937 random;
+    auto stream = generate_stream(random);
+    std::cout << FRAME_COUNT << " frames in " << stream.size() << " datagrams, delivered frames in %" << std::endl;
+
+    std::cout << std::setw(26) << "scenario" << std::setw(10) << "strict";
+    for (auto window : WINDOW_SIZES)
+        std::cout << std::setw(9) << "window " << window;
+    std::cout << std::setw(12) << "reordered" << std::endl;
+
+    for (auto& scenario : SCENARIOS) {
+        auto received = network(stream, scenario, random);
+        auto percent = [](usize frames) { return 100.0 * frames / FRAME_COUNT; };
+
+        StrictReassembler strict;
+        for (auto* datagram : received)
+            strict.add_segment(*datagram);
+        std::cout << std::setw(26) << scenario.name << std::fixed << std::setprecision(2) << std::setw(10)
+                  << percent(strict.frames_delivered);
+
+        Tello::VideoReassemblyStatistics statistics;
+        for (auto window : WINDOW_SIZES) {
+            usize delivered = 0;
+            Tello::VideoReassembler reassembler(Tello::FramePool::create({}), window, [&](Tello::VideoFrame) { delivered++; });
+            for (auto* datagram : received)
+                reassembler.add_segment(*datagram, {});
+            statistics = reassembler.get_statistics();
+            std::cout << std::setw(10) << percent(delivered);
+        }
+        std::cout << std::setw(12) << statistics.segments_reordered << std::endl;
+    }
+
+    usize delivered = 0;
+    Tello::VideoReassembler reassembler(Tello::FramePool::create({}), 4, [&](Tello::VideoFrame) { delivered++; });
+    auto start = std::chrono::steady_clock::now();
+    for (auto& datagram : stream)
+        reassembler.add_segment(datagram, {});
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "window 4, in order: " << elapsed / stream.size() << " ns/segment" << std::endl;
+    return delivered == FRAME_COUNT ? 0 : 1;
+}
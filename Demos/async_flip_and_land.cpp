@@ -0,0 +1,48 @@
+#include <TelloDrone.h>
+#include <iostream>
+
+// flip_and_land written as a coroutine: no thread is blocked while waiting for the acks and delays, so the
+// same thread could fly several of these missions at once (see Tello::when_all).
+static Tello::Task<bool> flip_and_land(Tello::Drone& drone)
+{
+    std::cout << "Taking off..." << std::endl;
+    bool took_off = co_await drone.take_off_async();
+    if (!took_off) {
+        std::cerr << "Failed taking off! Disconnecting..." << std::endl;
+        co_return false;
+    }
+    co_await drone.delay_async(std::chrono::seconds(3)); // Delay to let previous command finish
+    std::cout << "Flipping forwards..." << std::endl;
+    bool flipped_forwards = co_await drone.flip_async(Tello::FlipDirection::Forward);
+    if (!flipped_forwards) {
+        std::cerr << "Failed flipping forwards! Disconnecting..." << std::endl;
+        co_return false;
+    }
+    co_await drone.delay_async(std::chrono::seconds(3)); // Delay to let previous command finish
+    std::cout << "Flipping backwards..." << std::endl;
+    bool flipped_backwards = co_await drone.flip_async(Tello::FlipDirection::Backward);
+    if (!flipped_backwards) {
+        std::cerr << "Failed flipping backwards! Disconnecting..." << std::endl;
+        co_return false;
+    }
+    co_await drone.delay_async(std::chrono::seconds(3)); // Delay to let previous command finish
+    std::cout << "Landing..." << std::endl;
+    bool landed = co_await drone.land_async();
+    if (!landed) {
+        std::cerr << "Failed landing! Disconnecting..." << std::endl;
+        co_return false;
+    }
+    co_await drone.delay_async(std::chrono::seconds(5)); // Drone ACKs land packet immediately, wait for a couple of seconds of landing video
+    co_return true;
+}
+
+int main()
+{
+    Tello::Drone drone;
+    std::cout << "Connecting to the drone..." << std::endl;
+    drone.wait_until_connected();
+    std::cout << "Connected to the drone!" << std::endl;
+    bool success = Tello::sync_wait(flip_and_land(drone));
+    std::cout << "Disconnecting..." << std::endl;
+    return success ? 0 : 1;
+}
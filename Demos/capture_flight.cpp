@@ -0,0 +1,29 @@
+#include <TelloDrone.h>
+#include <iostream>
+
+// Captures 30 seconds of the raw cmd and video traffic to tello.cap in the working directory, for
+// replay_capture to play back without the drone
+
+int main()
+{
+    Tello::DroneConfig config;
+    config.forward_video = false;
+    Tello::Drone drone(config);
+
+    std::cout << "Connecting to the drone..." << std::endl;
+    drone.wait_until_connected();
+    auto capture = drone.start_capture("tello.cap");
+    if (!capture)
+        return 1;
+    std::cout << "Connected to the drone! Capturing for 30 seconds..." << std::endl;
+
+    for (int second = 0; second < 30; ++second) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        auto statistics = capture->get_statistics();
+        std::cout << statistics.records_written << " datagrams, " << statistics.bytes_written / 1024 << " KiB captured, "
+                  << statistics.records_dropped << " dropped" << std::endl;
+    }
+
+    drone.stop_capture();
+    std::cout << "Disconnecting..." << std::endl;
+}
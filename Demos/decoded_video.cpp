@@ -0,0 +1,50 @@
+#include <TelloDrone.h>
+#include <VideoDecoder.h>
+#include <iostream>
+
+// Will only be built if libavcodec is installed. Decodes the video in-process and prints what arrives, as a
+// starting point for vision code that wants raw pictures without an ffmpeg/OpenCV UDP listener in between.
+
+int main()
+{
+    Tello::DroneConfig config;
+    config.forward_video = false;
+    Tello::Drone drone(config);
+
+    std::atomic<u64> luma_sum { 0 };
+    std::atomic<u32> width { 0 };
+    std::atomic<u32> height { 0 };
+    auto decoder = Tello::VideoDecoder::create(
+        { .pixel_format = Tello::DecodedPixelFormat::YUV420P },
+        [&](const Tello::DecodedVideoFrame& frame) {
+            width = frame.width;
+            height = frame.height;
+            // The centre pixel, so the output visibly changes with the picture
+            luma_sum += frame.planes[0][frame.height / 2 * frame.strides[0] + frame.width / 2];
+        },
+        [&] { drone.request_keyframe_soon(); });
+    if (!decoder)
+        return 1;
+    auto subscription = drone.subscribe_video_frames([&](const Tello::VideoFrame& frame) { decoder->submit(frame); });
+
+    std::cout << "Connecting to the drone..." << std::endl;
+    drone.wait_until_connected();
+    std::cout << "Connected to the drone! Decoding video for 10 seconds..." << std::endl;
+
+    u64 frames_decoded = 0;
+    for (int second = 0; second < 10; ++second) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        auto statistics = decoder->get_statistics();
+        auto frames = statistics.frames_decoded - frames_decoded;
+        frames_decoded = statistics.frames_decoded;
+        std::cout << frames << " frames of " << width << "x" << height << ", average centre luma "
+                  << (frames ? luma_sum.exchange(0) / frames : 0) << ", decode time p50 "
+                  << statistics.decode_time.p50.count() / 1000 << "us p99 " << statistics.decode_time.p99.count() / 1000
+                  << "us, " << statistics.frames_dropped << " dropped, " << statistics.frames_skipped << " skipped"
+                  << std::endl;
+    }
+
+    drone.unsubscribe_video_frames(subscription);
+    decoder->close();
+    std::cout << "Disconnecting..." << std::endl;
+}
@@ -0,0 +1,29 @@
+#include <TelloDrone.h>
+#include <iostream>
+
+// Records 30 seconds of video to tello.mp4 in the working directory, without an ffmpeg process in between
+
+int main()
+{
+    Tello::DroneConfig config;
+    config.forward_video = false;
+    Tello::Drone drone(config);
+
+    std::cout << "Connecting to the drone..." << std::endl;
+    drone.wait_until_connected();
+    auto recorder = drone.start_recording({ .path = "tello.mp4", .format = Tello::VideoRecordingFormat::FragmentedMP4 });
+    if (!recorder)
+        return 1;
+    std::cout << "Connected to the drone! Recording for 30 seconds..." << std::endl;
+
+    for (int second = 0; second < 30; ++second) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        auto statistics = recorder->get_statistics();
+        std::cout << statistics.frames_written << " frames written, " << statistics.bytes_written / 1024 << " KiB in "
+                  << statistics.writes << " writes (p99 " << statistics.write_latency.p99.count() / 1000 << "us), "
+                  << statistics.frames_dropped << " dropped, " << statistics.frames_skipped << " skipped" << std::endl;
+    }
+
+    drone.stop_recording();
+    std::cout << "Disconnecting..." << std::endl;
+}
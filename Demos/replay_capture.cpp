@@ -0,0 +1,35 @@
+#include <PacketReplay.h>
+#include <cstdlib>
+#include <iostream>
+
+// Plays a capture (e.g. from capture_flight) back through the drone's receive paths and prints the telemetry
+// and video it carried. Usage: replay_capture [capture file] [speed, 0 for as fast as possible]
+
+int main(int argc, char** argv)
+{
+    std::string path = argc > 1 ? argv[1] : "tello.cap";
+    Tello::ReplayConfig replay_config;
+    if (argc > 2)
+        replay_config.speed = std::atof(argv[2]);
+
+    Tello::DroneConfig config;
+    config.forward_video = false;
+    auto replay = Tello::PacketReplay::open(path, config);
+    if (!replay)
+        return 1;
+
+    auto& drone = replay->drone();
+    drone.get_flight_data_stream().subscribe([](const Tello::TelemetrySnapshot<Tello::FlightData>& flight_data) {
+        if (flight_data.version % 10 == 1)
+            std::cout << "height " << flight_data.data.height << ", battery " << (int)flight_data.data.battery_percentage
+                      << "%" << std::endl;
+    });
+    usize frames = 0;
+    drone.subscribe_video_frames([&](const Tello::VideoFrame&) { frames++; });
+
+    auto statistics = replay->run(replay_config);
+    auto seconds = [](std::chrono::nanoseconds duration) { return std::chrono::duration<double>(duration).count(); };
+    std::cout << statistics.cmd_datagrams << " cmd and " << statistics.video_datagrams << " video datagrams, "
+              << frames << " video frames. " << seconds(statistics.capture_duration) << "s of capture replayed in "
+              << seconds(statistics.replay_duration) << "s" << std::endl;
+}
@@ -0,0 +1,50 @@
+#include <TelloDrone.h>
+#include <iostream>
+
+// Consumes video frames in-process the way a slow vision pipeline would: each frame takes 50ms to
+// "process", and a latest-frame-only queue makes sure the next one is always the freshest
+
+int main()
+{
+    Tello::DroneConfig config;
+    config.forward_video = false;
+    Tello::Drone drone(config);
+
+    auto queue = std::make_shared<Tello::VideoFrameQueue>(1, Tello::FrameQueuePolicy::LatestOnly);
+    drone.subscribe_video_frames(queue);
+
+    std::cout << "Connecting to the drone..." << std::endl;
+    drone.wait_until_connected();
+    std::cout << "Connected to the drone! Processing video frames for 10 seconds..." << std::endl;
+
+    auto end_time = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    auto report_time = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    usize frames = 0;
+    usize bytes = 0;
+    std::chrono::nanoseconds queue_residency {};
+    while (std::chrono::steady_clock::now() < end_time) {
+        auto queued_frame = queue->pop();
+        if (!queued_frame)
+            break;
+        frames++;
+        bytes += queued_frame->frame.size();
+        queue_residency += queued_frame->queue_residency;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        if (std::chrono::steady_clock::now() >= report_time) {
+            auto statistics = queue->get_statistics();
+            std::cout << frames << " frames processed, " << bytes * 8 / 1000 << " kbit, "
+                      << std::chrono::duration_cast<std::chrono::microseconds>(queue_residency / frames).count()
+                      << "us average time in queue, " << statistics.frames_dropped << " stale frames dropped so far"
+                      << std::endl;
+            frames = 0;
+            bytes = 0;
+            queue_residency = {};
+            report_time += std::chrono::seconds(1);
+        }
+    }
+
+    auto statistics = drone.get_video_reassembly_statistics();
+    std::cout << statistics.frames_completed << " frames completed, " << statistics.frames_lost << " lost, "
+              << statistics.segments_reordered << " segments reordered. Disconnecting..." << std::endl;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Retransmission.h"
+#include "Utils/Types.h"
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+namespace Tello {
+
+struct DroneConfig {
+    // The drone acts as the router, so by default it is always at the same address
+    std::string drone_ip { "192.168.10.1" };
+    u16 drone_cmd_port { 8889 };
+
+    // Local address and network interface (SO_BINDTODEVICE) both sockets are bound to, so several
+    // drones can be driven from separate adapters. An empty interface means any interface.
+    std::string bind_ip { "0.0.0.0" };
+    std::string bind_interface {};
+    // Announced to the drone in the connection request, 0 lets the OS pick a free port
+    u16 video_port { 7777 };
+
+    // Completed H264 frames are forwarded here, e.g. to ffplay/ffmpeg. In-process consumers can subscribe to
+    // the frames directly instead (Drone::subscribe_video_frames) and turn the forwarding off.
+    bool forward_video { true };
+    std::string video_forward_ip { "127.0.0.1" };
+    u16 video_forward_port { 9999 };
+
+    // Frames are reassembled into a fixed pool of buffers, which grow to the largest frame seen so far.
+    // Frames larger than the limit are dropped. The pool has to cover the reassembly window as well as every
+    // frame held in subscriber queues.
+    usize video_frame_pool_size { 16 };
+    usize max_video_frame_size { 256 * 1024 };
+    // Frames that may be in flight at once. Segments are accepted in any order within the window, and a frame
+    // only counts as lost once the window moves past it. 1 drops a frame as soon as the next one starts.
+    usize video_reassembly_window { 4 };
+
+    // Datagrams taken per recvmmsg() call on each socket, 1 makes one syscall per datagram
+    usize receive_batch_depth { 16 };
+    // Kernel receive timestamps (SO_TIMESTAMPNS) for the latency statistics, otherwise datagrams are
+    // timestamped when they are taken off the socket
+    bool receive_timestamps { true };
+
+    // Samples of flight, MVO and IMU data kept for Drone::get_*_history, per stream, 0 keeps none. Time lookups
+    // are O(1) over the last telemetry_history_capacity resolutions (about 13 minutes by default).
+    usize telemetry_history_capacity { 16384 };
+    std::chrono::milliseconds telemetry_history_resolution { 50 };
+
+    std::chrono::milliseconds receive_timeout { 1000 };
+    // Longest a blocking request waits for its response, retransmits included
+    std::chrono::milliseconds ack_timeout { 10000 };
+    // Requests are resent when their response takes longer than the retransmit timeout, which follows the
+    // measured round trip time within these bounds. The policy of commands missing from the map is
+    // default_retransmit_policy().
+    std::unordered_map<CommandID, RetransmitPolicy> retransmit_policies {};
+    std::chrono::milliseconds initial_retransmit_timeout { 500 };
+    std::chrono::milliseconds min_retransmit_timeout { 20 };
+    std::chrono::milliseconds max_retransmit_timeout { 2000 };
+    // Has to be positive, a drone with a zero tick is never initialized. The intervals below are rounded down
+    // to whole ticks, but are at least one tick.
+    std::chrono::milliseconds control_tick { 20 };
+    std::chrono::milliseconds timed_request_interval { 1000 };
+
+    // Keyframes (SPS/PPS and an IDR frame) are requested while a lost reference frame keeps the video from
+    // being decoded, at most once per interval, and when no video arrived for a whole timed_request_interval.
+    // Periodic requests make the drone send a keyframe every timed_request_interval regardless, at the cost of
+    // bitrate.
+    std::chrono::milliseconds keyframe_request_interval { 200 };
+    bool periodic_keyframe_requests { false };
+};
+
+}
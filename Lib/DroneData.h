@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <string>
 #include <optional>
@@ -33,6 +34,48 @@ struct DroneInfo {
     u8 wifi_disturb { 0 };
 };
 
+// The DroneInfo fields Drone::refresh_info queries
+enum class DroneInfoField : u8 {
+    Ssid,
+    FirmwareVersion,
+    LoaderVersion,
+    Bitrate,
+    FlightHeightLimit,
+    LowBatteryWarning,
+    AttitudeAngle,
+    CountryCode,
+    UniqueIdentifier,
+    ActivationStatus,
+    Count,
+};
+
+enum class DroneInfoStatus : u8 {
+    // Known from before, not queried again
+    Cached,
+    Received,
+    // The drone answered with an error status
+    Failed,
+    TimedOut,
+    // Too many requests were in flight to wait for this one
+    NotSent,
+};
+
+struct DroneInfoSnapshot {
+    DroneInfo info;
+    std::array<DroneInfoStatus, static_cast<usize>(DroneInfoField::Count)> status {};
+
+    [[nodiscard]] DroneInfoStatus status_of(DroneInfoField field) const { return status[static_cast<usize>(field)]; }
+    // Every field has a value
+    [[nodiscard]] bool is_complete() const
+    {
+        for (auto field_status : status) {
+            if (field_status != DroneInfoStatus::Cached && field_status != DroneInfoStatus::Received)
+                return false;
+        }
+        return true;
+    }
+};
+
 struct FlightData {
     i16 height;
     i16 north_speed;
@@ -87,4 +130,20 @@ struct IMUData {
     i16 temperature;
 };
 
+// From the WIFI_STATE and LIGHT_STRENGTH packets, the drone sends them on its own
+struct SignalData {
+    u8 wifi_strength;
+    u8 wifi_disturb;
+    u8 light_strength;
+};
+
+// A consistent copy of the telemetry decoded from one packet. version counts the packets decoded so far, it is 0
+// (and data is zeroed) until the first one arrived.
+template<typename T>
+struct TelemetrySnapshot {
+    T data {};
+    u64 version { 0 };
+    std::chrono::steady_clock::time_point timestamp {};
+};
+
 }
@@ -1,5 +1,6 @@
 #include "DronePacket.h"
 #include "Utils/CRCHelpers.h"
+#include <cassert>
 #include <cstring>
 
 namespace Tello {
@@ -7,49 +8,73 @@ namespace Tello {
 static constexpr u8 PACKET_MAGIC = 0xCC;
 static constexpr usize MINIMUM_PACKET_LENGTH = 11;
 static constexpr usize PACKET_FOOTER_LENGTH = 2;
+static constexpr usize CONN_REQ_LENGTH = 11;
 
-std::vector<u8> DronePacket::serialize()
+usize DronePacket::encoded_size() const
 {
-    std::vector<u8> packet_bytes(MINIMUM_PACKET_LENGTH + data.size());
+    if (cmd_id == CommandID::CONN_REQ)
+        return CONN_REQ_LENGTH;
+    return MINIMUM_PACKET_LENGTH + data.size();
+}
+
+usize DronePacket::encode(std::span<u8> buffer) const
+{
+    usize packet_length = encoded_size();
+    if (buffer.size() < packet_length || packet_length > MAX_PACKET_LENGTH)
+        return 0;
+
     if (cmd_id == CommandID::CONN_REQ) {
-        const char* header = "conn_req:";
-        packet_bytes.assign(header, header + 9);
-        packet_bytes.push_back(data[0]);
-        packet_bytes.push_back(data[1]);
-        return packet_bytes;
+        if (data.size() < 2)
+            return 0;
+        memcpy(buffer.data(), "conn_req:", 9);
+        buffer[9] = data[0];
+        buffer[10] = data[1];
+        return packet_length;
     }
 
-    packet_bytes[0] = PACKET_MAGIC;
-    u16 packet_length = (MINIMUM_PACKET_LENGTH + data.size()) << 3;
-    packet_bytes[1] = packet_length & 0xFF;
-    packet_bytes[2] = packet_length >> 8;
-    packet_bytes[3] = fast_crc8({ packet_bytes.begin(), 3 });
-    packet_bytes[4] = packet_type;
-    packet_bytes[5] = static_cast<u16>(cmd_id) & 0xFF;
-    packet_bytes[6] = static_cast<u16>(cmd_id) >> 8;
-    packet_bytes[7] = seq_num & 0xFF;
-    packet_bytes[8] = seq_num >> 8;
+    buffer[0] = PACKET_MAGIC;
+    buffer[1] = (packet_length << 3) & 0xFF;
+    buffer[2] = (packet_length << 3) >> 8;
+    buffer[3] = fast_crc8(buffer.subspan(0, 3));
+    buffer[4] = packet_type;
+    buffer[5] = static_cast<u16>(cmd_id) & 0xFF;
+    buffer[6] = static_cast<u16>(cmd_id) >> 8;
+    buffer[7] = seq_num & 0xFF;
+    buffer[8] = seq_num >> 8;
 
     if (!data.empty())
-        std::copy(data.cbegin(), data.cend(), &packet_bytes[9]);
+        memcpy(&buffer[9], data.data(), data.size());
 
-    usize crc_off = MINIMUM_PACKET_LENGTH - PACKET_FOOTER_LENGTH + data.size();
-    u16 packet_crc = fast_crc16({ packet_bytes.begin(), crc_off });
-    packet_bytes[crc_off] = packet_crc & 0xFF;
-    packet_bytes[crc_off + 1] = packet_crc >> 8;
+    usize crc_off = packet_length - PACKET_FOOTER_LENGTH;
+    u16 packet_crc = fast_crc16(buffer.subspan(0, crc_off));
+    buffer[crc_off] = packet_crc & 0xFF;
+    buffer[crc_off + 1] = packet_crc >> 8;
 
+    return packet_length;
+}
+
+std::vector<u8> DronePacket::serialize() const
+{
+    std::vector<u8> packet_bytes(encoded_size());
+    packet_bytes.resize(encode(packet_bytes));
     return packet_bytes;
 }
 
-std::optional<DronePacket> DronePacket::deserialize(std::span<u8> packet_bytes)
+std::optional<DronePacket> DronePacket::deserialize(std::span<const u8> packet_bytes)
+{
+    auto packet = DronePacketView::parse(packet_bytes);
+    if (!packet.has_value())
+        return {};
+    return packet->to_owned();
+}
+
+std::optional<DronePacketView> DronePacketView::parse(std::span<const u8> packet_bytes)
 {
     if (packet_bytes.size() < MINIMUM_PACKET_LENGTH)
         return {};
 
-    if (memcmp(packet_bytes.data(), "conn_ack:", 9) == 0) {
-        auto packet_data = std::vector<u8>(packet_bytes.begin() + 9, packet_bytes.end());
-        return DronePacket(0, 0, CommandID::CONN_ACK, std::move(packet_data));
-    }
+    if (memcmp(packet_bytes.data(), "conn_ack:", 9) == 0)
+        return DronePacketView { 0, CommandID::CONN_ACK, 0, packet_bytes.subspan(9) };
 
     if (packet_bytes[0] != PACKET_MAGIC)
         return {};
@@ -59,19 +84,71 @@ std::optional<DronePacket> DronePacket::deserialize(std::span<u8> packet_bytes)
     if (packet_bytes.size() < packet_length || packet_length < MINIMUM_PACKET_LENGTH)
         return {};
 
-    if (packet_bytes[3] != fast_crc8(std::span<u8>(packet_bytes).subspan(0, 3)))
+    if (packet_bytes[3] != fast_crc8(packet_bytes.subspan(0, 3)))
         return {};
 
     u16 packet_checksum = (static_cast<u16>(packet_bytes[packet_length - 1]) << 8) | packet_bytes[packet_length - 2];
-    if (packet_checksum != fast_crc16(std::span<u8>(packet_bytes).subspan(0, packet_length - 2)))
+    if (packet_checksum != fast_crc16(packet_bytes.subspan(0, packet_length - 2)))
         return {};
 
     u8 packet_type = packet_bytes[4];
     u16 cmd_id = (static_cast<u16>(packet_bytes[6]) << 8) | packet_bytes[5];
     u16 seq_num = (static_cast<u16>(packet_bytes[8]) << 8) | packet_bytes[7];
-    std::vector<u8> data(packet_bytes.begin() + 9, packet_bytes.begin() + 9 + data_length);
 
-    return DronePacket(seq_num, packet_type, static_cast<CommandID>(cmd_id), std::move(data));
+    return DronePacketView { packet_type, static_cast<CommandID>(cmd_id), seq_num, packet_bytes.subspan(9, data_length) };
+}
+
+std::span<const u8> LogRecordView::decrypt(std::span<u8> scratch) const
+{
+    assert(scratch.size() >= decrypted_length());
+    memcpy(scratch.data(), bytes.data(), HEADER_LENGTH);
+    // A word at a time, which the compiler turns into vector XORs
+    u64 word_key = xor_key * 0x0101010101010101ull;
+    usize end = decrypted_length();
+    usize i = HEADER_LENGTH;
+    for (; i + sizeof(u64) <= end; i += sizeof(u64)) {
+        u64 word;
+        memcpy(&word, bytes.data() + i, sizeof(word));
+        word ^= word_key;
+        memcpy(scratch.data() + i, &word, sizeof(word));
+    }
+    for (; i < end; ++i)
+        scratch[i] = bytes[i] ^ xor_key;
+    return scratch.subspan(0, end);
+}
+
+std::optional<LogRecordView> LogRecordIterator::next()
+{
+    if (m_remaining.size() < LogRecordView::HEADER_LENGTH + LogRecordView::CHECKSUM_LENGTH
+        || m_remaining[0] != LogRecordView::MAGIC)
+        return {};
+    usize record_length = (static_cast<u16>(m_remaining[2]) << 8) | m_remaining[1];
+    if (record_length < LogRecordView::HEADER_LENGTH + LogRecordView::CHECKSUM_LENGTH || record_length > m_remaining.size()) {
+        m_remaining = {};
+        return {};
+    }
+    u16 record_type = (static_cast<u16>(m_remaining[5]) << 8) | m_remaining[4];
+    LogRecordView record { static_cast<LogRecordType>(record_type), m_remaining[6], m_remaining.subspan(0, record_length) };
+    m_remaining = m_remaining.subspan(record_length);
+    return record;
+}
+
+DronePacketTemplate::DronePacketTemplate(u8 packet_type, CommandID cmd_id, u16 seq_num, usize payload_size)
+    : m_payload_size(std::min(payload_size, PacketPayload::INLINE_CAPACITY))
+{
+    DronePacket packet(packet_type, cmd_id, PacketPayload(m_payload_size));
+    packet.seq_num = seq_num;
+    packet.encode(m_bytes);
+    m_header_crc = crc16_update(CRC16_SEED, std::span<const u8>(m_bytes).subspan(0, PAYLOAD_OFFSET));
+}
+
+std::span<const u8> DronePacketTemplate::finalize()
+{
+    usize crc_off = PAYLOAD_OFFSET + m_payload_size;
+    u16 packet_crc = crc16_update(m_header_crc, payload());
+    m_bytes[crc_off] = packet_crc & 0xFF;
+    m_bytes[crc_off + 1] = packet_crc >> 8;
+    return { m_bytes.data(), crc_off + PACKET_FOOTER_LENGTH };
 }
 
 }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "PacketPayload.h"
 #include "Utils/Types.h"
+#include <array>
 #include <optional>
 #include <span>
 #include <utility>
@@ -88,13 +90,16 @@ enum class LogRecordType : u16 {
 };
 
 struct DronePacket {
+    // The packet length is stored in the upper 13 bits of a u16
+    static constexpr usize MAX_PACKET_LENGTH = 0xFFFF >> 3;
+
     PacketDirection direction;
     u8 packet_type;
     CommandID cmd_id;
     u16 seq_num;
-    std::vector<u8> data;
+    PacketPayload data;
 
-    DronePacket(u16 seq_num, u8 packet_type, CommandID cmd_id, std::vector<u8> data)
+    DronePacket(u16 seq_num, u8 packet_type, CommandID cmd_id, PacketPayload data)
         : seq_num(seq_num)
         , packet_type(packet_type)
         , cmd_id(cmd_id)
@@ -103,7 +108,7 @@ struct DronePacket {
     {
     }
 
-    DronePacket(u8 packet_type, CommandID cmd_id, std::vector<u8> data = {})
+    DronePacket(u8 packet_type, CommandID cmd_id, PacketPayload data = {})
         : seq_num(-1)
         , packet_type(packet_type)
         , cmd_id(cmd_id)
@@ -112,9 +117,80 @@ struct DronePacket {
     {
     }
 
-    std::vector<u8> serialize();
+    [[nodiscard]] usize encoded_size() const;
+    // Writes the serialized packet into `buffer` without allocating, returns the number of bytes
+    // written or 0 if the buffer is too small
+    usize encode(std::span<u8> buffer) const;
+    std::vector<u8> serialize() const;
+
+    static std::optional<DronePacket> deserialize(std::span<const u8> packet_bytes);
+};
+
+// Non-owning view of a received packet, only valid as long as the buffer it was parsed from
+struct DronePacketView {
+    u8 packet_type;
+    CommandID cmd_id;
+    u16 seq_num;
+    std::span<const u8> data;
+
+    // Validates the magic, length and both CRCs without copying the payload
+    static std::optional<DronePacketView> parse(std::span<const u8> packet_bytes);
+
+    [[nodiscard]] DronePacket to_owned() const
+    {
+        return DronePacket(seq_num, packet_type, cmd_id, PacketPayload(data));
+    }
+};
+
+// A record of the drone's flight log (DJI log format) inside a DRONE_LOG_DATA payload. Everything after the
+// header, up to the trailing CRC16, is XOR-ed with the low byte of the record's tick.
+struct LogRecordView {
+    static constexpr u8 MAGIC = 'U';
+    static constexpr usize HEADER_LENGTH = 10;
+    static constexpr usize CHECKSUM_LENGTH = 2;
+
+    LogRecordType type;
+    u8 xor_key;
+    // The whole record, header and checksum included
+    std::span<const u8> bytes;
+
+    [[nodiscard]] usize decrypted_length() const { return bytes.size() - CHECKSUM_LENGTH; }
+    // Undoes the XOR into `scratch`, which must be at least decrypted_length() long. The returned record stops
+    // before the checksum, offsets into it are the same as into `bytes`.
+    std::span<const u8> decrypt(std::span<u8> scratch) const;
+};
+
+// Walks the records of a log data payload in place, stopping at the first one that is malformed or truncated
+class LogRecordIterator {
+public:
+    explicit LogRecordIterator(std::span<const u8> records)
+        : m_remaining(records)
+    {
+    }
+
+    std::optional<LogRecordView> next();
+
+private:
+    std::span<const u8> m_remaining;
+};
+
+// A packet sent repeatedly with an unchanging header, such as the flight controls (whose sequence number
+// is always 0). The header and the CRC16 state after it are computed once, so each send only writes and
+// checksums the payload bytes.
+class DronePacketTemplate {
+public:
+    DronePacketTemplate(u8 packet_type, CommandID cmd_id, u16 seq_num, usize payload_size);
+
+    [[nodiscard]] std::span<u8> payload() { return { m_bytes.data() + PAYLOAD_OFFSET, m_payload_size }; }
+    // Checksums the current payload and returns the complete packet
+    std::span<const u8> finalize();
+
+private:
+    static constexpr usize PAYLOAD_OFFSET = 9;
 
-    static std::optional<DronePacket> deserialize(std::span<u8> packet_bytes);
+    std::array<u8, PacketPayload::INLINE_CAPACITY + 11> m_bytes {};
+    usize m_payload_size;
+    u16 m_header_crc;
 };
 
 }
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "Utils/Counter.h"
+#include "Utils/LatencyHistogram.h"
+#include "Utils/Types.h"
+#include <atomic>
+
+namespace Tello {
+
+struct SocketStatistics {
+    u64 receive_calls { 0 };
+    u64 datagrams_received { 0 };
+    u64 bytes_received { 0 };
+};
+
+// Counters are only ever bumped by the thread receiving on the socket, see increment_counter
+struct SocketCounters {
+    std::atomic<u64> receive_calls { 0 };
+    std::atomic<u64> datagrams_received { 0 };
+    std::atomic<u64> bytes_received { 0 };
+
+    void record_receive(u64 datagrams, u64 bytes)
+    {
+        increment_counter(receive_calls);
+        increment_counter(datagrams_received, datagrams);
+        increment_counter(bytes_received, bytes);
+    }
+
+    [[nodiscard]] SocketStatistics snapshot() const
+    {
+        return { receive_calls.load(std::memory_order_relaxed), datagrams_received.load(std::memory_order_relaxed),
+            bytes_received.load(std::memory_order_relaxed) };
+    }
+};
+
+struct VideoReassemblyStatistics {
+    u64 segments_received { 0 };
+    u64 segments_duplicate { 0 };
+    // Arrived after a segment that follows it in the stream
+    u64 segments_reordered { 0 };
+    // Arrived for a frame the window had already moved past
+    u64 segments_late { 0 };
+    u64 frames_completed { 0 };
+    // Still missing segments when the window moved past them (or never seen at all)
+    u64 frames_lost { 0 };
+    // Complete, but dropped because of the frame pool or an inconsistent segment layout
+    u64 frames_dropped { 0 };
+};
+
+// Written by the video receive path only, with the same scheme as SocketCounters
+struct VideoReassemblyCounters {
+    std::atomic<u64> segments_received { 0 };
+    std::atomic<u64> segments_duplicate { 0 };
+    std::atomic<u64> segments_reordered { 0 };
+    std::atomic<u64> segments_late { 0 };
+    std::atomic<u64> frames_completed { 0 };
+    std::atomic<u64> frames_lost { 0 };
+    std::atomic<u64> frames_dropped { 0 };
+
+    [[nodiscard]] VideoReassemblyStatistics snapshot() const
+    {
+        return { segments_received.load(std::memory_order_relaxed), segments_duplicate.load(std::memory_order_relaxed),
+            segments_reordered.load(std::memory_order_relaxed), segments_late.load(std::memory_order_relaxed),
+            frames_completed.load(std::memory_order_relaxed), frames_lost.load(std::memory_order_relaxed),
+            frames_dropped.load(std::memory_order_relaxed) };
+    }
+};
+
+struct VideoStreamStatistics {
+    u64 idr_frames_received { 0 };
+    // Pictures that arrived after a lost reference frame, each one costs a keyframe request
+    u64 reference_losses { 0 };
+    // Pictures not delivered because they depend on a lost reference frame
+    u64 frames_skipped_undecodable { 0 };
+    u64 keyframe_requests_sent { 0 };
+};
+
+struct VideoStreamCounters {
+    std::atomic<u64> idr_frames_received { 0 };
+    std::atomic<u64> reference_losses { 0 };
+    std::atomic<u64> frames_skipped_undecodable { 0 };
+    // Bumped by the control tick, everything else by the video receive path
+    std::atomic<u64> keyframe_requests_sent { 0 };
+
+    [[nodiscard]] VideoStreamStatistics snapshot() const
+    {
+        return { idr_frames_received.load(std::memory_order_relaxed), reference_losses.load(std::memory_order_relaxed),
+            frames_skipped_undecodable.load(std::memory_order_relaxed), keyframe_requests_sent.load(std::memory_order_relaxed) };
+    }
+};
+
+struct FrameQueueStatistics {
+    u64 frames_pushed { 0 };
+    // Taken off the queue by the producer to make room, with a dropping policy
+    u64 frames_dropped { 0 };
+    u64 frames_popped { 0 };
+};
+
+struct FramePoolStatistics {
+    u64 frames_dropped_pool_exhausted { 0 };
+    u64 frames_dropped_oversize { 0 };
+    usize max_observed_frame_size { 0 };
+    usize buffer_capacity { 0 };
+};
+
+struct VideoLatencyStatistics {
+    // Kernel receive timestamp to the datagram being processed, for every video segment
+    LatencySummary segment_receive;
+    // First to last segment of a frame to arrive
+    LatencySummary frame_span;
+    // Completing segment received to the frame being found complete
+    LatencySummary reassembly;
+    // Frame complete to it being handed to subscribers, including being held back behind older frames
+    LatencySummary delivery;
+    // First segment received to the frame being handed to subscribers
+    LatencySummary end_to_end;
+};
+
+// Recorded by the video receive path only
+struct VideoLatencyHistograms {
+    LatencyHistogram segment_receive;
+    LatencyHistogram frame_span;
+    LatencyHistogram reassembly;
+    LatencyHistogram delivery;
+    LatencyHistogram end_to_end;
+
+    [[nodiscard]] VideoLatencyStatistics snapshot() const
+    {
+        return { segment_receive.summary(), frame_span.summary(), reassembly.summary(), delivery.summary(),
+            end_to_end.summary() };
+    }
+
+    void reset()
+    {
+        segment_receive.reset();
+        frame_span.reset();
+        reassembly.reset();
+        delivery.reset();
+        end_to_end.reset();
+    }
+};
+
+struct VideoRecorderStatistics {
+    u64 frames_written { 0 };
+    // Dropped from the recorder's queue because the writer thread fell behind
+    u64 frames_dropped { 0 };
+    // Not written because the file was waiting for an IDR frame, at its start or after a drop
+    u64 frames_skipped { 0 };
+    u64 bytes_written { 0 };
+    u64 writes { 0 };
+    u64 write_errors { 0 };
+    // Time spent in each write() call
+    LatencySummary write_latency;
+};
+
+// Written by the recorder's writer thread only, with the same scheme as SocketCounters
+struct VideoRecorderCounters {
+    std::atomic<u64> frames_written { 0 };
+    std::atomic<u64> frames_skipped { 0 };
+    std::atomic<u64> bytes_written { 0 };
+    std::atomic<u64> writes { 0 };
+    std::atomic<u64> write_errors { 0 };
+    LatencyHistogram write_latency;
+
+    // `frames_dropped` is counted by the queue
+    [[nodiscard]] VideoRecorderStatistics snapshot(u64 frames_dropped) const
+    {
+        return { frames_written.load(std::memory_order_relaxed), frames_dropped, frames_skipped.load(std::memory_order_relaxed),
+            bytes_written.load(std::memory_order_relaxed), writes.load(std::memory_order_relaxed),
+            write_errors.load(std::memory_order_relaxed), write_latency.summary() };
+    }
+};
+
+struct VideoDecoderStatistics {
+    u64 frames_decoded { 0 };
+    // Dropped from the decoder's queue because decoding fell behind
+    u64 frames_dropped { 0 };
+    // Not decoded because the decoder was waiting for an IDR frame after a drop
+    u64 frames_skipped { 0 };
+    u64 decode_errors { 0 };
+    // From handing the access unit to the decoder to the picture (converted, if requested) being ready
+    LatencySummary decode_time;
+};
+
+// Written by the decode thread only, with the same scheme as SocketCounters
+struct VideoDecoderCounters {
+    std::atomic<u64> frames_decoded { 0 };
+    std::atomic<u64> frames_skipped { 0 };
+    std::atomic<u64> decode_errors { 0 };
+    LatencyHistogram decode_time;
+
+    // `frames_dropped` is counted by the queue
+    [[nodiscard]] VideoDecoderStatistics snapshot(u64 frames_dropped) const
+    {
+        return { frames_decoded.load(std::memory_order_relaxed), frames_dropped, frames_skipped.load(std::memory_order_relaxed),
+            decode_errors.load(std::memory_order_relaxed), decode_time.summary() };
+    }
+};
+
+struct PendingRequestStatistics {
+    u64 requests { 0 };
+    u64 responses { 0 };
+    u64 timeouts { 0 };
+    // Requests sent again after their retransmit timeout, see RetransmitPolicy
+    u64 retransmits { 0 };
+    // Requests sent without waiting for their response, because too many were in flight already
+    u64 table_full { 0 };
+};
+
+}
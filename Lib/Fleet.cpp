@@ -0,0 +1,183 @@
+#include "Fleet.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace Tello {
+
+static constexpr usize MAX_EPOLL_EVENTS = 64;
+// Upper bound on receive calls (each taking up to a batch of datagrams) per socket per wakeup, so a busy
+// video socket can't starve the rest of the shard
+static constexpr usize RECEIVE_BUDGET = 8;
+
+Fleet::Fleet(FleetConfig config)
+    : m_config(config)
+{
+    auto worker_count = std::max<usize>(m_config.worker_count, 1);
+    for (usize i = 0; i < worker_count; ++i) {
+        auto& worker = m_workers.emplace_back(std::make_unique<Worker>());
+        worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (worker->epoll_fd == -1) {
+            perror("epoll_create1()");
+            return;
+        }
+        worker->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (worker->wakeup_fd == -1) {
+            perror("eventfd()");
+            return;
+        }
+        if (!add_source(*worker, SourceKind::Wakeup, worker->wakeup_fd, nullptr))
+            return;
+    }
+
+    for (auto& worker : m_workers)
+        worker->thread = std::thread(&Fleet::worker_thread_routine, this, std::ref(*worker));
+    m_initialized = true;
+}
+
+Fleet::~Fleet()
+{
+    stop();
+    for (auto& worker : m_workers) {
+        for (auto& source : worker->sources) {
+            if (source->kind == SourceKind::ControlTimer)
+                ::close(source->fd);
+        }
+        if (worker->wakeup_fd != -1)
+            ::close(worker->wakeup_fd);
+        if (worker->epoll_fd != -1)
+            ::close(worker->epoll_fd);
+    }
+}
+
+void Fleet::stop()
+{
+    if (m_shutting_down.exchange(true))
+        return;
+
+    for (auto& worker : m_workers) {
+        u64 wakeup = 1;
+        if (worker->wakeup_fd != -1)
+            write(worker->wakeup_fd, &wakeup, sizeof(wakeup));
+        if (worker->thread.joinable())
+            worker->thread.join();
+    }
+
+    // Only destroy the drones once no reactor can touch them anymore
+    std::unique_lock<std::mutex> lock(m_drones_mutex);
+    m_drones.clear();
+    m_retired_drones.clear();
+}
+
+Drone* Fleet::add_drone(DroneConfig config)
+{
+    if (!m_initialized || m_shutting_down)
+        return nullptr;
+
+    auto tick = std::chrono::duration_cast<std::chrono::nanoseconds>(config.control_tick).count();
+    auto drone = std::unique_ptr<Drone>(new Drone(std::move(config), false));
+    if (!drone->is_initialized())
+        return nullptr;
+
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd == -1) {
+        perror("timerfd_create()");
+        return nullptr;
+    }
+    itimerspec timer_spec {};
+    timer_spec.it_interval.tv_sec = tick / 1'000'000'000;
+    timer_spec.it_interval.tv_nsec = tick % 1'000'000'000;
+    timer_spec.it_value = timer_spec.it_interval;
+    if (timerfd_settime(timer_fd, 0, &timer_spec, nullptr) < 0) {
+        perror("timerfd_settime()");
+        ::close(timer_fd);
+        return nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock(m_drones_mutex);
+    auto& worker = *m_workers[m_drones.size() % m_workers.size()];
+    auto* drone_ptr = drone.get();
+    if (!add_source(worker, SourceKind::CmdSocket, drone->m_cmd_socket_fd, drone_ptr)
+        || !add_source(worker, SourceKind::VideoSocket, drone->m_video_socket_fd, drone_ptr)
+        || !add_source(worker, SourceKind::ControlTimer, timer_fd, drone_ptr)) {
+        // The reactor may be dispatching an event of a source that was already registered, so the drone and
+        // its sources are kept until stop() like every other drone, only their events are stopped here
+        for (auto& source : worker.sources) {
+            if (source->drone == drone_ptr)
+                epoll_ctl(worker.epoll_fd, EPOLL_CTL_DEL, source->fd, nullptr);
+        }
+        // The timer is registered last, so it never made it into the sources
+        ::close(timer_fd);
+        m_retired_drones.push_back(std::move(drone));
+        return nullptr;
+    }
+    m_drones.push_back(std::move(drone));
+    return drone_ptr;
+}
+
+usize Fleet::size()
+{
+    std::unique_lock<std::mutex> lock(m_drones_mutex);
+    return m_drones.size();
+}
+
+Drone& Fleet::get_drone(usize index)
+{
+    std::unique_lock<std::mutex> lock(m_drones_mutex);
+    return *m_drones[index];
+}
+
+bool Fleet::add_source(Worker& worker, SourceKind kind, int fd, Drone* drone)
+{
+    auto source = std::make_unique<Source>(Source { kind, fd, drone });
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.ptr = source.get();
+    if (epoll_ctl(worker.epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        perror("epoll_ctl(EPOLL_CTL_ADD)");
+        return false;
+    }
+    worker.sources.push_back(std::move(source));
+    return true;
+}
+
+void Fleet::worker_thread_routine(Worker& worker)
+{
+    epoll_event events[MAX_EPOLL_EVENTS];
+    while (!m_shutting_down) {
+        int event_count = epoll_wait(worker.epoll_fd, events, MAX_EPOLL_EVENTS, -1);
+        if (event_count < 0) {
+            if (errno != EINTR)
+                std::cerr << "Failed to wait for fleet events, errno: " << strerror(errno) << std::endl;
+            continue;
+        }
+
+        for (int i = 0; i < event_count && !m_shutting_down; ++i) {
+            auto& source = *static_cast<Source*>(events[i].data.ptr);
+            switch (source.kind) {
+            case SourceKind::CmdSocket:
+                for (usize j = 0; j < RECEIVE_BUDGET && source.drone->receive_cmd_packets(MSG_DONTWAIT); ++j) { }
+                break;
+            case SourceKind::VideoSocket:
+                for (usize j = 0; j < RECEIVE_BUDGET && source.drone->receive_video_packets(MSG_DONTWAIT); ++j) { }
+                break;
+            case SourceKind::ControlTimer: {
+                // Missed ticks are coalesced, the controls packet only carries the latest state anyway
+                u64 expirations;
+                if (read(source.fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+                    source.drone->control_tick();
+                break;
+            }
+            case SourceKind::Wakeup:
+                break;
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "DroneConfig.h"
+#include "TelloDrone.h"
+#include "Utils/Types.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Tello {
+
+struct FleetConfig {
+    // Drones are sharded round-robin across this many reactor threads
+    usize worker_count { 1 };
+};
+
+// Drives many drones from a small pool of epoll reactors: each worker waits on the cmd and video
+// sockets and a control timerfd of every drone in its shard, instead of each drone running three threads.
+class Fleet {
+public:
+    explicit Fleet(FleetConfig config = {});
+    ~Fleet();
+
+    [[nodiscard]] bool is_initialized() const { return m_initialized; }
+
+    // Returns nullptr if the drone's sockets could not be set up
+    Drone* add_drone(DroneConfig config);
+
+    [[nodiscard]] usize size();
+    [[nodiscard]] Drone& get_drone(usize index);
+
+    void stop();
+
+private:
+    enum class SourceKind {
+        CmdSocket,
+        VideoSocket,
+        ControlTimer,
+        Wakeup,
+    };
+
+    struct Source {
+        SourceKind kind;
+        int fd;
+        Drone* drone;
+    };
+
+    struct Worker {
+        int epoll_fd { -1 };
+        int wakeup_fd { -1 };
+        std::thread thread;
+        std::vector<std::unique_ptr<Source>> sources;
+    };
+
+    bool add_source(Worker& worker, SourceKind kind, int fd, Drone* drone);
+    void worker_thread_routine(Worker& worker);
+
+    FleetConfig m_config;
+    bool m_initialized { false };
+    std::atomic<bool> m_shutting_down { false };
+
+    std::mutex m_drones_mutex;
+    std::vector<std::unique_ptr<Drone>> m_drones;
+    // Drones whose sources could not all be registered, destroyed along with the others once the reactors stopped
+    std::vector<std::unique_ptr<Drone>> m_retired_drones;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+};
+
+}
@@ -0,0 +1,156 @@
+#include "FramePool.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace Tello {
+
+// Buffers grow in steps of this size, so a slowly rising frame size does not reallocate on every frame
+static constexpr usize BUFFER_GROWTH_STEP = 16 * 1024;
+
+VideoFrame::VideoFrame(const VideoFrame& other)
+    : m_buffer(other.m_buffer)
+{
+    if (m_buffer)
+        m_buffer->ref_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+VideoFrame::VideoFrame(VideoFrame&& other) noexcept
+    : m_buffer(std::exchange(other.m_buffer, nullptr))
+{
+}
+
+VideoFrame& VideoFrame::operator=(const VideoFrame& other)
+{
+    if (this != &other) {
+        if (other.m_buffer)
+            other.m_buffer->ref_count.fetch_add(1, std::memory_order_relaxed);
+        reset();
+        m_buffer = other.m_buffer;
+    }
+    return *this;
+}
+
+VideoFrame& VideoFrame::operator=(VideoFrame&& other) noexcept
+{
+    if (this != &other) {
+        reset();
+        m_buffer = std::exchange(other.m_buffer, nullptr);
+    }
+    return *this;
+}
+
+void VideoFrame::reset()
+{
+    auto* buffer = std::exchange(m_buffer, nullptr);
+    if (!buffer || buffer->ref_count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    // The pool may go away together with this last reference, so it is moved out of the buffer first
+    auto pool = std::move(buffer->pool);
+    pool->release(buffer);
+}
+
+std::shared_ptr<FramePool> FramePool::create(FramePoolConfig config)
+{
+    return std::shared_ptr<FramePool>(new FramePool(config));
+}
+
+FramePool::FramePool(FramePoolConfig config)
+    : m_config(config)
+{
+    m_config.buffer_count = std::max<usize>(m_config.buffer_count, 1);
+    m_config.initial_buffer_capacity = std::min(m_config.initial_buffer_capacity, m_config.max_frame_size);
+
+    m_buffers.reserve(m_config.buffer_count);
+    m_free_buffers.reserve(m_config.buffer_count);
+    for (usize i = 0; i < m_config.buffer_count; ++i) {
+        auto buffer = std::make_unique<FrameBuffer>();
+        buffer->data = std::make_unique<u8[]>(m_config.initial_buffer_capacity);
+        buffer->capacity = m_config.initial_buffer_capacity;
+        m_free_buffers.push_back(buffer.get());
+        m_buffers.push_back(std::move(buffer));
+    }
+    m_buffer_capacity = m_config.initial_buffer_capacity;
+}
+
+VideoFrame FramePool::acquire()
+{
+    FrameBuffer* buffer;
+    {
+        std::lock_guard lock(m_free_buffers_mutex);
+        if (m_free_buffers.empty())
+            return {};
+        buffer = m_free_buffers.back();
+        m_free_buffers.pop_back();
+    }
+
+    // Buffers that have not seen the largest frame yet catch up here rather than in the middle of a frame
+    auto target_capacity = m_buffer_capacity.load(std::memory_order_relaxed);
+    if (buffer->capacity < target_capacity) {
+        buffer->data = std::make_unique<u8[]>(target_capacity);
+        buffer->capacity = target_capacity;
+    }
+
+    buffer->size = 0;
+    buffer->frame_num = 0;
+    buffer->ref_count.store(1, std::memory_order_relaxed);
+    buffer->pool = shared_from_this();
+    return VideoFrame(buffer);
+}
+
+bool FramePool::write(VideoFrame& frame, usize offset, std::span<const u8> bytes)
+{
+    auto& buffer = *frame.m_buffer;
+    auto end = offset + bytes.size();
+    if (end > buffer.capacity && !grow(buffer, end))
+        return false;
+    std::memcpy(buffer.data.get() + offset, bytes.data(), bytes.size());
+    return true;
+}
+
+void FramePool::finish(VideoFrame& frame, u8 frame_num, usize size, const VideoFrameTimestamps& timestamps)
+{
+    auto& buffer = *frame.m_buffer;
+    buffer.frame_num = frame_num;
+    buffer.size = size;
+    buffer.timestamps = timestamps;
+
+    auto observed = m_max_observed_frame_size.load(std::memory_order_relaxed);
+    while (size > observed && !m_max_observed_frame_size.compare_exchange_weak(observed, size, std::memory_order_relaxed)) { }
+}
+
+bool FramePool::grow(FrameBuffer& buffer, usize required_capacity)
+{
+    if (required_capacity > m_config.max_frame_size)
+        return false;
+
+    auto capacity = (required_capacity + BUFFER_GROWTH_STEP - 1) / BUFFER_GROWTH_STEP * BUFFER_GROWTH_STEP;
+    capacity = std::min(capacity, m_config.max_frame_size);
+    auto data = std::make_unique<u8[]>(capacity);
+    std::memcpy(data.get(), buffer.data.get(), buffer.capacity);
+    buffer.data = std::move(data);
+    buffer.capacity = capacity;
+
+    auto target = m_buffer_capacity.load(std::memory_order_relaxed);
+    while (capacity > target && !m_buffer_capacity.compare_exchange_weak(target, capacity, std::memory_order_relaxed)) { }
+    return true;
+}
+
+void FramePool::release(FrameBuffer* buffer)
+{
+    std::lock_guard lock(m_free_buffers_mutex);
+    m_free_buffers.push_back(buffer);
+}
+
+FramePoolStatistics FramePool::get_statistics() const
+{
+    return {
+        .frames_dropped_pool_exhausted = m_frames_dropped_pool_exhausted.load(std::memory_order_relaxed),
+        .frames_dropped_oversize = m_frames_dropped_oversize.load(std::memory_order_relaxed),
+        .max_observed_frame_size = m_max_observed_frame_size.load(std::memory_order_relaxed),
+        .buffer_capacity = m_buffer_capacity.load(std::memory_order_relaxed),
+    };
+}
+
+}
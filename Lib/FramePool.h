@@ -0,0 +1,116 @@
+#pragma once
+
+#include "DroneStatistics.h"
+#include "Utils/Types.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace Tello {
+
+struct FramePoolConfig {
+    usize buffer_count { 8 };
+    usize initial_buffer_capacity { 64 * 1024 };
+    // Frames larger than this are dropped instead of growing the buffers any further
+    usize max_frame_size { 256 * 1024 };
+};
+
+class FramePool;
+
+struct VideoFrameTimestamps {
+    // When the first segment to arrive and the segment completing the frame were received, taken from the
+    // kernel receive timestamps where available
+    std::chrono::steady_clock::time_point first_segment {};
+    std::chrono::steady_clock::time_point last_segment {};
+    // When the reassembler found the frame complete
+    std::chrono::steady_clock::time_point reassembled {};
+};
+
+struct FrameBuffer {
+    std::unique_ptr<u8[]> data;
+    usize capacity { 0 };
+    usize size { 0 };
+    u8 frame_num { 0 };
+    VideoFrameTimestamps timestamps;
+    std::atomic<u32> ref_count { 0 };
+    // Keeps the pool alive while the buffer is handed out
+    std::shared_ptr<FramePool> pool;
+};
+
+// Shared read-only handle to a reassembled frame. Copies share the same buffer, which goes back to its
+// pool once the last handle is gone, so frames are handed to consumers without copying the data.
+class VideoFrame {
+public:
+    VideoFrame() = default;
+    VideoFrame(const VideoFrame& other);
+    VideoFrame(VideoFrame&& other) noexcept;
+    VideoFrame& operator=(const VideoFrame& other);
+    VideoFrame& operator=(VideoFrame&& other) noexcept;
+    ~VideoFrame() { reset(); }
+
+    explicit operator bool() const { return m_buffer != nullptr; }
+
+    [[nodiscard]] std::span<const u8> data() const { return { m_buffer->data.get(), m_buffer->size }; }
+    [[nodiscard]] usize size() const { return m_buffer->size; }
+    [[nodiscard]] u8 frame_num() const { return m_buffer->frame_num; }
+    // When the segment completing the frame was received
+    [[nodiscard]] std::chrono::steady_clock::time_point arrival_time() const { return m_buffer->timestamps.last_segment; }
+    [[nodiscard]] const VideoFrameTimestamps& timestamps() const { return m_buffer->timestamps; }
+
+    void reset();
+
+private:
+    friend class FramePool;
+
+    // Adopts a reference already taken on `buffer`
+    explicit VideoFrame(FrameBuffer* buffer)
+        : m_buffer(buffer)
+    {
+    }
+
+    FrameBuffer* m_buffer { nullptr };
+};
+
+// A fixed set of frame buffers that grow to the largest frame observed so far (up to a limit), so that
+// steady-state reassembly never allocates
+class FramePool : public std::enable_shared_from_this<FramePool> {
+public:
+    static std::shared_ptr<FramePool> create(FramePoolConfig config);
+
+    // Returns an empty frame if every buffer is still held by a consumer
+    VideoFrame acquire();
+
+    // Only valid while the caller holds the sole handle to `frame`, i.e. before it was handed out
+    bool write(VideoFrame& frame, usize offset, std::span<const u8> bytes);
+    void finish(VideoFrame& frame, u8 frame_num, usize size, const VideoFrameTimestamps& timestamps);
+
+    void record_pool_exhausted() { m_frames_dropped_pool_exhausted.fetch_add(1, std::memory_order_relaxed); }
+    void record_oversize() { m_frames_dropped_oversize.fetch_add(1, std::memory_order_relaxed); }
+
+    [[nodiscard]] FramePoolStatistics get_statistics() const;
+    [[nodiscard]] usize max_frame_size() const { return m_config.max_frame_size; }
+
+private:
+    friend class VideoFrame;
+
+    explicit FramePool(FramePoolConfig config);
+
+    void release(FrameBuffer* buffer);
+    bool grow(FrameBuffer& buffer, usize required_capacity);
+
+    FramePoolConfig m_config;
+    std::vector<std::unique_ptr<FrameBuffer>> m_buffers;
+
+    std::mutex m_free_buffers_mutex;
+    std::vector<FrameBuffer*> m_free_buffers;
+
+    std::atomic<usize> m_max_observed_frame_size { 0 };
+    std::atomic<usize> m_buffer_capacity { 0 };
+    std::atomic<u64> m_frames_dropped_pool_exhausted { 0 };
+    std::atomic<u64> m_frames_dropped_oversize { 0 };
+};
+
+}
@@ -0,0 +1,307 @@
+#include "H264Parser.h"
+#include <algorithm>
+
+namespace Tello {
+
+namespace {
+
+// Reads exp-Golomb coded RBSP fields straight from a NAL unit, skipping emulation prevention bytes
+class RBSPBitReader {
+public:
+    explicit RBSPBitReader(std::span<const u8> bytes)
+        : m_bytes(bytes)
+    {
+    }
+
+    [[nodiscard]] bool failed() const { return m_failed; }
+
+    u32 read_bits(u8 count)
+    {
+        u32 value = 0;
+        for (u8 i = 0; i < count; ++i)
+            value = (value << 1) | read_bit();
+        return value;
+    }
+
+    bool read_flag() { return read_bit() != 0; }
+
+    u32 read_ue()
+    {
+        u8 leading_zero_bits = 0;
+        while (read_bit() == 0) {
+            if (m_failed || ++leading_zero_bits > 31) {
+                m_failed = true;
+                return 0;
+            }
+        }
+        return ((1u << leading_zero_bits) - 1) + read_bits(leading_zero_bits);
+    }
+
+    i32 read_se()
+    {
+        auto code = read_ue();
+        return code & 1 ? static_cast<i32>((code + 1) / 2) : -static_cast<i32>(code / 2);
+    }
+
+private:
+    u32 read_bit()
+    {
+        if (m_bit_offset == 0) {
+            if (m_offset >= m_bytes.size()) {
+                m_failed = true;
+                return 0;
+            }
+            // 0x000003 is only there to prevent start code emulation, the 0x03 is not part of the RBSP
+            if (m_zero_run >= 2 && m_bytes[m_offset] == 0x03) {
+                m_zero_run = 0;
+                if (++m_offset >= m_bytes.size()) {
+                    m_failed = true;
+                    return 0;
+                }
+            }
+            m_current = m_bytes[m_offset++];
+            m_zero_run = m_current == 0 ? m_zero_run + 1 : 0;
+            m_bit_offset = 8;
+        }
+        return (m_current >> --m_bit_offset) & 1;
+    }
+
+    std::span<const u8> m_bytes;
+    usize m_offset { 0 };
+    u8 m_current { 0 };
+    u8 m_bit_offset { 0 };
+    u8 m_zero_run { 0 };
+    bool m_failed { false };
+};
+
+bool has_chroma_format_fields(u8 profile_idc)
+{
+    switch (profile_idc) {
+    case 100:
+    case 110:
+    case 122:
+    case 244:
+    case 44:
+    case 83:
+    case 86:
+    case 118:
+    case 128:
+    case 138:
+    case 139:
+    case 134:
+    case 135:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void skip_scaling_list(RBSPBitReader& reader, usize size)
+{
+    i32 last_scale = 8;
+    i32 next_scale = 8;
+    for (usize i = 0; i < size && !reader.failed(); ++i) {
+        if (next_scale != 0)
+            next_scale = (last_scale + reader.read_se() + 256) % 256;
+        last_scale = next_scale == 0 ? last_scale : next_scale;
+    }
+}
+
+}
+
+H264NALUnitReader::H264NALUnitReader(std::span<const u8> stream)
+    : m_stream(stream)
+{
+}
+
+bool H264NALUnitReader::next(H264NALUnit& nal_unit)
+{
+    auto const* bytes = m_stream.data();
+    auto size = m_stream.size();
+
+    // Find the start of this NAL unit: the first 0x000001 at or after the current offset
+    auto find_start_code = [&](usize from) -> usize {
+        for (usize i = from + 2; i < size;) {
+            if (bytes[i] > 1)
+                i += 3;
+            else if (bytes[i] == 1 && bytes[i - 1] == 0 && bytes[i - 2] == 0)
+                return i - 2;
+            else
+                i++;
+        }
+        return size;
+    };
+
+    auto start_code = find_start_code(m_offset);
+    if (start_code + 3 >= size)
+        return false;
+    auto begin = start_code + 3;
+    auto end = find_start_code(begin);
+    m_offset = end;
+
+    // The leading zero byte of a 4 byte start code (and any trailing_zero_8bits) is not part of the NAL unit
+    while (end > begin && bytes[end - 1] == 0)
+        end--;
+
+    nal_unit.type = static_cast<H264NALUnitType>(bytes[begin] & 0x1F);
+    nal_unit.ref_idc = (bytes[begin] >> 5) & 0x03;
+    nal_unit.bytes = m_stream.subspan(begin, end - begin);
+    return true;
+}
+
+std::optional<H264SequenceParameterSet> parse_h264_sequence_parameter_set(std::span<const u8> nal_unit)
+{
+    if (nal_unit.empty() || static_cast<H264NALUnitType>(nal_unit[0] & 0x1F) != H264NALUnitType::SequenceParameterSet)
+        return {};
+
+    RBSPBitReader reader(nal_unit.subspan(1));
+    H264SequenceParameterSet sps;
+    sps.profile_idc = reader.read_bits(8);
+    sps.constraint_flags = reader.read_bits(8);
+    sps.level_idc = reader.read_bits(8);
+    sps.seq_parameter_set_id = reader.read_ue();
+
+    if (has_chroma_format_fields(sps.profile_idc)) {
+        sps.chroma_format_idc = reader.read_ue();
+        if (sps.chroma_format_idc == 3)
+            sps.separate_colour_plane = reader.read_flag();
+        reader.read_ue(); // bit_depth_luma_minus8
+        reader.read_ue(); // bit_depth_chroma_minus8
+        reader.read_flag(); // qpprime_y_zero_transform_bypass_flag
+        if (reader.read_flag()) { // seq_scaling_matrix_present_flag
+            usize list_count = sps.chroma_format_idc == 3 ? 12 : 8;
+            for (usize i = 0; i < list_count; ++i) {
+                if (reader.read_flag())
+                    skip_scaling_list(reader, i < 6 ? 16 : 64);
+            }
+        }
+    }
+
+    sps.log2_max_frame_num = reader.read_ue() + 4;
+    auto pic_order_cnt_type = reader.read_ue();
+    if (pic_order_cnt_type == 0) {
+        reader.read_ue(); // log2_max_pic_order_cnt_lsb_minus4
+    } else if (pic_order_cnt_type == 1) {
+        reader.read_flag(); // delta_pic_order_always_zero_flag
+        reader.read_se(); // offset_for_non_ref_pic
+        reader.read_se(); // offset_for_top_to_bottom_field
+        auto cycle_length = reader.read_ue();
+        for (u32 i = 0; i < cycle_length && !reader.failed(); ++i)
+            reader.read_se(); // offset_for_ref_frame
+    }
+    reader.read_ue(); // max_num_ref_frames
+    sps.gaps_in_frame_num_allowed = reader.read_flag();
+    auto pic_width_in_mbs = reader.read_ue() + 1;
+    auto pic_height_in_map_units = reader.read_ue() + 1;
+    bool frame_mbs_only = reader.read_flag();
+    if (!frame_mbs_only)
+        reader.read_flag(); // mb_adaptive_frame_field_flag
+    reader.read_flag(); // direct_8x8_inference_flag
+
+    u32 crop_left = 0, crop_right = 0, crop_top = 0, crop_bottom = 0;
+    if (reader.read_flag()) { // frame_cropping_flag
+        crop_left = reader.read_ue();
+        crop_right = reader.read_ue();
+        crop_top = reader.read_ue();
+        crop_bottom = reader.read_ue();
+    }
+    if (reader.failed() || sps.log2_max_frame_num > 16)
+        return {};
+
+    // Cropping is in chroma sample units, see the frame_crop_*_offset semantics in the spec
+    u8 chroma_array_type = sps.separate_colour_plane ? 0 : sps.chroma_format_idc;
+    u32 crop_unit_x = chroma_array_type == 1 || chroma_array_type == 2 ? 2 : 1;
+    u32 crop_unit_y = (chroma_array_type == 1 ? 2 : 1) * (frame_mbs_only ? 1 : 2);
+    u32 width = pic_width_in_mbs * 16;
+    u32 height = (frame_mbs_only ? 1 : 2) * pic_height_in_map_units * 16;
+    if (crop_unit_x * (crop_left + crop_right) >= width || crop_unit_y * (crop_top + crop_bottom) >= height)
+        return {};
+    sps.width = width - crop_unit_x * (crop_left + crop_right);
+    sps.height = height - crop_unit_y * (crop_top + crop_bottom);
+    return sps;
+}
+
+H264AccessUnitInfo H264Parser::parse_access_unit(std::span<const u8> access_unit)
+{
+    H264AccessUnitInfo info;
+    bool has_slice_header = false;
+
+    H264NALUnitReader reader(access_unit);
+    H264NALUnit nal_unit;
+    while (reader.next(nal_unit)) {
+        switch (nal_unit.type) {
+        case H264NALUnitType::SequenceParameterSet:
+            info.has_sequence_parameter_set = true;
+            if (update_parameter_set(m_sequence_parameter_set, nal_unit.bytes))
+                m_stream_info = parse_h264_sequence_parameter_set(nal_unit.bytes);
+            break;
+        case H264NALUnitType::PictureParameterSet:
+            info.has_picture_parameter_set = true;
+            update_parameter_set(m_picture_parameter_set, nal_unit.bytes);
+            break;
+        case H264NALUnitType::IDRSlice:
+        case H264NALUnitType::NonIDRSlice:
+        case H264NALUnitType::SliceDataPartitionA: {
+            if (nal_unit.type == H264NALUnitType::IDRSlice)
+                info.has_idr_slice = true;
+            else
+                info.has_non_idr_slice = true;
+            info.is_reference |= nal_unit.ref_idc != 0;
+            // Every slice of a picture carries the same frame_num, the first one is enough
+            if (has_slice_header || !m_stream_info)
+                break;
+            RBSPBitReader slice_reader(nal_unit.bytes.subspan(1));
+            slice_reader.read_ue(); // first_mb_in_slice
+            slice_reader.read_ue(); // slice_type
+            slice_reader.read_ue(); // pic_parameter_set_id
+            if (m_stream_info->separate_colour_plane)
+                slice_reader.read_bits(2); // colour_plane_id
+            info.frame_num = slice_reader.read_bits(m_stream_info->log2_max_frame_num);
+            has_slice_header = !slice_reader.failed();
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    if (info.has_idr_slice) {
+        // An IDR picture does not reference anything before it
+        m_decodable = has_parameter_sets() && has_slice_header;
+        m_previous_reference_frame_num = 0;
+    } else if (info.has_non_idr_slice && m_decodable) {
+        if (!has_slice_header) {
+            info.lost_reference = true;
+        } else if (!m_stream_info->gaps_in_frame_num_allowed) {
+            // frame_num is one past the previous reference picture's, or equal to it for a run of non-reference
+            // pictures, so anything else means a reference picture went missing
+            u16 max_frame_num = 1u << m_stream_info->log2_max_frame_num;
+            u16 next_frame_num = (m_previous_reference_frame_num + 1) % max_frame_num;
+            info.lost_reference = info.frame_num != next_frame_num && info.frame_num != m_previous_reference_frame_num;
+        }
+        m_decodable = !info.lost_reference;
+    }
+    if (info.is_reference && has_slice_header)
+        m_previous_reference_frame_num = info.frame_num;
+
+    info.decodable = m_decodable && (info.has_idr_slice || info.has_non_idr_slice);
+    return info;
+}
+
+void H264Parser::note_lost_frames(usize count)
+{
+    // frame_num wraps, so losing a whole cycle of reference pictures would go unnoticed
+    if (m_decodable && m_stream_info && count + 1 >= (1u << m_stream_info->log2_max_frame_num))
+        m_decodable = false;
+}
+
+bool H264Parser::update_parameter_set(std::vector<u8>& cached, std::span<const u8> nal_unit)
+{
+    if (std::equal(cached.begin(), cached.end(), nal_unit.begin(), nal_unit.end()))
+        return false;
+    cached.assign(nal_unit.begin(), nal_unit.end());
+    m_parameter_sets_version++;
+    return true;
+}
+
+}
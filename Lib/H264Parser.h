@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Utils/Types.h"
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace Tello {
+
+enum class H264NALUnitType : u8 {
+    Unspecified = 0,
+    NonIDRSlice = 1,
+    SliceDataPartitionA = 2,
+    SliceDataPartitionB = 3,
+    SliceDataPartitionC = 4,
+    IDRSlice = 5,
+    SupplementalEnhancementInformation = 6,
+    SequenceParameterSet = 7,
+    PictureParameterSet = 8,
+    AccessUnitDelimiter = 9,
+    EndOfSequence = 10,
+    EndOfStream = 11,
+    FillerData = 12,
+};
+
+struct H264NALUnit {
+    H264NALUnitType type { H264NALUnitType::Unspecified };
+    u8 ref_idc { 0 };
+    // The NAL unit header byte and payload, without the start code
+    std::span<const u8> bytes;
+};
+
+// Splits an Annex-B byte stream at its 3 and 4 byte start codes
+class H264NALUnitReader {
+public:
+    explicit H264NALUnitReader(std::span<const u8> stream);
+
+    bool next(H264NALUnit& nal_unit);
+
+private:
+    std::span<const u8> m_stream;
+    usize m_offset { 0 };
+};
+
+struct H264SequenceParameterSet {
+    u8 profile_idc { 0 };
+    u8 constraint_flags { 0 };
+    u8 level_idc { 0 };
+    u8 seq_parameter_set_id { 0 };
+    u8 chroma_format_idc { 1 };
+    bool separate_colour_plane { false };
+    u8 log2_max_frame_num { 4 };
+    bool gaps_in_frame_num_allowed { false };
+    // In pixels, after cropping
+    u32 width { 0 };
+    u32 height { 0 };
+};
+
+// Returns nothing if the NAL unit is truncated or not a sequence parameter set
+std::optional<H264SequenceParameterSet> parse_h264_sequence_parameter_set(std::span<const u8> nal_unit);
+
+struct H264AccessUnitInfo {
+    bool has_sequence_parameter_set { false };
+    bool has_picture_parameter_set { false };
+    bool has_idr_slice { false };
+    bool has_non_idr_slice { false };
+    // Non-reference pictures can be lost without affecting any other frame
+    bool is_reference { false };
+    u16 frame_num { 0 };
+    // Whether the picture can be decoded, i.e. an IDR frame and every reference frame since were received
+    bool decodable { false };
+    // Set on the first picture after a lost reference frame
+    bool lost_reference { false };
+};
+
+// Classifies the NAL units of each access unit of a stream and keeps the latest parameter sets, so that a
+// decoder or recorder can be (re)started from any IDR frame. Lost reference frames are detected from the
+// slice header frame_num, which only advances past reference pictures.
+class H264Parser {
+public:
+    H264AccessUnitInfo parse_access_unit(std::span<const u8> access_unit);
+
+    // For frames that never made it out of reassembly, which the frame_num check alone may miss
+    void note_lost_frames(usize count);
+    [[nodiscard]] bool is_decodable() const { return m_decodable; }
+
+    [[nodiscard]] bool has_parameter_sets() const { return !m_sequence_parameter_set.empty() && !m_picture_parameter_set.empty(); }
+    [[nodiscard]] std::span<const u8> sequence_parameter_set() const { return m_sequence_parameter_set; }
+    [[nodiscard]] std::span<const u8> picture_parameter_set() const { return m_picture_parameter_set; }
+    [[nodiscard]] const std::optional<H264SequenceParameterSet>& stream_info() const { return m_stream_info; }
+
+    // Bumped whenever the cached parameter sets change
+    [[nodiscard]] u32 parameter_sets_version() const { return m_parameter_sets_version; }
+
+private:
+    bool update_parameter_set(std::vector<u8>& cached, std::span<const u8> nal_unit);
+
+    std::vector<u8> m_sequence_parameter_set;
+    std::vector<u8> m_picture_parameter_set;
+    std::optional<H264SequenceParameterSet> m_stream_info;
+    u32 m_parameter_sets_version { 0 };
+
+    bool m_decodable { false };
+    u16 m_previous_reference_frame_num { 0 };
+};
+
+}
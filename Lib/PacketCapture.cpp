@@ -0,0 +1,187 @@
+#include "PacketCapture.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Tello {
+
+static usize align_record(usize size)
+{
+    return (size + CaptureFileFormat::RECORD_ALIGNMENT - 1) & ~(CaptureFileFormat::RECORD_ALIGNMENT - 1);
+}
+
+std::unique_ptr<PacketCaptureWriter> PacketCaptureWriter::open(const std::string& path)
+{
+    int file_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file_fd < 0) {
+        perror(("open(" + path + ")").c_str());
+        return nullptr;
+    }
+    if (ftruncate(file_fd, INITIAL_FILE_SIZE) < 0) {
+        perror("ftruncate(capture file)");
+        ::close(file_fd);
+        return nullptr;
+    }
+    void* mapping = mmap(nullptr, INITIAL_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, file_fd, 0);
+    if (mapping == MAP_FAILED) {
+        perror("mmap(capture file)");
+        ::close(file_fd);
+        return nullptr;
+    }
+    return std::unique_ptr<PacketCaptureWriter>(new PacketCaptureWriter(file_fd, static_cast<u8*>(mapping), INITIAL_FILE_SIZE));
+}
+
+PacketCaptureWriter::PacketCaptureWriter(int file_fd, u8* mapping, usize mapped_size)
+    : m_file_fd(file_fd)
+    , m_mapping(mapping)
+    , m_mapped_size(mapped_size)
+{
+    u32 version = CaptureFileFormat::VERSION;
+    u32 header_size = CaptureFileFormat::FILE_HEADER_SIZE;
+    memcpy(m_mapping, CaptureFileFormat::MAGIC, sizeof(CaptureFileFormat::MAGIC));
+    memcpy(m_mapping + 8, &version, sizeof(version));
+    memcpy(m_mapping + 12, &header_size, sizeof(header_size));
+    m_size = CaptureFileFormat::FILE_HEADER_SIZE;
+}
+
+PacketCaptureWriter::~PacketCaptureWriter()
+{
+    close();
+}
+
+bool PacketCaptureWriter::grow(usize min_size)
+{
+    auto new_size = m_mapped_size;
+    while (new_size < min_size)
+        new_size += std::min(new_size, MAX_GROWTH);
+    if (ftruncate(m_file_fd, new_size) < 0) {
+        perror("ftruncate(capture file)");
+        return false;
+    }
+    void* mapping = mremap(m_mapping, m_mapped_size, new_size, MREMAP_MAYMOVE);
+    if (mapping == MAP_FAILED) {
+        perror("mremap(capture file)");
+        return false;
+    }
+    m_mapping = static_cast<u8*>(mapping);
+    m_mapped_size = new_size;
+    return true;
+}
+
+void PacketCaptureWriter::append(CaptureSource source, std::chrono::system_clock::time_point timestamp, std::span<const u8> data)
+{
+    std::lock_guard lock(m_mutex);
+    if (!m_mapping)
+        return;
+    auto record_size = align_record(CaptureFileFormat::RECORD_HEADER_SIZE + data.size());
+    if (m_size + record_size > m_mapped_size && !grow(m_size + record_size)) {
+        m_statistics.records_dropped++;
+        return;
+    }
+
+    auto* record = m_mapping + m_size;
+    i64 timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+    u32 length = data.size();
+    memcpy(record, &timestamp_ns, sizeof(timestamp_ns));
+    memcpy(record + 8, &length, sizeof(length));
+    memcpy(record + CaptureFileFormat::RECORD_HEADER_SIZE, data.data(), data.size());
+    // The source goes in last, a record cut short by a crash still reads as the end of the capture
+    record[12] = static_cast<u8>(source);
+    m_size += record_size;
+    m_statistics.records_written++;
+    m_statistics.bytes_written += data.size();
+}
+
+void PacketCaptureWriter::close()
+{
+    std::lock_guard lock(m_mutex);
+    if (!m_mapping)
+        return;
+    munmap(m_mapping, m_mapped_size);
+    m_mapping = nullptr;
+    if (ftruncate(m_file_fd, m_size) < 0)
+        perror("ftruncate(capture file)");
+    ::close(m_file_fd);
+    m_file_fd = -1;
+}
+
+PacketCaptureStatistics PacketCaptureWriter::get_statistics()
+{
+    std::lock_guard lock(m_mutex);
+    return m_statistics;
+}
+
+std::unique_ptr<PacketCaptureReader> PacketCaptureReader::open(const std::string& path)
+{
+    int file_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file_fd < 0) {
+        perror(("open(" + path + ")").c_str());
+        return nullptr;
+    }
+    struct stat file_stat {};
+    if (fstat(file_fd, &file_stat) < 0) {
+        perror("fstat(capture file)");
+        ::close(file_fd);
+        return nullptr;
+    }
+    usize size = file_stat.st_size;
+    if (size < CaptureFileFormat::FILE_HEADER_SIZE) {
+        std::cerr << "`" << path << "` is not a capture file" << std::endl;
+        ::close(file_fd);
+        return nullptr;
+    }
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_fd, 0);
+    ::close(file_fd);
+    if (mapping == MAP_FAILED) {
+        perror("mmap(capture file)");
+        return nullptr;
+    }
+    auto* bytes = static_cast<const u8*>(mapping);
+    u32 version;
+    memcpy(&version, bytes + 8, sizeof(version));
+    if (memcmp(bytes, CaptureFileFormat::MAGIC, sizeof(CaptureFileFormat::MAGIC)) != 0 || version != CaptureFileFormat::VERSION) {
+        std::cerr << "`" << path << "` is not a version " << CaptureFileFormat::VERSION << " capture file" << std::endl;
+        munmap(mapping, size);
+        return nullptr;
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    return std::unique_ptr<PacketCaptureReader>(new PacketCaptureReader(bytes, size));
+}
+
+PacketCaptureReader::PacketCaptureReader(const u8* mapping, usize size)
+    : m_mapping(mapping)
+    , m_size(size)
+{
+}
+
+PacketCaptureReader::~PacketCaptureReader()
+{
+    munmap(const_cast<u8*>(m_mapping), m_size);
+}
+
+std::optional<CaptureRecord> PacketCaptureReader::next()
+{
+    if (m_offset + CaptureFileFormat::RECORD_HEADER_SIZE > m_size)
+        return {};
+    auto* record = m_mapping + m_offset;
+    auto source = static_cast<CaptureSource>(record[12]);
+    if (source != CaptureSource::CmdSocket && source != CaptureSource::VideoSocket)
+        return {};
+    i64 timestamp_ns;
+    u32 length;
+    memcpy(&timestamp_ns, record, sizeof(timestamp_ns));
+    memcpy(&length, record + 8, sizeof(length));
+    if (length > m_size - m_offset - CaptureFileFormat::RECORD_HEADER_SIZE)
+        return {};
+    m_offset += align_record(CaptureFileFormat::RECORD_HEADER_SIZE + length);
+    auto timestamp = std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(timestamp_ns));
+    return CaptureRecord { source, std::chrono::system_clock::time_point(timestamp),
+        { record + CaptureFileFormat::RECORD_HEADER_SIZE, length } };
+}
+
+}
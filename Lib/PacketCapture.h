@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Utils/Types.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace Tello {
+
+enum class CaptureSource : u8 {
+    CmdSocket = 1,
+    VideoSocket = 2,
+};
+
+struct CaptureRecord {
+    CaptureSource source;
+    // The kernel receive timestamp, or when the datagram was taken off the socket if there was none
+    std::chrono::system_clock::time_point timestamp;
+    std::span<const u8> data;
+};
+
+struct PacketCaptureStatistics {
+    u64 records_written { 0 };
+    u64 bytes_written { 0 };
+    // Not written because the file could not grow
+    u64 records_dropped { 0 };
+};
+
+// The file starts with a 16 byte header (magic, version, header size), followed by the records: a 16 byte
+// record header (timestamp in nanoseconds since the epoch, data length, source) and the data, padded to 8 bytes.
+// A record with source 0 (the zeroes of the file's unwritten tail) ends the capture.
+struct CaptureFileFormat {
+    static constexpr char MAGIC[8] = { 'T', 'E', 'L', 'L', 'O', 'C', 'A', 'P' };
+    static constexpr u32 VERSION = 1;
+    static constexpr usize FILE_HEADER_SIZE = 16;
+    static constexpr usize RECORD_HEADER_SIZE = 16;
+    static constexpr usize RECORD_ALIGNMENT = 8;
+};
+
+// Appends datagrams to a memory-mapped capture file, from the cmd and video receive threads at once. Appending
+// is a copy into the mapping under a short lock, the kernel writes the pages back in its own time. The file
+// grows in steps and is cut down to what was written once closed.
+class PacketCaptureWriter {
+public:
+    // Returns nothing if the file could not be created
+    static std::unique_ptr<PacketCaptureWriter> open(const std::string& path);
+    ~PacketCaptureWriter();
+
+    PacketCaptureWriter(const PacketCaptureWriter&) = delete;
+    PacketCaptureWriter& operator=(const PacketCaptureWriter&) = delete;
+
+    void append(CaptureSource source, std::chrono::system_clock::time_point timestamp, std::span<const u8> data);
+    // Later appends are ignored
+    void close();
+
+    [[nodiscard]] PacketCaptureStatistics get_statistics();
+
+private:
+    static constexpr usize INITIAL_FILE_SIZE = 1024 * 1024;
+    static constexpr usize MAX_GROWTH = 64 * 1024 * 1024;
+
+    PacketCaptureWriter(int file_fd, u8* mapping, usize mapped_size);
+    bool grow(usize min_size);
+
+    std::mutex m_mutex;
+    int m_file_fd { -1 };
+    u8* m_mapping { nullptr };
+    usize m_mapped_size { 0 };
+    usize m_size { 0 };
+    PacketCaptureStatistics m_statistics;
+};
+
+// Reads a capture file back record by record, the records' data points into the read-only mapping of the file
+class PacketCaptureReader {
+public:
+    // Returns nothing if the file could not be opened or is not a capture
+    static std::unique_ptr<PacketCaptureReader> open(const std::string& path);
+    ~PacketCaptureReader();
+
+    PacketCaptureReader(const PacketCaptureReader&) = delete;
+    PacketCaptureReader& operator=(const PacketCaptureReader&) = delete;
+
+    // Nothing once the capture ended, or at a record that does not fit the file
+    std::optional<CaptureRecord> next();
+    void rewind() { m_offset = CaptureFileFormat::FILE_HEADER_SIZE; }
+
+private:
+    PacketCaptureReader(const u8* mapping, usize size);
+
+    const u8* m_mapping { nullptr };
+    usize m_size { 0 };
+    usize m_offset { CaptureFileFormat::FILE_HEADER_SIZE };
+};
+
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Utils/Types.h"
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace Tello {
+
+// Packet data with inline storage for the common short payloads, so that building and sending most
+// commands (including the 50Hz flight controls) never touches the heap
+class PacketPayload {
+public:
+    static constexpr usize INLINE_CAPACITY = 32;
+
+    PacketPayload() = default;
+
+    explicit PacketPayload(usize size)
+    {
+        resize(size);
+    }
+
+    PacketPayload(std::span<const u8> bytes)
+    {
+        resize(bytes.size());
+        if (!bytes.empty())
+            memcpy(data(), bytes.data(), bytes.size());
+    }
+
+    PacketPayload(std::initializer_list<u8> bytes)
+        : PacketPayload(std::span<const u8>(bytes.begin(), bytes.size()))
+    {
+    }
+
+    PacketPayload(const std::vector<u8>& bytes)
+        : PacketPayload(std::span<const u8>(bytes))
+    {
+    }
+
+    PacketPayload(const PacketPayload& other)
+        : PacketPayload(std::span<const u8>(other))
+    {
+    }
+
+    PacketPayload(PacketPayload&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    PacketPayload& operator=(const PacketPayload& other)
+    {
+        if (this != &other) {
+            resize(other.size());
+            if (!other.empty())
+                memcpy(data(), other.data(), other.size());
+        }
+        return *this;
+    }
+
+    PacketPayload& operator=(PacketPayload&& other) noexcept
+    {
+        if (this == &other)
+            return *this;
+        m_heap = std::move(other.m_heap);
+        m_heap_capacity = other.m_heap_capacity;
+        m_size = other.m_size;
+        if (!m_heap)
+            memcpy(m_inline, other.m_inline, m_size);
+        other.m_heap_capacity = 0;
+        other.m_size = 0;
+        return *this;
+    }
+
+    void resize(usize size)
+    {
+        if (size > capacity()) {
+            auto heap = std::make_unique<u8[]>(size);
+            memcpy(heap.get(), data(), m_size);
+            m_heap = std::move(heap);
+            m_heap_capacity = size;
+        }
+        if (size > m_size)
+            memset(data() + m_size, 0, size - m_size);
+        m_size = size;
+    }
+
+    [[nodiscard]] usize capacity() const { return m_heap ? m_heap_capacity : INLINE_CAPACITY; }
+    [[nodiscard]] bool is_inline() const { return !m_heap; }
+
+    [[nodiscard]] u8* data() { return m_heap ? m_heap.get() : m_inline; }
+    [[nodiscard]] const u8* data() const { return m_heap ? m_heap.get() : m_inline; }
+    [[nodiscard]] usize size() const { return m_size; }
+    [[nodiscard]] bool empty() const { return m_size == 0; }
+
+    u8& operator[](usize index) { return data()[index]; }
+    u8 operator[](usize index) const { return data()[index]; }
+
+    [[nodiscard]] u8* begin() { return data(); }
+    [[nodiscard]] u8* end() { return data() + m_size; }
+    [[nodiscard]] const u8* begin() const { return data(); }
+    [[nodiscard]] const u8* end() const { return data() + m_size; }
+
+    operator std::span<const u8>() const { return { data(), m_size }; }
+
+private:
+    usize m_size { 0 };
+    usize m_heap_capacity { 0 };
+    std::unique_ptr<u8[]> m_heap;
+    u8 m_inline[INLINE_CAPACITY] {};
+};
+
+}
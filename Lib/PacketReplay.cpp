@@ -0,0 +1,61 @@
+#include "PacketReplay.h"
+#include <thread>
+
+namespace Tello {
+
+std::unique_ptr<PacketReplay> PacketReplay::open(const std::string& path, DroneConfig config)
+{
+    auto reader = PacketCaptureReader::open(path);
+    if (!reader)
+        return nullptr;
+    config.drone_ip = "127.0.0.1";
+    config.drone_cmd_port = DISCARD_PORT;
+    config.video_port = 0;
+    std::unique_ptr<Drone> drone(new Drone(std::move(config), false));
+    if (!drone->is_initialized())
+        return nullptr;
+    return std::unique_ptr<PacketReplay>(new PacketReplay(std::move(reader), std::move(drone)));
+}
+
+PacketReplay::PacketReplay(std::unique_ptr<PacketCaptureReader> reader, std::unique_ptr<Drone> drone)
+    : m_reader(std::move(reader))
+    , m_drone(std::move(drone))
+{
+}
+
+ReplayStatistics PacketReplay::run(ReplayConfig config)
+{
+    ReplayStatistics statistics;
+    std::optional<std::chrono::system_clock::time_point> first_timestamp;
+    auto start = std::chrono::steady_clock::now();
+    while (auto record = m_reader->next()) {
+        if (!first_timestamp)
+            first_timestamp = record->timestamp;
+        auto capture_time = record->timestamp - *first_timestamp;
+        statistics.capture_duration = std::max<std::chrono::nanoseconds>(statistics.capture_duration, capture_time);
+
+        auto receive_time = std::chrono::steady_clock::now();
+        if (config.speed > 0) {
+            auto due_time = start + std::chrono::duration_cast<std::chrono::nanoseconds>(capture_time / config.speed);
+            if (due_time > receive_time) {
+                std::this_thread::sleep_until(due_time);
+                receive_time = std::chrono::steady_clock::now();
+            }
+            statistics.max_lag = std::max<std::chrono::nanoseconds>(statistics.max_lag, receive_time - due_time);
+        }
+
+        if (record->source == CaptureSource::CmdSocket) {
+            m_drone->handle_cmd_datagram(record->data, receive_time);
+            statistics.cmd_datagrams++;
+        } else {
+            m_drone->m_video_reassembler.add_segment(record->data, receive_time);
+            statistics.video_datagrams++;
+        }
+        statistics.bytes += record->data.size();
+    }
+    statistics.replay_duration = std::chrono::steady_clock::now() - start;
+    m_reader->rewind();
+    return statistics;
+}
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "DroneConfig.h"
+#include "PacketCapture.h"
+#include "TelloDrone.h"
+#include "Utils/Types.h"
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace Tello {
+
+struct ReplayConfig {
+    // 1 replays the capture in real time, 10 ten times as fast, 0 as fast as possible
+    double speed { 1 };
+};
+
+struct ReplayStatistics {
+    u64 cmd_datagrams { 0 };
+    u64 video_datagrams { 0 };
+    u64 bytes { 0 };
+    // From the first to the last record
+    std::chrono::nanoseconds capture_duration {};
+    std::chrono::nanoseconds replay_duration {};
+    // How far the replay fell behind the pace it was asked for, at worst
+    std::chrono::nanoseconds max_lag {};
+};
+
+// Feeds a capture file through the receive paths of a drone without sockets of its own: cmd datagrams are
+// parsed and handled like on the cmd receive thread, video datagrams go through the reassembler, on the
+// thread calling `run`. Subscribe to the drone's telemetry streams and video frames beforehand to see the
+// flight again. The drone's own replies (acks of log headers, the initialization sequence) go to the loopback
+// discard port.
+class PacketReplay {
+public:
+    // Returns nothing if the capture could not be opened or the drone could not be set up. The drone address
+    // and video port of the config are overridden.
+    static std::unique_ptr<PacketReplay> open(const std::string& path, DroneConfig config = {});
+
+    [[nodiscard]] Drone& drone() { return *m_drone; }
+
+    // Replays the whole capture, then rewinds it so it can be replayed again (into the same drone)
+    ReplayStatistics run(ReplayConfig config = {});
+
+private:
+    static constexpr u16 DISCARD_PORT = 9;
+
+    PacketReplay(std::unique_ptr<PacketCaptureReader> reader, std::unique_ptr<Drone> drone);
+
+    std::unique_ptr<PacketCaptureReader> m_reader;
+    std::unique_ptr<Drone> m_drone;
+};
+
+}
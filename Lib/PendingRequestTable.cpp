@@ -0,0 +1,117 @@
+#include "PendingRequestTable.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace Tello {
+
+PendingRequestTable::Slot* PendingRequestTable::begin(u16 seq_num, CommandID cmd_id)
+{
+    for (usize distance = 0; distance < CAPACITY; ++distance) {
+        auto& slot = m_slots[(home_index(seq_num) + distance) % CAPACITY];
+        if (slot.key.load(std::memory_order_relaxed) != 0)
+            continue;
+        std::lock_guard lock(slot.mutex);
+        if (slot.key.load(std::memory_order_relaxed) != 0)
+            continue;
+        // Published before the key, so a response to this request probes far enough to find it
+        auto max_distance = m_max_probe_distance.load(std::memory_order_relaxed);
+        while (distance > max_distance && !m_max_probe_distance.compare_exchange_weak(max_distance, distance, std::memory_order_release)) { }
+        slot.completed = false;
+        slot.waiter = nullptr;
+        slot.key.store(make_key(seq_num, cmd_id), std::memory_order_release);
+        m_requests.fetch_add(1, std::memory_order_relaxed);
+        return &slot;
+    }
+    m_table_full.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+std::optional<RequestResponse> PendingRequestTable::wait(Slot& slot, std::chrono::steady_clock::time_point deadline)
+{
+    std::unique_lock lock(slot.mutex);
+    if (!slot.completed_cv.wait_until(lock, deadline, [&] { return slot.completed; }))
+        return {};
+    slot.key.store(0, std::memory_order_release);
+    return slot.response;
+}
+
+void PendingRequestTable::cancel(Slot& slot)
+{
+    std::lock_guard lock(slot.mutex);
+    slot.key.store(0, std::memory_order_release);
+    m_timeouts.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool PendingRequestTable::set_waiter(Slot& slot, std::coroutine_handle<> waiter)
+{
+    std::lock_guard lock(slot.mutex);
+    if (slot.completed)
+        return false;
+    slot.waiter = waiter;
+    return true;
+}
+
+std::coroutine_handle<> PendingRequestTable::take_waiter(Slot& slot)
+{
+    std::lock_guard lock(slot.mutex);
+    if (slot.completed)
+        return nullptr;
+    return std::exchange(slot.waiter, nullptr);
+}
+
+std::optional<RequestResponse> PendingRequestTable::take_response(Slot& slot)
+{
+    std::lock_guard lock(slot.mutex);
+    if (!slot.completed)
+        return {};
+    slot.key.store(0, std::memory_order_release);
+    return slot.response;
+}
+
+bool PendingRequestTable::complete(u16 seq_num, CommandID cmd_id, std::span<const u8> payload)
+{
+    auto key = make_key(seq_num, cmd_id);
+    Slot* found = nullptr;
+    auto max_distance = m_max_probe_distance.load(std::memory_order_acquire);
+    for (usize distance = 0; distance <= max_distance; ++distance) {
+        auto& candidate = m_slots[(home_index(seq_num) + distance) % CAPACITY];
+        if (candidate.key.load(std::memory_order_acquire) == key) {
+            found = &candidate;
+            break;
+        }
+    }
+    if (!found)
+        return false;
+    auto& slot = *found;
+
+    std::coroutine_handle<> waiter;
+    {
+        std::lock_guard lock(slot.mutex);
+        // The request may have timed out in the meantime, or a duplicate response completed it already
+        if (slot.key.load(std::memory_order_relaxed) != key || slot.completed)
+            return false;
+        auto size = std::min(payload.size(), RequestResponse::MAX_PAYLOAD_SIZE);
+        memcpy(slot.response.payload.data(), payload.data(), size);
+        slot.response.payload_size = size;
+        slot.response.truncated = size < payload.size();
+        slot.response.received_at = std::chrono::steady_clock::now();
+        slot.completed = true;
+        waiter = std::exchange(slot.waiter, nullptr);
+    }
+    m_responses.fetch_add(1, std::memory_order_relaxed);
+    if (waiter)
+        waiter.resume();
+    else
+        slot.completed_cv.notify_one();
+    return true;
+}
+
+PendingRequestStatistics PendingRequestTable::get_statistics() const
+{
+    return { m_requests.load(std::memory_order_relaxed), m_responses.load(std::memory_order_relaxed),
+        m_timeouts.load(std::memory_order_relaxed), m_retransmits.load(std::memory_order_relaxed),
+        m_table_full.load(std::memory_order_relaxed) };
+}
+
+}
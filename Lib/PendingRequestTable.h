@@ -0,0 +1,99 @@
+#pragma once
+
+#include "DronePacket.h"
+#include "DroneStatistics.h"
+#include "Utils/Types.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <mutex>
+#include <optional>
+#include <span>
+
+namespace Tello {
+
+struct RequestResponse {
+    // Responses are short status and info replies, anything past this is cut off
+    static constexpr usize MAX_PAYLOAD_SIZE = 256;
+
+    std::array<u8, MAX_PAYLOAD_SIZE> payload {};
+    usize payload_size { 0 };
+    bool truncated { false };
+    // When the receive path took the response, for the round trip time
+    std::chrono::steady_clock::time_point received_at;
+
+    [[nodiscard]] std::span<const u8> data() const { return { payload.data(), payload_size }; }
+    // Replies start with a status byte, 0 meaning success
+    [[nodiscard]] bool success() const { return payload_size > 0 && payload[0] == 0; }
+};
+
+// Requests waiting for their response, keyed by sequence number. Every request has a slot of its own with
+// its own lock and condition variable, so a response only wakes up the thread waiting for it, and packets
+// nobody waits for are usually turned away by a single atomic load.
+class PendingRequestTable {
+public:
+    // Requests in flight at once
+    static constexpr usize CAPACITY = 128;
+
+    class Slot;
+
+    // Has to be called before the request is sent. A request starts looking for a free slot at its sequence
+    // number and probes onwards from there, so a request that is never answered only holds on to its own slot.
+    // Returns nullptr if all CAPACITY slots are taken.
+    Slot* begin(u16 seq_num, CommandID cmd_id);
+    // Waits for the response until the deadline. Frees the slot once the response arrived, on a timeout the
+    // request keeps waiting in its slot, so it can be resent with the same sequence number or cancelled.
+    std::optional<RequestResponse> wait(Slot& slot, std::chrono::steady_clock::time_point deadline);
+    // Gives up on the request and frees the slot
+    void cancel(Slot& slot);
+
+    // Coroutines wait by having the receive path resume them instead. Returns false if the response is
+    // already there, in which case the coroutine should not suspend.
+    bool set_waiter(Slot& slot, std::coroutine_handle<> waiter);
+    // For timeouts, returns the waiting coroutine unless the response got to it first
+    std::coroutine_handle<> take_waiter(Slot& slot);
+    // Frees the slot and returns the response if it arrived, keeps waiting otherwise
+    std::optional<RequestResponse> take_response(Slot& slot);
+    void record_retransmit() { m_retransmits.fetch_add(1, std::memory_order_relaxed); }
+
+    // From the receive path, returns false if no request is waiting for this packet. A waiting coroutine is
+    // resumed from here.
+    bool complete(u16 seq_num, CommandID cmd_id, std::span<const u8> payload);
+
+    [[nodiscard]] PendingRequestStatistics get_statistics() const;
+
+    class Slot {
+    private:
+        friend class PendingRequestTable;
+
+        // The seq_num and cmd_id of the request waiting in the slot, 0 while it is free
+        std::atomic<u64> key { 0 };
+        std::mutex mutex;
+        std::condition_variable completed_cv;
+        bool completed { false };
+        std::coroutine_handle<> waiter;
+        RequestResponse response;
+    };
+
+private:
+    static u64 make_key(u16 seq_num, CommandID cmd_id)
+    {
+        return (u64(1) << 32) | (u64(static_cast<u16>(cmd_id)) << 16) | seq_num;
+    }
+
+    static usize home_index(u16 seq_num) { return seq_num % CAPACITY; }
+
+    std::array<Slot, CAPACITY> m_slots;
+    // The furthest any request ever had to probe from its home slot, responses look no further than this
+    std::atomic<usize> m_max_probe_distance { 0 };
+
+    std::atomic<u64> m_requests { 0 };
+    std::atomic<u64> m_responses { 0 };
+    std::atomic<u64> m_timeouts { 0 };
+    std::atomic<u64> m_retransmits { 0 };
+    std::atomic<u64> m_table_full { 0 };
+};
+
+}
@@ -0,0 +1,79 @@
+#include "Retransmission.h"
+#include <algorithm>
+
+namespace Tello {
+
+RetransmitPolicy default_retransmit_policy(CommandID cmd_id)
+{
+    switch (cmd_id) {
+    case CommandID::GET_SSID:
+    case CommandID::GET_WIFI_PASSWORD:
+    case CommandID::GET_COUNTRY_CODE:
+    case CommandID::GET_BITRATE:
+    case CommandID::GET_FIRMWARE_VERSION:
+    case CommandID::GET_ACTIVATION_DATA:
+    case CommandID::GET_UNIQUE_IDENTIFIER:
+    case CommandID::GET_LOADER_VERSION:
+    case CommandID::GET_ACTIVATION_STATUS:
+    case CommandID::GET_FLIGHT_HEIGHT_LIMIT:
+    case CommandID::GET_LOW_BATTERY_WARNING:
+    case CommandID::GET_ATTITUDE_ANGLE:
+    case CommandID::SET_SSID:
+    case CommandID::SET_WIFI_PASSWORD:
+    case CommandID::SET_COUNTRY_CODE:
+    case CommandID::SET_BITRATE:
+    case CommandID::SET_AUTOMATIC_BITRATE:
+    case CommandID::SET_EIS:
+    case CommandID::SET_CAMERA_MODE:
+    case CommandID::SET_CAMERA_EV:
+    case CommandID::SET_PHOTO_QUALITY:
+    case CommandID::SET_FLIGHT_HEIGHT_LIMIT:
+    case CommandID::SET_LOW_BATTERY_WARNING:
+    case CommandID::SET_ATTITUDE_ANGLE:
+        return { 4 };
+    default:
+        return { 0 };
+    }
+}
+
+RoundTripEstimator::RoundTripEstimator(std::chrono::nanoseconds initial_timeout, std::chrono::nanoseconds min_timeout,
+    std::chrono::nanoseconds max_timeout)
+    : m_min_timeout(min_timeout)
+    , m_max_timeout(std::max(min_timeout, max_timeout))
+    , m_timeout(std::clamp(initial_timeout, m_min_timeout, m_max_timeout))
+{
+}
+
+void RoundTripEstimator::record(std::chrono::nanoseconds round_trip_time)
+{
+    std::lock_guard lock(m_mutex);
+    m_histogram.record(round_trip_time);
+    if (!m_has_sample) {
+        m_smoothed = round_trip_time;
+        m_variance = round_trip_time / 2;
+        m_has_sample = true;
+    } else {
+        // RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|, SRTT = 7/8 SRTT + 1/8 R
+        auto deviation = m_smoothed > round_trip_time ? m_smoothed - round_trip_time : round_trip_time - m_smoothed;
+        m_variance = (3 * m_variance + deviation) / 4;
+        m_smoothed = (7 * m_smoothed + round_trip_time) / 8;
+    }
+    m_timeout = std::clamp(m_smoothed + 4 * m_variance, m_min_timeout, m_max_timeout);
+}
+
+std::chrono::nanoseconds RoundTripEstimator::retransmit_timeout(u32 attempt) const
+{
+    std::lock_guard lock(m_mutex);
+    auto timeout = m_timeout;
+    for (u32 i = 0; i < attempt && timeout < m_max_timeout; ++i)
+        timeout *= 2;
+    return std::min(timeout, m_max_timeout);
+}
+
+RoundTripStatistics RoundTripEstimator::get_statistics() const
+{
+    std::lock_guard lock(m_mutex);
+    return { m_histogram.summary(), m_smoothed, m_variance, m_timeout };
+}
+
+}
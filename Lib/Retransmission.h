@@ -0,0 +1,58 @@
+#pragma once
+
+#include "DronePacket.h"
+#include "Utils/LatencyHistogram.h"
+#include "Utils/Types.h"
+#include <chrono>
+#include <mutex>
+
+namespace Tello {
+
+struct RetransmitPolicy {
+    // Resends of a request whose response did not arrive within the retransmit timeout. Only safe for requests
+    // the drone may handle twice, 0 waits for the whole DroneConfig::ack_timeout instead.
+    u8 max_retransmits { 0 };
+};
+
+// Queries and setters are idempotent and retransmitted, actions like taking off or flipping are not, as a
+// lost response would make the drone do them twice
+RetransmitPolicy default_retransmit_policy(CommandID cmd_id);
+
+struct RoundTripStatistics {
+    // Requests answered without being retransmitted, retransmitted ones are ambiguous (Karn's algorithm)
+    LatencySummary round_trip_time;
+    std::chrono::nanoseconds smoothed_round_trip_time {};
+    std::chrono::nanoseconds round_trip_time_variance {};
+    std::chrono::nanoseconds retransmit_timeout {};
+};
+
+// Smoothed round trip time and retransmit timeout of a link, as TCP estimates them (RFC 6298)
+class RoundTripEstimator {
+public:
+    RoundTripEstimator(std::chrono::nanoseconds initial_timeout, std::chrono::nanoseconds min_timeout,
+        std::chrono::nanoseconds max_timeout);
+
+    void record(std::chrono::nanoseconds round_trip_time);
+    // Time to wait for the response before the `attempt`th resend, doubling with every attempt
+    [[nodiscard]] std::chrono::nanoseconds retransmit_timeout(u32 attempt = 0) const;
+
+    [[nodiscard]] RoundTripStatistics get_statistics() const;
+    void reset_histogram()
+    {
+        std::lock_guard lock(m_mutex);
+        m_histogram.reset();
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::chrono::nanoseconds m_min_timeout;
+    std::chrono::nanoseconds m_max_timeout;
+    bool m_has_sample { false };
+    std::chrono::nanoseconds m_smoothed {};
+    std::chrono::nanoseconds m_variance {};
+    std::chrono::nanoseconds m_timeout;
+    // Written under m_mutex, so it still has a single writer at a time
+    LatencyHistogram m_histogram;
+};
+
+}
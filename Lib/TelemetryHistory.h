@@ -0,0 +1,220 @@
+#pragma once
+
+#include "Utils/Types.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <span>
+
+namespace Tello {
+
+enum class FlightDataColumn : u8 {
+    Height,
+    NorthSpeed,
+    EastSpeed,
+    GroundSpeed,
+    BatteryPercentage,
+    Count,
+};
+
+enum class MVODataColumn : u8 {
+    VelocityX,
+    VelocityY,
+    VelocityZ,
+    PositionX,
+    PositionY,
+    PositionZ,
+    Count,
+};
+
+enum class IMUDataColumn : u8 {
+    QuaternionW,
+    QuaternionX,
+    QuaternionY,
+    QuaternionZ,
+    Count,
+};
+
+// Samples [begin, end), by their position among every sample ever recorded to the history
+struct TelemetryRange {
+    u64 begin { 0 };
+    u64 end { 0 };
+
+    [[nodiscard]] usize size() const { return end - begin; }
+    [[nodiscard]] bool empty() const { return begin == end; }
+};
+
+// The latest samples of one telemetry stream, one ring per column (and one of steady clock timestamps in
+// nanoseconds), so analytics get the values of one column without the rest of each sample.
+//
+// Written by the cmd receive thread only, queried from any thread without locking. The rings hold relaxed
+// atomics, so readers copy samples out rather than pointing into the ring. As with Seqlock, a copy that races
+// with the writer overwriting it is reported rather than a data race. A range stays intact for a few thousand
+// samples after it fell out of the kept ones (the ring has spare slots beyond the capacity).
+template<typename Column>
+class TelemetryHistory {
+public:
+    static constexpr usize COLUMN_COUNT = static_cast<usize>(Column::Count);
+    using Row = std::array<float, COLUMN_COUNT>;
+
+    // Keeps `capacity` samples. Time lookups go through an index with one entry per `index_resolution`,
+    // which covers `capacity` resolutions back, lookups older than that binary search instead.
+    TelemetryHistory(usize capacity, std::chrono::nanoseconds index_resolution)
+        : m_capacity(capacity)
+        , m_slot_count(capacity + std::max<usize>(capacity / 8, MIN_SPARE_SLOTS))
+        , m_index_resolution(std::max<i64>(index_resolution.count(), 1))
+        , m_timestamps(std::make_unique<std::atomic<i64>[]>(m_slot_count))
+        , m_columns(std::make_unique<std::atomic<float>[]>(m_slot_count * COLUMN_COUNT))
+        , m_time_index(std::make_unique<std::atomic<u64>[]>(std::max<usize>(capacity, 1)))
+    {
+    }
+
+    TelemetryHistory(const TelemetryHistory&) = delete;
+    TelemetryHistory& operator=(const TelemetryHistory&) = delete;
+
+    // Writer side. Timestamps that go backwards (kernel timestamps of separate batches may) are clamped to the
+    // previous one, so the timestamp column stays sorted.
+    void record(std::chrono::steady_clock::time_point timestamp, const Row& row)
+    {
+        if (m_capacity == 0)
+            return;
+        auto end = m_end.load(std::memory_order_relaxed);
+        auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+        if (end == 0)
+            m_origin = time;
+        time = std::max(time, m_last_time);
+        m_last_time = time;
+
+        // Announced before the slot is touched, so a reader that copied any of the new values also sees this
+        m_writing.store(end, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        auto slot = end % m_slot_count;
+        m_timestamps[slot].store(time, std::memory_order_relaxed);
+        for (usize column = 0; column < COLUMN_COUNT; ++column)
+            m_columns[column * m_slot_count + slot].store(row[column], std::memory_order_relaxed);
+
+        // Every bucket since the previous sample's starts with this one, a gap longer than the whole index
+        // only fills in the last index_size buckets
+        u64 bucket = (time - m_origin) / m_index_resolution;
+        auto next_bucket = m_next_bucket.load(std::memory_order_relaxed);
+        if (bucket >= next_bucket) {
+            for (auto b = std::max(next_bucket, bucket + 1 - std::min<u64>(bucket + 1, m_capacity)); b <= bucket; ++b)
+                m_time_index[b % m_capacity].store(end, std::memory_order_relaxed);
+            m_next_bucket.store(bucket + 1, std::memory_order_relaxed);
+        }
+        m_end.store(end + 1, std::memory_order_release);
+    }
+
+    [[nodiscard]] usize capacity() const { return m_capacity; }
+    // Every sample recorded so far, including the ones that are not kept anymore
+    [[nodiscard]] u64 recorded() const { return m_end.load(std::memory_order_acquire); }
+
+    // The samples timestamped within [from, to) that are still kept
+    [[nodiscard]] TelemetryRange range(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) const
+    {
+        auto end = m_end.load(std::memory_order_acquire);
+        auto begin = lower_bound(from, end);
+        return { begin, std::max(begin, lower_bound(to, end)) };
+    }
+
+    // The latest `count` samples, fewer if not that many are kept
+    [[nodiscard]] TelemetryRange latest(usize count) const
+    {
+        auto end = m_end.load(std::memory_order_acquire);
+        return { end - std::min<u64>({ count, end, m_capacity }), end };
+    }
+
+    // Copies the range into `out`, which has to hold range.size() values. False if the writer started writing
+    // over the range meanwhile, which leaves `out` meaningless.
+    [[nodiscard]] bool copy_column(Column column, TelemetryRange range, std::span<float> out) const
+    {
+        return copy_ring(m_columns.get() + static_cast<usize>(column) * m_slot_count, range, out);
+    }
+
+    // Steady clock time since epoch in nanoseconds
+    [[nodiscard]] bool copy_timestamps(TelemetryRange range, std::span<i64> out) const
+    {
+        return copy_ring(m_timestamps.get(), range, out);
+    }
+
+    // Whether the writer started writing over the range, making what was copied from it meaningless
+    [[nodiscard]] bool overwritten(TelemetryRange range) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return m_writing.load(std::memory_order_relaxed) >= range.begin + m_slot_count;
+    }
+
+private:
+    static constexpr usize MIN_SPARE_SLOTS = 64;
+    // Samples the index may leave to scan before binary searching the rest
+    static constexpr usize MAX_LINEAR_SCAN = 16;
+
+    template<typename T>
+    bool copy_ring(const std::atomic<T>* ring, TelemetryRange range, std::span<T> out) const
+    {
+        assert(out.size() >= range.size());
+        auto first = range.begin % m_slot_count;
+        auto until_wrap = std::min<usize>(range.size(), m_slot_count - first);
+        for (usize i = 0; i < until_wrap; ++i)
+            out[i] = ring[first + i].load(std::memory_order_relaxed);
+        for (usize i = until_wrap; i < range.size(); ++i)
+            out[i] = ring[i - until_wrap].load(std::memory_order_relaxed);
+        return !overwritten(range);
+    }
+
+    i64 timestamp_at(u64 sample) const { return m_timestamps[sample % m_slot_count].load(std::memory_order_relaxed); }
+
+    // The first kept sample timestamped at or after `timestamp`, `end` if there is none. A search racing with
+    // the writer may be off, which copying the range then reports.
+    u64 lower_bound(std::chrono::steady_clock::time_point timestamp, u64 end) const
+    {
+        auto oldest = end - std::min<u64>(end, m_capacity);
+        if (oldest == end)
+            return end;
+        auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+        if (time <= timestamp_at(oldest))
+            return oldest;
+
+        // The index gives the first sample of the time's bucket, as long as the writer did not move on far
+        // enough to reuse the entry since `end` was read, which the sample before it being older tells
+        u64 first = oldest;
+        u64 bucket = (time - m_origin) / m_index_resolution;
+        auto next_bucket = m_next_bucket.load(std::memory_order_relaxed);
+        if (bucket < next_bucket && bucket + m_capacity >= next_bucket) {
+            auto indexed = m_time_index[bucket % m_capacity].load(std::memory_order_relaxed);
+            if (indexed > oldest && indexed <= end && timestamp_at(indexed - 1) < time)
+                first = indexed;
+        }
+        for (usize i = 0; i < MAX_LINEAR_SCAN && first != end && timestamp_at(first) < time; ++i)
+            ++first;
+        auto last = end;
+        while (first < last) {
+            auto middle = first + (last - first) / 2;
+            if (timestamp_at(middle) < time)
+                first = middle + 1;
+            else
+                last = middle;
+        }
+        return first;
+    }
+
+    const usize m_capacity;
+    const usize m_slot_count;
+    const i64 m_index_resolution;
+    std::unique_ptr<std::atomic<i64>[]> m_timestamps;
+    std::unique_ptr<std::atomic<float>[]> m_columns;
+    // First sample at or after the start of every bucket of m_index_resolution since m_origin
+    std::unique_ptr<std::atomic<u64>[]> m_time_index;
+    std::atomic<u64> m_next_bucket { 0 };
+    std::atomic<u64> m_end { 0 };
+    // The sample the writer is writing or wrote last
+    std::atomic<u64> m_writing { 0 };
+    // Written before the first sample is published and never again
+    i64 m_origin { 0 };
+    i64 m_last_time { 0 };
+};
+
+}
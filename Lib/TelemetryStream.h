@@ -0,0 +1,101 @@
+#pragma once
+
+#include "DroneData.h"
+#include "Utils/Seqlock.h"
+#include "Utils/Types.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace Tello {
+
+// The latest sample of one telemetry stream plus whoever wants to hear about new ones. Published to by the cmd
+// receive thread only; with nobody subscribed or waiting a publish is a Seqlock store and two atomic loads.
+template<typename T>
+class TelemetryStream {
+public:
+    using Callback = std::function<void(const TelemetrySnapshot<T>&)>;
+
+    void publish(const TelemetrySnapshot<T>& snapshot)
+    {
+        m_latest.store(snapshot);
+        // Pairs with the fence in wait_for_next: either the waiter sees the new version or we see the waiter
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiter_count.load(std::memory_order_relaxed) > 0) {
+            { std::lock_guard lock(m_waiters_mutex); }
+            m_waiters_cv.notify_all();
+        }
+        if (m_subscriber_count.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard lock(m_subscribers_mutex);
+            for (auto& subscriber : m_subscribers)
+                subscriber.callback(snapshot);
+        }
+    }
+
+    // Never waits for the writer
+    [[nodiscard]] TelemetrySnapshot<T> latest() const { return m_latest.load(); }
+
+    // Callbacks run on the cmd receive thread for every sample, in order. Once unsubscribing returns the
+    // callback is not running anymore, so callbacks must not subscribe or unsubscribe themselves.
+    u32 subscribe(Callback callback)
+    {
+        std::lock_guard lock(m_subscribers_mutex);
+        auto id = m_next_subscription_id++;
+        m_subscribers.push_back({ id, std::move(callback) });
+        m_subscriber_count.store(m_subscribers.size(), std::memory_order_relaxed);
+        return id;
+    }
+
+    void unsubscribe(u32 subscription_id)
+    {
+        std::lock_guard lock(m_subscribers_mutex);
+        std::erase_if(m_subscribers, [&](auto& subscriber) { return subscriber.id == subscription_id; });
+        m_subscriber_count.store(m_subscribers.size(), std::memory_order_relaxed);
+    }
+
+    // Waits for a sample newer than `after_version` and returns the latest one, nothing if none arrived before
+    // the deadline. Pass the version of the previous sample: a gap between the two versions is the number of
+    // samples that were missed in between.
+    [[nodiscard]] std::optional<TelemetrySnapshot<T>> wait_for_next(u64 after_version,
+        std::chrono::steady_clock::time_point deadline)
+    {
+        auto snapshot = m_latest.load();
+        if (snapshot.version > after_version)
+            return snapshot;
+        m_waiter_count.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::unique_lock lock(m_waiters_mutex);
+        bool published = m_waiters_cv.wait_until(lock, deadline, [&] {
+            snapshot = m_latest.load();
+            return snapshot.version > after_version;
+        });
+        lock.unlock();
+        m_waiter_count.fetch_sub(1, std::memory_order_relaxed);
+        if (!published)
+            return {};
+        return snapshot;
+    }
+
+private:
+    struct Subscriber {
+        u32 id;
+        Callback callback;
+    };
+
+    Seqlock<TelemetrySnapshot<T>> m_latest;
+
+    std::mutex m_subscribers_mutex;
+    std::vector<Subscriber> m_subscribers;
+    u32 m_next_subscription_id { 1 };
+    std::atomic<usize> m_subscriber_count { 0 };
+
+    std::mutex m_waiters_mutex;
+    std::condition_variable m_waiters_cv;
+    std::atomic<u32> m_waiter_count { 0 };
+};
+
+}
@@ -1,5 +1,7 @@
 #include "TelloDrone.h"
 #include "Utils/StringHelpers.h"
+#include <algorithm>
+#include <bit>
 #include <cassert>
 #include <chrono>
 #include <cstdio>
@@ -13,195 +15,415 @@
 
 namespace Tello {
 
-static constexpr u16 TELLO_CMD_PORT = 8889;
-static constexpr u16 TELLO_VIDEO_PORT = 7777;
-static constexpr char const* TELLO_CMD_IP = "192.168.10.1";
-static constexpr u16 FFMPEG_PORT = 9999;
-static constexpr char const* FFMPEG_IP = "127.0.0.1";
-static constexpr std::chrono::seconds PACKET_ACK_TIMEOUT = std::chrono::seconds(10);
+static constexpr usize RECEIVE_BUFFER_SIZE = 4096;
 
-Drone::Drone()
+// Kernel receive timestamps are on the realtime clock, so they are moved over to the steady clock by how long
+// before `system_now` they were taken
+static std::chrono::steady_clock::time_point to_steady_time(std::optional<std::chrono::system_clock::time_point> timestamp,
+    std::chrono::steady_clock::time_point steady_now, std::chrono::system_clock::time_point system_now)
+{
+    if (!timestamp || *timestamp > system_now)
+        return steady_now;
+    return steady_now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(system_now - *timestamp);
+}
+
+// Whole control ticks in `interval`, at least one so that nothing is sent on every tick
+static u32 ticks_in(std::chrono::milliseconds interval, std::chrono::milliseconds control_tick)
+{
+    return static_cast<u32>(std::max<i64>(interval / control_tick, 1));
+}
+
+Drone::Drone(DroneConfig config)
+    : Drone(std::move(config), true)
+{
+}
+
+Drone::Drone(DroneConfig config, bool spawn_threads)
+    : m_config(std::move(config))
+    , m_threads_spawned(spawn_threads)
+    , m_cmd_batch(m_config.receive_batch_depth, RECEIVE_BUFFER_SIZE)
+    , m_round_trip_estimator(m_config.initial_retransmit_timeout, m_config.min_retransmit_timeout,
+          m_config.max_retransmit_timeout)
+    , m_video_batch(m_config.receive_batch_depth, RECEIVE_BUFFER_SIZE)
+    , m_frame_pool(FramePool::create({ .buffer_count = m_config.video_frame_pool_size,
+          .max_frame_size = m_config.max_video_frame_size }))
+    , m_video_reassembler(m_frame_pool, m_config.video_reassembly_window,
+          [this](VideoFrame frame) { handle_video_frame(std::move(frame)); })
+    , m_flight_data_history(m_config.telemetry_history_capacity, m_config.telemetry_history_resolution)
+    , m_mvo_data_history(m_config.telemetry_history_capacity, m_config.telemetry_history_resolution)
+    , m_imu_data_history(m_config.telemetry_history_capacity, m_config.telemetry_history_resolution)
+{
+    if (m_config.control_tick <= std::chrono::milliseconds::zero()) {
+        std::cerr << "DroneConfig::control_tick has to be positive" << std::endl;
+        return;
+    }
+    m_timed_request_interval_ticks = ticks_in(m_config.timed_request_interval, m_config.control_tick);
+    m_keyframe_request_interval_ticks = ticks_in(m_config.keyframe_request_interval, m_config.control_tick);
+
+    if (!open_sockets())
+        return;
+    m_initialized = true;
+
+    if (m_config.forward_video)
+        subscribe_video_frames([this](const VideoFrame& frame) { forward_video_frame(frame); });
+
+    if (spawn_threads) {
+        m_video_receive_thread = std::thread(&Drone::video_receive_thread_routine, this);
+        m_cmd_receive_thread = std::thread(&Drone::cmd_receive_thread_routine, this);
+        m_drone_controls_thread = std::thread(&Drone::drone_controls_thread_routine, this);
+    }
+
+    send_setup_packet();
+}
+
+bool Drone::open_sockets()
 {
     m_video_socket_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
     if (m_video_socket_fd == -1) {
         perror("socket() -> m_video_socket_fd");
-        exit(1);
+        return false;
     }
+    if (!bind_socket(m_video_socket_fd, m_config.video_port, "m_video_socket_fd"))
+        return false;
     sockaddr_in video_receive_addr {};
-    video_receive_addr.sin_family = AF_INET;
-    video_receive_addr.sin_addr.s_addr = INADDR_ANY;
-    video_receive_addr.sin_port = htons(TELLO_VIDEO_PORT);
-    if (bind(m_video_socket_fd, reinterpret_cast<sockaddr*>(&video_receive_addr), sizeof(sockaddr_in)) < 0) {
-        perror("bind(m_video_socket_fd)");
-        exit(1);
-    }
-    timeval sock_timeout {};
-    sock_timeout.tv_sec = 1;
-    sock_timeout.tv_usec = 0;
-    if (setsockopt(m_video_socket_fd, SOL_SOCKET, SO_RCVTIMEO, (char*)&sock_timeout, sizeof(sock_timeout)) < 0) {
-        perror("setsockopt()");
-        exit(1);
+    socklen_t video_receive_addr_size = sizeof(video_receive_addr);
+    if (getsockname(m_video_socket_fd, reinterpret_cast<sockaddr*>(&video_receive_addr), &video_receive_addr_size) < 0) {
+        perror("getsockname(m_video_socket_fd)");
+        return false;
     }
+    m_video_port = ntohs(video_receive_addr.sin_port);
 
-    m_ffmpeg_socket_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-    if (m_ffmpeg_socket_fd == -1) {
-        perror("socket() -> m_ffmpeg_socket_fd");
-        exit(1);
+    if (m_config.forward_video) {
+        m_ffmpeg_socket_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (m_ffmpeg_socket_fd == -1) {
+            perror("socket() -> m_ffmpeg_socket_fd");
+            return false;
+        }
+        m_ffmpeg_addr.sin_family = AF_INET;
+        m_ffmpeg_addr.sin_port = htons(m_config.video_forward_port);
+        if (inet_pton(AF_INET, m_config.video_forward_ip.c_str(), &m_ffmpeg_addr.sin_addr) != 1) {
+            std::cerr << "Invalid video forwarding address `" << m_config.video_forward_ip << "`" << std::endl;
+            return false;
+        }
     }
-    m_ffmpeg_addr.sin_family = AF_INET;
-    m_ffmpeg_addr.sin_port = htons(FFMPEG_PORT);
-    m_ffmpeg_addr.sin_addr.s_addr = inet_addr(FFMPEG_IP);
 
     m_cmd_socket_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
     if (m_cmd_socket_fd == -1) {
         perror("socket() -> m_cmd_socket_fd");
-        exit(1);
+        return false;
     }
+    if (!bind_socket(m_cmd_socket_fd, 0, "m_cmd_socket_fd"))
+        return false;
     m_cmd_addr.sin_family = AF_INET;
-    m_cmd_addr.sin_port = htons(TELLO_CMD_PORT);
-    m_cmd_addr.sin_addr.s_addr = inet_addr(TELLO_CMD_IP);
+    m_cmd_addr.sin_port = htons(m_config.drone_cmd_port);
+    if (inet_pton(AF_INET, m_config.drone_ip.c_str(), &m_cmd_addr.sin_addr) != 1) {
+        std::cerr << "Invalid drone address `" << m_config.drone_ip << "`" << std::endl;
+        return false;
+    }
+
+    return true;
+}
 
-    if (setsockopt(m_cmd_socket_fd, SOL_SOCKET, SO_RCVTIMEO, (char*)&sock_timeout, sizeof(sock_timeout)) < 0) {
-        perror("setsockopt()");
-        exit(1);
+bool Drone::bind_socket(int socket_fd, u16 port, char const* socket_name)
+{
+    if (!m_config.bind_interface.empty()) {
+        if (setsockopt(socket_fd, SOL_SOCKET, SO_BINDTODEVICE, m_config.bind_interface.c_str(), m_config.bind_interface.size()) < 0) {
+            perror((std::string("setsockopt(") + socket_name + ", SO_BINDTODEVICE)").c_str());
+            return false;
+        }
     }
 
-    m_video_receive_thread = std::thread(&Drone::video_receive_thread_routine, this);
-    m_cmd_receive_thread = std::thread(&Drone::cmd_receive_thread_routine, this);
-    m_drone_controls_thread = std::thread(&Drone::drone_controls_thread_routine, this);
+    sockaddr_in bind_addr {};
+    bind_addr.sin_family = AF_INET;
+    bind_addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, m_config.bind_ip.c_str(), &bind_addr.sin_addr) != 1) {
+        std::cerr << "Invalid bind address `" << m_config.bind_ip << "`" << std::endl;
+        return false;
+    }
+    if (bind(socket_fd, reinterpret_cast<sockaddr*>(&bind_addr), sizeof(sockaddr_in)) < 0) {
+        perror((std::string("bind(") + socket_name + ")").c_str());
+        return false;
+    }
 
-    send_setup_packet();
+    int enable_timestamps = 1;
+    if (m_config.receive_timestamps
+        && setsockopt(socket_fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable_timestamps, sizeof(enable_timestamps)) < 0) {
+        // Not fatal, datagrams are then timestamped when they are received in userspace
+        perror((std::string("setsockopt(") + socket_name + ", SO_TIMESTAMPNS)").c_str());
+    }
+
+    auto timeout_us = std::chrono::duration_cast<std::chrono::microseconds>(m_config.receive_timeout).count();
+    timeval sock_timeout {};
+    sock_timeout.tv_sec = timeout_us / 1'000'000;
+    sock_timeout.tv_usec = timeout_us % 1'000'000;
+    if (setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, (char*)&sock_timeout, sizeof(sock_timeout)) < 0) {
+        perror((std::string("setsockopt(") + socket_name + ", SO_RCVTIMEO)").c_str());
+        return false;
+    }
+    return true;
 }
 
 void Drone::video_receive_thread_routine()
 {
-    std::vector<u8> current_frame;
-    usize current_frame_num = 0;
-    isize last_segment_num_received = -1;
-    bool discard_current_frame = false;
-    bool received_sequence_parameter_set = false;
-    u8 frames_since_last_SPS_request = 0;
+    while (!m_shutting_down)
+        receive_video_packets(0);
+}
 
-    u8 packet_buffer[4096];
-    while (!m_shutting_down) {
-        isize bytes_received = recvfrom(m_video_socket_fd, packet_buffer, sizeof(packet_buffer), 0, nullptr,
-            nullptr);
+bool Drone::receive_video_packets(int flags)
+{
+    if (m_video_batch.receive(m_video_socket_fd, flags) < 0) {
+        if (errno != EAGAIN)
+            std::cerr << "Failed to receive bytes from video socket, errno: " << strerror(errno) << std::endl;
+        return false;
+    }
 
-        if (bytes_received < 0) {
-            if (errno != EAGAIN)
-                std::cerr << "Failed to receive bytes from video socket, errno: " << strerror(errno) << std::endl;
-            continue;
-        }
+    auto steady_now = std::chrono::steady_clock::now();
+    auto system_now = std::chrono::system_clock::now();
+    auto capture = get_packet_capture();
+    usize bytes_received = 0;
+    for (usize i = 0; i < m_video_batch.size(); ++i) {
+        auto segment = m_video_batch.datagram(i);
+        bytes_received += segment.size();
+        if (capture)
+            capture->append(CaptureSource::VideoSocket, m_video_batch.timestamp(i).value_or(system_now), segment);
+        auto receive_time = to_steady_time(m_video_batch.timestamp(i), steady_now, system_now);
+        m_video_latency_histograms.segment_receive.record(steady_now - receive_time);
+        m_video_reassembler.add_segment(segment, receive_time);
+    }
+    m_video_socket_counters.record_receive(m_video_batch.size(), bytes_received);
+    return true;
+}
 
-        if (bytes_received < 2) {
-            if constexpr (VIDEO_DEBUG_LOGGING)
-                std::cerr << "Received invalid video packet, less than 2 bytes of data!" << std::endl;
-            continue;
-        }
+void Drone::handle_video_frame(VideoFrame frame)
+{
+    if (m_last_video_frame_num >= 0) {
+        u8 lost_frames = frame.frame_num() - m_last_video_frame_num - 1;
+        if (lost_frames != 0)
+            m_h264_parser.note_lost_frames(lost_frames);
+    }
+    m_last_video_frame_num = frame.frame_num();
+
+    auto parameter_sets_version = m_h264_parser.parameter_sets_version();
+    auto access_unit = m_h264_parser.parse_access_unit(frame.data());
+    if (m_h264_parser.parameter_sets_version() != parameter_sets_version) {
+        if constexpr (VIDEO_DEBUG_LOGGING)
+            std::cout << "Received new video parameter sets" << std::endl;
+        std::lock_guard lock(m_video_stream_info_mutex);
+        m_video_stream_info = m_h264_parser.stream_info();
+    }
+    if (access_unit.has_idr_slice) {
+        increment_counter(m_video_stream_counters.idr_frames_received);
+        m_keyframe_requested = false;
+    }
+    if (access_unit.lost_reference) {
+        if constexpr (VIDEO_DEBUG_LOGGING)
+            std::cout << "Lost a reference frame before frame " << static_cast<int>(frame.frame_num()) << std::endl;
+        increment_counter(m_video_stream_counters.reference_losses);
+    }
+    m_keyframe_needed = !m_h264_parser.is_decodable();
 
-        int frame_num = packet_buffer[0];
-        auto segment_num = packet_buffer[1] & 127;
-        auto last_segment_in_frame = (packet_buffer[1] & 128) == 128;
-
-        if constexpr (VERBOSE_VIDEO_DEBUG_LOGGING)
-            std::cout << "Got segment " << segment_num << " of frame " << frame_num << " (end="
-                      << last_segment_in_frame
-                      << "), last was " << last_segment_num_received << " of frame " << current_frame_num
-                      << std::endl;
-
-        if (frame_num != current_frame_num) {
-            if constexpr (VERBOSE_VIDEO_DEBUG_LOGGING)
-                std::cout << "Lost segments on frame boundary " << current_frame_num << ':' << frame_num
-                          << std::endl;
-            // Seems like we lost part of the last frame, so we'll have to discard it
-
-            current_frame_num = frame_num;
-            // Fixup the `last_segment_num_received` counter so we won't also detect an intra-frame
-            last_segment_num_received = segment_num - 1;
-
-            if (segment_num != 0) {
-                // We also lost some frames in this next frame, so we'll have to discard it too
-                discard_current_frame = true;
-            } else {
-                // If by chance we did not skip any segments in the next frame, we don't have to discard it too
-                current_frame.clear();
-            }
-        }
+    // Parameter sets and SEI on their own are always passed on, pictures only if they can be decoded
+    if ((access_unit.has_idr_slice || access_unit.has_non_idr_slice) && !access_unit.decodable) {
+        increment_counter(m_video_stream_counters.frames_skipped_undecodable);
+        return;
+    }
 
-        if (((last_segment_num_received + 1) & 127) != segment_num) {
-            if constexpr (VERBOSE_VIDEO_DEBUG_LOGGING)
-                std::cout << "Lost segments of frame " << current_frame_num << std::endl;
-            // Seems like we lost part of this frame, discard it
-            discard_current_frame = true;
-        }
+    auto& timestamps = frame.timestamps();
+    auto delivery_time = std::chrono::steady_clock::now();
+    m_video_latency_histograms.frame_span.record(timestamps.last_segment - timestamps.first_segment);
+    m_video_latency_histograms.reassembly.record(timestamps.reassembled - timestamps.last_segment);
+    m_video_latency_histograms.delivery.record(delivery_time - timestamps.reassembled);
+    m_video_latency_histograms.end_to_end.record(delivery_time - timestamps.first_segment);
 
-        last_segment_num_received = segment_num;
-        if (!discard_current_frame) [[likely]] {
-            current_frame.reserve(current_frame.size() + bytes_received - 2);
-            current_frame.insert(current_frame.end(), packet_buffer + 2, packet_buffer + bytes_received);
-        }
+    std::lock_guard lock(m_video_subscribers_mutex);
+    for (auto& subscriber : m_video_subscribers)
+        subscriber.callback(frame);
+}
 
-        if (last_segment_in_frame) {
-            if (!discard_current_frame) {
-                if constexpr (VIDEO_DEBUG_LOGGING)
-                    std::cout << "Finished receiving full frame" << std::endl;
-
-                if (current_frame[0] == 0x00 && current_frame[1] == 0x00 && current_frame[2] == 0x00 && current_frame[3] == 0x01) { // NAL Unit Start Code Prefix
-                    u8 nal_type = current_frame[4] & 0x1F;
-                    if (nal_type == 7) {
-                        if constexpr (VERBOSE_VIDEO_DEBUG_LOGGING)
-                            std::cout << "Received sequence parameter set" << std::endl;
-                        received_sequence_parameter_set = true;
-                    }
-                }
-                if (received_sequence_parameter_set) {
-                    sendto(m_ffmpeg_socket_fd, current_frame.data(), current_frame.size(), 0,
-                        reinterpret_cast<const sockaddr*>(&m_ffmpeg_addr), sizeof(m_ffmpeg_addr));
-                } else {
-                    if (frames_since_last_SPS_request == 8) {
-                        if constexpr (VERBOSE_VIDEO_DEBUG_LOGGING)
-                            std::cout << "Requesting sequence parameter set" << std::endl;
-                        queue_packet(DronePacket(DronePacket(96, CommandID::REQUEST_VIDEO_SPS_PPS_HEADERS)));
-                        frames_since_last_SPS_request = 0;
-                    }
-                    frames_since_last_SPS_request++;
-                }
-            }
+void Drone::forward_video_frame(const VideoFrame& frame)
+{
+    auto data = frame.data();
+    sendto(m_ffmpeg_socket_fd, data.data(), data.size(), 0, reinterpret_cast<const sockaddr*>(&m_ffmpeg_addr),
+        sizeof(m_ffmpeg_addr));
+}
 
-            current_frame.clear();
-            current_frame_num = (current_frame_num + 1) & 255;
-            last_segment_num_received = -1;
-            discard_current_frame = false;
-        }
+void Drone::reset_latency_statistics()
+{
+    m_video_latency_histograms.reset();
+    m_cmd_receive_latency_histogram.reset();
+    m_round_trip_estimator.reset_histogram();
+}
+
+std::optional<H264SequenceParameterSet> Drone::get_video_stream_info()
+{
+    std::lock_guard lock(m_video_stream_info_mutex);
+    return m_video_stream_info;
+}
+
+u32 Drone::subscribe_video_frames(VideoFrameCallback callback)
+{
+    auto id = m_next_video_subscription_id++;
+    std::lock_guard lock(m_video_subscribers_mutex);
+    m_video_subscribers.push_back({ id, std::move(callback) });
+    return id;
+}
+
+u32 Drone::subscribe_video_frames(std::shared_ptr<VideoFrameQueue> queue)
+{
+    auto id = m_next_video_subscription_id++;
+    {
+        // Recorded before the push callback is visible, or a close_video_queues() in between would miss the queue
+        // and leave a Block policy push waiting forever
+        std::lock_guard lock(m_video_queue_subscribers_mutex);
+        if (m_video_queues_closed)
+            queue->close();
+        else
+            m_video_queue_subscribers.push_back({ id, queue });
+    }
+    std::lock_guard lock(m_video_subscribers_mutex);
+    m_video_subscribers.push_back({ id, [queue](const VideoFrame& frame) { queue->push(frame); } });
+    return id;
+}
+
+void Drone::close_video_queues(std::optional<u32> subscription_id)
+{
+    std::lock_guard lock(m_video_queue_subscribers_mutex);
+    m_video_queues_closed |= !subscription_id;
+    std::erase_if(m_video_queue_subscribers, [&](auto& subscriber) {
+        if (subscription_id && subscriber.first != *subscription_id)
+            return false;
+        subscriber.second->close();
+        return true;
+    });
+}
+
+void Drone::unsubscribe_video_frames(u32 subscription_id)
+{
+    // A Block policy push may be waiting for the consumer while holding m_video_subscribers_mutex, closing the
+    // queue first lets it return
+    close_video_queues(subscription_id);
+    std::lock_guard lock(m_video_subscribers_mutex);
+    std::erase_if(m_video_subscribers, [&](auto& subscriber) { return subscriber.id == subscription_id; });
+}
+
+std::shared_ptr<VideoRecorder> Drone::start_recording(VideoRecorderConfig config)
+{
+    stop_recording();
+    std::shared_ptr<VideoRecorder> recorder = VideoRecorder::open(std::move(config));
+    if (!recorder)
+        return nullptr;
+
+    std::lock_guard lock(m_video_recorder_mutex);
+    m_video_recorder = recorder;
+    m_recording_keyframe_needed = true;
+    m_video_recorder_subscription_id = subscribe_video_frames(
+        [this, recorder, parameter_sets_passed = false](const VideoFrame& frame) mutable {
+            // The parser is only safe to read from the video receive thread
+            if (!parameter_sets_passed && m_h264_parser.has_parameter_sets())
+                recorder->set_parameter_sets(m_h264_parser.sequence_parameter_set(), m_h264_parser.picture_parameter_set());
+            parameter_sets_passed = true;
+            recorder->record(frame);
+            m_recording_keyframe_needed = recorder->is_waiting_for_keyframe();
+        });
+    return recorder;
+}
+
+void Drone::stop_recording()
+{
+    std::shared_ptr<VideoRecorder> recorder;
+    {
+        std::lock_guard lock(m_video_recorder_mutex);
+        if (!m_video_recorder)
+            return;
+        unsubscribe_video_frames(m_video_recorder_subscription_id);
+        recorder = std::move(m_video_recorder);
     }
+    m_recording_keyframe_needed = false;
+    recorder->close();
+}
+
+std::shared_ptr<PacketCaptureWriter> Drone::start_capture(const std::string& path)
+{
+    stop_capture();
+    std::shared_ptr<PacketCaptureWriter> capture = PacketCaptureWriter::open(path);
+    if (!capture)
+        return nullptr;
+
+    std::lock_guard lock(m_packet_capture_mutex);
+    m_packet_capture = capture;
+    m_packet_capture_running.store(true, std::memory_order_release);
+    // A replay can only show the video from the first keyframe of the capture on
+    m_keyframe_requested = true;
+    return capture;
+}
+
+void Drone::stop_capture()
+{
+    std::shared_ptr<PacketCaptureWriter> capture;
+    {
+        std::lock_guard lock(m_packet_capture_mutex);
+        m_packet_capture_running.store(false, std::memory_order_relaxed);
+        capture = std::move(m_packet_capture);
+    }
+    // Appends from a receive thread still holding on to it are ignored from here on
+    if (capture)
+        capture->close();
+}
+
+std::shared_ptr<PacketCaptureWriter> Drone::get_packet_capture()
+{
+    // Called for every receive batch, so the common case of no capture must not take the mutex
+    if (!m_packet_capture_running.load(std::memory_order_acquire))
+        return nullptr;
+    std::lock_guard lock(m_packet_capture_mutex);
+    return m_packet_capture;
 }
 
 void Drone::cmd_receive_thread_routine()
 {
-    socklen_t cmd_addr_size = sizeof(m_cmd_addr);
-    u8 packet_buffer[4096];
-    while (!m_shutting_down) {
-        isize bytes_received = recvfrom(m_cmd_socket_fd, packet_buffer, sizeof(packet_buffer), 0,
-            reinterpret_cast<sockaddr*>(&m_cmd_addr), &cmd_addr_size);
-        if (bytes_received < 0) {
-            if (errno != EAGAIN)
-                std::cerr << "Failed to receive bytes from cmd socket, errno: " << strerror(errno) << std::endl;
-            continue;
-        }
+    while (!m_shutting_down)
+        receive_cmd_packets(0);
+}
+
+bool Drone::receive_cmd_packets(int flags)
+{
+    if (m_cmd_batch.receive(m_cmd_socket_fd, flags) < 0) {
+        if (errno != EAGAIN)
+            std::cerr << "Failed to receive bytes from cmd socket, errno: " << strerror(errno) << std::endl;
+        return false;
+    }
 
-        auto packet = DronePacket::deserialize(std::span<u8>(packet_buffer, bytes_received));
-        if (packet.has_value())
-            handle_packet(packet.value());
-        else if constexpr (DRONE_DEBUG_LOGGING)
-            std::cerr << "Failed to parse packet of length `" << bytes_received << "`" << std::endl;
+    auto steady_now = std::chrono::steady_clock::now();
+    auto system_now = std::chrono::system_clock::now();
+    auto capture = get_packet_capture();
+    usize bytes_received = 0;
+    for (usize i = 0; i < m_cmd_batch.size(); ++i) {
+        auto packet_bytes = m_cmd_batch.datagram(i);
+        bytes_received += packet_bytes.size();
+        if (capture)
+            capture->append(CaptureSource::CmdSocket, m_cmd_batch.timestamp(i).value_or(system_now), packet_bytes);
+        handle_cmd_datagram(packet_bytes, to_steady_time(m_cmd_batch.timestamp(i), steady_now, system_now));
     }
+    m_cmd_socket_counters.record_receive(m_cmd_batch.size(), bytes_received);
+    return true;
+}
+
+void Drone::handle_cmd_datagram(std::span<const u8> datagram, std::chrono::steady_clock::time_point receive_time)
+{
+    m_packet_receive_time = receive_time;
+    auto packet = DronePacketView::parse(datagram);
+    if (packet.has_value())
+        handle_packet(packet.value());
+    else if constexpr (DRONE_DEBUG_LOGGING)
+        std::cerr << "Failed to parse packet of length `" << datagram.size() << "`" << std::endl;
+    m_cmd_receive_latency_histogram.record(std::chrono::steady_clock::now() - receive_time);
 }
 
 void Drone::send_setup_packet()
 {
-    std::vector<u8> packet_bytes(2);
-    packet_bytes[0] = TELLO_VIDEO_PORT & 0xFF;
-    packet_bytes[1] = (TELLO_VIDEO_PORT >> 8) & 0xFF;
+    PacketPayload packet_bytes(2);
+    packet_bytes[0] = m_video_port & 0xFF;
+    packet_bytes[1] = (m_video_port >> 8) & 0xFF;
     queue_packet(DronePacket(0, CommandID::CONN_REQ, std::move(packet_bytes)));
 }
 
@@ -228,47 +450,71 @@ void Drone::send_initialization_sequence()
 
 void Drone::send_timed_requests_if_needed()
 {
-    if (m_timed_request_ticks >= 50) {
+    if (m_timed_request_ticks >= m_timed_request_interval_ticks) {
         m_timed_request_ticks = 0;
-        if (m_connected)
-            queue_packet(DronePacket(96, CommandID::REQUEST_VIDEO_SPS_PPS_HEADERS));
-        else
+        if (!m_connected) {
             send_setup_packet();
+        } else {
+            // No video for a whole interval means the stream stalled (or never started), a keyframe request restarts it
+            auto video_frames = m_video_reassembler.get_statistics().frames_completed;
+            if (m_config.periodic_keyframe_requests || video_frames == m_video_frames_at_last_timed_request)
+                request_keyframe();
+            m_video_frames_at_last_timed_request = video_frames;
+        }
     }
     m_timed_request_ticks++;
+
+    if (m_keyframe_request_ticks < m_keyframe_request_interval_ticks)
+        m_keyframe_request_ticks++;
+    else if (m_connected && (m_keyframe_needed || m_recording_keyframe_needed || m_keyframe_requested))
+        request_keyframe();
+}
+
+void Drone::request_keyframe()
+{
+    if constexpr (VERBOSE_VIDEO_DEBUG_LOGGING)
+        std::cout << "Requesting a keyframe" << std::endl;
+    queue_packet(DronePacket(96, CommandID::REQUEST_VIDEO_SPS_PPS_HEADERS));
+    increment_counter(m_video_stream_counters.keyframe_requests_sent);
+    m_keyframe_request_ticks = 0;
 }
 
 void Drone::drone_controls_thread_routine()
 {
     while (!m_shutting_down) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(20));
-
-        send_timed_requests_if_needed();
-
-        std::vector<u8> packet_data(11);
+        std::this_thread::sleep_for(m_config.control_tick);
+        control_tick();
+    }
+}
 
-        std::unique_lock<std::mutex> lock(m_received_acks_mutex);
-        u64 packed_drone_controls = ((u64)m_right_stick_x & 0x7FF) | (((u64)m_right_stick_y & 0x7FF) << 11) | (((u64)m_left_stick_y & 0x7FF) << 22) | (((u64)m_left_stick_x & 0x7FF) << 33) | ((u64)m_quick_mode << 44);
-        lock.unlock();
-        packet_data[0] = packed_drone_controls & 0xFF;
-        packet_data[1] = (packed_drone_controls >> 8) & 0xFF;
-        packet_data[2] = (packed_drone_controls >> 16) & 0xFF;
-        packet_data[3] = (packed_drone_controls >> 24) & 0xFF;
-        packet_data[4] = (packed_drone_controls >> 32) & 0xFF;
-        packet_data[5] = (packed_drone_controls >> 40) & 0xFF;
+void Drone::control_tick()
+{
+    send_timed_requests_if_needed();
+    process_async_waiters();
 
-        auto current_time_point = std::chrono::system_clock::now();
-        auto days = std::chrono::floor<std::chrono::days>(current_time_point);
-        auto time = std::chrono::hh_mm_ss(std::chrono::floor<std::chrono::milliseconds>(current_time_point - days));
-        packet_data[6] = time.hours().count();
-        packet_data[7] = time.minutes().count();
-        packet_data[8] = time.seconds().count();
-        auto milliseconds = time.subseconds().count();
-        packet_data[9] = milliseconds & 0xFF;
-        packet_data[10] = (milliseconds >> 8) & 0xFF;
+    auto packet_data = m_controls_packet.payload();
 
-        queue_packet(DronePacket(96, CommandID::SET_CURRENT_FLIGHT_CONTROLS, std::move(packet_data)));
-    }
+    std::unique_lock<std::mutex> lock(m_controls_mutex);
+    u64 packed_drone_controls = ((u64)m_right_stick_x & 0x7FF) | (((u64)m_right_stick_y & 0x7FF) << 11) | (((u64)m_left_stick_y & 0x7FF) << 22) | (((u64)m_left_stick_x & 0x7FF) << 33) | ((u64)m_quick_mode << 44);
+    lock.unlock();
+    packet_data[0] = packed_drone_controls & 0xFF;
+    packet_data[1] = (packed_drone_controls >> 8) & 0xFF;
+    packet_data[2] = (packed_drone_controls >> 16) & 0xFF;
+    packet_data[3] = (packed_drone_controls >> 24) & 0xFF;
+    packet_data[4] = (packed_drone_controls >> 32) & 0xFF;
+    packet_data[5] = (packed_drone_controls >> 40) & 0xFF;
+
+    auto current_time_point = std::chrono::system_clock::now();
+    auto days = std::chrono::floor<std::chrono::days>(current_time_point);
+    auto time = std::chrono::hh_mm_ss(std::chrono::floor<std::chrono::milliseconds>(current_time_point - days));
+    packet_data[6] = time.hours().count();
+    packet_data[7] = time.minutes().count();
+    packet_data[8] = time.seconds().count();
+    auto milliseconds = time.subseconds().count();
+    packet_data[9] = milliseconds & 0xFF;
+    packet_data[10] = (milliseconds >> 8) & 0xFF;
+
+    send_packet_bytes(m_controls_packet.finalize());
 }
 
 Drone::~Drone()
@@ -282,11 +528,14 @@ bool Drone::is_connected()
     return m_connected;
 }
 
-void Drone::wait_until_connected()
+bool Drone::wait_until_connected()
 {
+    if (!m_initialized)
+        return false;
     std::unique_lock<std::mutex> lock(m_connected_mutex);
     m_connected_cv.wait(lock, [this]() { return m_connected; });
     std::this_thread::sleep_for(std::chrono::seconds(1));
+    return true;
 }
 
 void Drone::close()
@@ -294,50 +543,270 @@ void Drone::close()
     if (m_shutting_down)
         return;
 
-    queue_packet(DronePacket(104, CommandID::LAND_DRONE, { 0x00 }));
+    if (m_initialized)
+        queue_packet(DronePacket(104, CommandID::LAND_DRONE, { 0x00 }));
 
     m_shutting_down = true;
-    m_video_receive_thread.join();
-    ::close(m_video_socket_fd);
-    m_cmd_receive_thread.join();
-    ::close(m_cmd_socket_fd);
-    m_drone_controls_thread.join();
+    close_video_queues();
+    if (m_threads_spawned && m_initialized) {
+        m_video_receive_thread.join();
+        m_cmd_receive_thread.join();
+        m_drone_controls_thread.join();
+    }
+    close_async_waiters();
+    stop_recording();
+    if (m_video_socket_fd != -1)
+        ::close(m_video_socket_fd);
+    if (m_cmd_socket_fd != -1)
+        ::close(m_cmd_socket_fd);
+    if (m_ffmpeg_socket_fd != -1)
+        ::close(m_ffmpeg_socket_fd);
 }
 
-void Drone::queue_packet_internal(DronePacket& packet)
+PendingRequestTable::Slot* Drone::queue_packet_internal(DronePacket& packet, bool wait_for_response)
 {
     assert(packet.direction == PacketDirection::TO_DRONE);
+    PendingRequestTable::Slot* request = nullptr;
     if (packet.cmd_id == CommandID::CONN_REQ || packet.cmd_id == CommandID::REQUEST_VIDEO_SPS_PPS_HEADERS || packet.cmd_id == CommandID::SET_CURRENT_FLIGHT_CONTROLS) {
         packet.seq_num = 0;
     } else {
         packet.seq_num = m_cmd_seq_num++;
-        std::unique_lock<std::mutex> lock(m_received_acks_mutex);
-        m_received_acks[packet.seq_num] = false;
+        // Registered before sending, so that even an immediate response finds it
+        if (wait_for_response) {
+            request = m_pending_requests.begin(packet.seq_num, packet.cmd_id);
+            if (!request)
+                std::cerr << "Too many requests in flight, not waiting for packet " << packet.seq_num << std::endl;
+        }
+    }
+    send_packet(packet);
+    return request;
+}
+
+void Drone::send_packet(const DronePacket& packet)
+{
+    u8 packet_bytes[DronePacket::MAX_PACKET_LENGTH];
+    auto packet_length = packet.encode(packet_bytes);
+    if (packet_length == 0) [[unlikely]] {
+        std::cerr << "Failed to encode packet with cmd_id=" << static_cast<u16>(packet.cmd_id) << std::endl;
+        return;
     }
-    auto packet_bytes = packet.serialize();
+    send_packet_bytes({ packet_bytes, packet_length });
+}
+
+void Drone::send_packet_bytes(std::span<const u8> packet_bytes)
+{
     sendto(m_cmd_socket_fd, packet_bytes.data(), packet_bytes.size(), 0,
         reinterpret_cast<const sockaddr*>(&m_cmd_addr), sizeof(m_cmd_addr));
 }
 
-bool Drone::send_packet_and_wait_until_ack(DronePacket packet)
+RetransmitPolicy Drone::retransmit_policy(CommandID cmd_id) const
+{
+    if (auto it = m_config.retransmit_policies.find(cmd_id); it != m_config.retransmit_policies.end())
+        return it->second;
+    return default_retransmit_policy(cmd_id);
+}
+
+std::optional<RequestResponse> Drone::send_packet_and_wait_for_response(DronePacket packet)
 {
-    queue_packet_internal(packet);
+    PendingRequest request { std::move(packet) };
+    if (!send_request(request))
+        return {};
     if constexpr (VERBOSE_DRONE_DEBUG_LOGGING)
-        std::cout << "Waiting for ack for packet " << packet.seq_num << " of type " << static_cast<u16>(packet.cmd_id) << std::endl;
-    std::unique_lock<std::mutex> lock(m_received_acks_mutex);
-    return m_received_acks_cv.wait_for(lock, PACKET_ACK_TIMEOUT, [this, seq_num = packet.seq_num]() { return m_received_acks[seq_num]; });
+        std::cout << "Waiting for ack for packet " << request.packet.seq_num << " of type " << static_cast<u16>(request.packet.cmd_id) << std::endl;
+    wait_for_responses({ &request, 1 }, request.sent_at + m_config.ack_timeout);
+    return request.response;
+}
+
+bool Drone::send_request(PendingRequest& request)
+{
+    request.max_retransmits = retransmit_policy(request.packet.cmd_id).max_retransmits;
+    request.sent_at = std::chrono::steady_clock::now();
+    request.slot = queue_packet_internal(request.packet, true);
+    return request.slot;
+}
+
+void Drone::wait_for_responses(std::span<PendingRequest> requests, std::chrono::steady_clock::time_point deadline)
+{
+    for (u32 attempt = 0;; ++attempt) {
+        // Requests are resent in rounds, every round waiting for one (doubling) retransmit timeout. The timeout
+        // is looked up again for every request, as the first responses of a round may have been its first samples.
+        auto round_start = std::chrono::steady_clock::now();
+        bool waiting = false;
+        bool can_retransmit = false;
+        for (auto& request : requests) {
+            if (!request.slot)
+                continue;
+            auto request_deadline = deadline;
+            if (attempt < request.max_retransmits)
+                request_deadline = std::min(deadline, round_start + m_round_trip_estimator.retransmit_timeout(attempt));
+            request.response = m_pending_requests.wait(*request.slot, request_deadline);
+            if (!request.response) {
+                waiting = true;
+                can_retransmit |= attempt < request.max_retransmits;
+                continue;
+            }
+            request.slot = nullptr;
+            // A response to a resent request may answer any of its copies, so only the first one is timed
+            if (attempt == 0)
+                m_round_trip_estimator.record(request.response->received_at - request.sent_at);
+        }
+        if (!waiting || !can_retransmit || std::chrono::steady_clock::now() >= deadline)
+            break;
+
+        for (auto& request : requests) {
+            if (!request.slot || attempt >= request.max_retransmits)
+                continue;
+            if constexpr (VERBOSE_DRONE_DEBUG_LOGGING)
+                std::cout << "No response to packet " << request.packet.seq_num << ", resending it" << std::endl;
+            m_pending_requests.record_retransmit();
+            send_packet(request.packet);
+        }
+    }
+
+    for (auto& request : requests) {
+        if (!request.slot)
+            continue;
+        m_pending_requests.cancel(*request.slot);
+        request.slot = nullptr;
+        request.timed_out = true;
+    }
+}
+
+bool Drone::ResponseAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    {
+        std::lock_guard lock(m_drone.m_async_waiters_mutex);
+        if (m_drone.m_async_waiters_closed)
+            return false;
+    }
+    if (!m_drone.send_request(m_request))
+        return false;
+    {
+        // The control thread takes it from here for retransmits and the timeout
+        std::lock_guard lock(m_drone.m_async_waiters_mutex);
+        m_deadline = m_request.sent_at + m_drone.m_config.ack_timeout;
+        m_retransmit_time = m_request.sent_at + m_drone.m_round_trip_estimator.retransmit_timeout();
+        m_drone.m_async_requests.push_back(this);
+    }
+    // The response may have beaten us to it, then the coroutine just carries on
+    return m_drone.m_pending_requests.set_waiter(*m_request.slot, handle);
+}
+
+std::optional<RequestResponse> Drone::ResponseAwaiter::await_resume()
+{
+    if (!m_request.slot)
+        return {};
+    u32 attempt;
+    {
+        std::lock_guard lock(m_drone.m_async_waiters_mutex);
+        std::erase(m_drone.m_async_requests, this);
+        attempt = m_attempt;
+    }
+    auto response = m_drone.m_pending_requests.take_response(*m_request.slot);
+    if (!response) {
+        m_drone.m_pending_requests.cancel(*m_request.slot);
+        return {};
+    }
+    // A response to a resent request may answer any of its copies, so only the first one is timed
+    if (attempt == 0)
+        m_drone.m_round_trip_estimator.record(response->received_at - m_request.sent_at);
+    return response;
+}
+
+bool Drone::DelayAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    std::lock_guard lock(m_drone.m_async_waiters_mutex);
+    if (m_drone.m_async_waiters_closed)
+        return false;
+    m_drone.m_async_delays.push_back({ std::chrono::steady_clock::now() + m_delay, handle });
+    return true;
+}
+
+void Drone::process_async_waiters()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::unique_lock lock(m_async_waiters_mutex);
+    for (auto it = m_async_requests.begin(); it != m_async_requests.end();) {
+        auto& awaiter = **it;
+        if (now >= awaiter.m_deadline) {
+            // Unless the response is resuming it right now
+            if (auto handle = m_pending_requests.take_waiter(*awaiter.m_request.slot)) {
+                m_async_resumptions.push_back(handle);
+                it = m_async_requests.erase(it);
+                continue;
+            }
+        } else if (now >= awaiter.m_retransmit_time && awaiter.m_attempt < awaiter.m_request.max_retransmits) {
+            if constexpr (VERBOSE_DRONE_DEBUG_LOGGING)
+                std::cout << "No response to packet " << awaiter.m_request.packet.seq_num << ", resending it" << std::endl;
+            awaiter.m_attempt++;
+            awaiter.m_retransmit_time = now + m_round_trip_estimator.retransmit_timeout(awaiter.m_attempt);
+            m_pending_requests.record_retransmit();
+            send_packet(awaiter.m_request.packet);
+        }
+        ++it;
+    }
+    std::erase_if(m_async_delays, [&](const AsyncDelay& delay) {
+        if (now < delay.resume_time)
+            return false;
+        m_async_resumptions.push_back(delay.handle);
+        return true;
+    });
+    lock.unlock();
+
+    for (auto handle : m_async_resumptions)
+        handle.resume();
+    m_async_resumptions.clear();
+}
+
+void Drone::close_async_waiters()
+{
+    // Resumed coroutines may await something else right away, which then fails right away
+    std::unique_lock lock(m_async_waiters_mutex);
+    m_async_waiters_closed = true;
+    for (auto* awaiter : m_async_requests) {
+        if (auto handle = m_pending_requests.take_waiter(*awaiter->m_request.slot))
+            m_async_resumptions.push_back(handle);
+    }
+    m_async_requests.clear();
+    for (auto& delay : m_async_delays)
+        m_async_resumptions.push_back(delay.handle);
+    m_async_delays.clear();
+    lock.unlock();
+
+    for (auto handle : m_async_resumptions)
+        handle.resume();
+    m_async_resumptions.clear();
 }
 
 void Drone::send_packet_and_assert_ack(DronePacket packet)
 {
+    auto cmd_id = packet.cmd_id;
     auto ack_received = send_packet_and_wait_until_ack(std::move(packet));
+    if (!ack_received)
+        std::cerr << "No ack for packet of type " << static_cast<u16>(cmd_id) << std::endl;
     assert(ack_received);
 }
 
-void Drone::handle_packet(const DronePacket& packet)
+// Packets the drone sends on its own, as opposed to responses to our requests
+static bool is_unsolicited_packet(CommandID cmd_id)
 {
-    assert(packet.direction == PacketDirection::FROM_DRONE);
+    switch (cmd_id) {
+    case CommandID::FLIGHT_DATA:
+    case CommandID::CONN_ACK:
+    case CommandID::DRONE_LOG_HEADER:
+    case CommandID::DRONE_LOG_DATA:
+    case CommandID::DRONE_LOG_CONFIGURATION:
+    case CommandID::GET_CURRENT_TIME:
+    case CommandID::WIFI_STATE:
+    case CommandID::LIGHT_STRENGTH:
+        return true;
+    default:
+        return false;
+    }
+}
 
+void Drone::handle_packet(const DronePacketView& packet)
+{
     if constexpr (VERBOSE_DRONE_DEBUG_LOGGING)
         std::cout << "Received packet of type " << static_cast<u16>(packet.cmd_id) << std::endl;
 
@@ -362,7 +831,13 @@ void Drone::handle_packet(const DronePacket& packet)
             m_connected_cv.notify_all();
         }
         m_last_update_time = current_time;
-        decode_flight_data(packet.data);
+        if (!decode_flight_data(packet.data))
+            break;
+        publish_telemetry(m_flight_data, m_flight_data_stream);
+        auto& flight = m_flight_data.data;
+        m_flight_data_history.record(m_flight_data.timestamp, { static_cast<float>(flight.height),
+            static_cast<float>(flight.north_speed), static_cast<float>(flight.east_speed),
+            static_cast<float>(flight.ground_speed), static_cast<float>(flight.battery_percentage) });
         break;
     }
     case CommandID::CONN_ACK: {
@@ -395,8 +870,9 @@ void Drone::handle_packet(const DronePacket& packet)
     case CommandID::SMART_VIDEO_STATUS:
         break;
     case CommandID::DRONE_LOG_HEADER: {
-        assert(packet.data.size() >= 3);
-        std::vector<u8> packet_bytes(3);
+        if (packet.data.size() < 3)
+            break;
+        PacketPayload packet_bytes(3);
         packet_bytes[0] = 0x00;
         packet_bytes[1] = packet.data[0];
         packet_bytes[2] = packet.data[1];
@@ -408,8 +884,9 @@ void Drone::handle_packet(const DronePacket& packet)
         break;
     }
     case CommandID::DRONE_LOG_CONFIGURATION: {
-        assert(packet.data.size() >= 7);
-        std::vector<u8> packet_bytes(7);
+        if (packet.data.size() < 7)
+            break;
+        PacketPayload packet_bytes(7);
         packet_bytes[0] = 0x00;
         packet_bytes[1] = packet.data[1];
         packet_bytes[2] = packet.data[2];
@@ -421,7 +898,7 @@ void Drone::handle_packet(const DronePacket& packet)
         break;
     }
     case CommandID::GET_CURRENT_TIME: {
-        std::vector<u8> packet_bytes(14);
+        PacketPayload packet_bytes(14);
         auto current_time_point = std::chrono::system_clock::now();
         auto days = std::chrono::floor<std::chrono::days>(current_time_point);
         auto date = std::chrono::year_month_day(days);
@@ -451,9 +928,46 @@ void Drone::handle_packet(const DronePacket& packet)
         queue_packet(DronePacket(80, CommandID::GET_CURRENT_TIME, std::move(packet_bytes)));
         break;
     }
+    case CommandID::GET_SSID:
+    case CommandID::GET_FIRMWARE_VERSION:
+    case CommandID::GET_LOADER_VERSION:
+    case CommandID::GET_BITRATE:
+    case CommandID::GET_FLIGHT_HEIGHT_LIMIT:
+    case CommandID::GET_LOW_BATTERY_WARNING:
+    case CommandID::GET_ATTITUDE_ANGLE:
+    case CommandID::GET_COUNTRY_CODE:
+    case CommandID::GET_ACTIVATION_DATA:
+    case CommandID::GET_UNIQUE_IDENTIFIER:
+    case CommandID::GET_ACTIVATION_STATUS:
+        update_drone_info(packet, success);
+        break;
+    case CommandID::WIFI_STATE:
+    case CommandID::LIGHT_STRENGTH:
+        decode_signal_data(packet);
+        publish_telemetry(m_signal_data, m_signal_data_stream);
+        update_drone_info(packet, success);
+        break;
+    default:
+        if constexpr (DRONE_DEBUG_LOGGING)
+            std::cerr << "Unhandled packet with cmd_id=" << static_cast<u16>(packet.cmd_id) << std::endl;
+        break;
+    }
+
+    if (is_unsolicited_packet(packet.cmd_id))
+        return;
+    bool request_completed = m_pending_requests.complete(packet.seq_num, packet.cmd_id, packet.data);
+    if constexpr (VERBOSE_DRONE_DEBUG_LOGGING) {
+        if (request_completed)
+            std::cout << "Received ack for packet " << packet.seq_num << std::endl;
+    }
+}
+
+void Drone::update_drone_info(const DronePacketView& packet, bool success)
+{
+    std::lock_guard lock(m_drone_info_mutex);
+    switch (packet.cmd_id) {
     case CommandID::GET_SSID: {
-        if (success) {
-            assert(packet.data.size() >= 2);
+        if (success && packet.data.size() >= 2) {
             auto raw_ssid = std::string(packet.data.begin() + 1, packet.data.end());
             trim(raw_ssid);
             m_drone_info.ssid = std::move(raw_ssid);
@@ -463,8 +977,7 @@ void Drone::handle_packet(const DronePacket& packet)
         break;
     }
     case CommandID::GET_FIRMWARE_VERSION: {
-        if (success) {
-            assert(packet.data.size() >= 11);
+        if (success && packet.data.size() >= 11) {
             m_drone_info.firmware_version = std::string(packet.data.begin() + 1, packet.data.begin() + 11);
         } else {
             std::cerr << "GET_FIRMWARE_VERSION failed" << std::endl;
@@ -472,8 +985,7 @@ void Drone::handle_packet(const DronePacket& packet)
         break;
     }
     case CommandID::GET_LOADER_VERSION: {
-        if (success) {
-            assert(packet.data.size() >= 11);
+        if (success && packet.data.size() >= 11) {
             m_drone_info.loader_version = std::string(packet.data.begin() + 1, packet.data.begin() + 11);
         } else {
             std::cerr << "GET_LOADER_VERSION failed" << std::endl;
@@ -481,8 +993,7 @@ void Drone::handle_packet(const DronePacket& packet)
         break;
     }
     case CommandID::GET_BITRATE: {
-        if (success) {
-            assert(packet.data.size() >= 2);
+        if (success && packet.data.size() >= 2) {
             m_drone_info.bitrate = packet.data[1];
         } else {
             std::cerr << "GET_BITRATE failed" << std::endl;
@@ -490,16 +1001,15 @@ void Drone::handle_packet(const DronePacket& packet)
         break;
     }
     case CommandID::GET_FLIGHT_HEIGHT_LIMIT: {
-        if (success) {
-            assert(packet.data.size() >= 3);
+        if (success && packet.data.size() >= 3) {
             m_drone_info.flight_height_limit = packet.data[1] | ((u16)packet.data[2] << 8);
         } else {
             std::cerr << "GET_FLIGHT_HEIGHT_LIMIT failed" << std::endl;
         }
+        break;
     }
     case CommandID::GET_LOW_BATTERY_WARNING: {
-        if (success) {
-            assert(packet.data.size() >= 3);
+        if (success && packet.data.size() >= 3) {
             m_drone_info.low_battery_warning = packet.data[1] | ((u16)packet.data[2] << 8);
         } else {
             std::cerr << "GET_LOW_BATTERY_WARNING failed" << std::endl;
@@ -507,8 +1017,7 @@ void Drone::handle_packet(const DronePacket& packet)
         break;
     }
     case CommandID::GET_ATTITUDE_ANGLE: {
-        if (success) {
-            assert(packet.data.size() >= 5);
+        if (success && packet.data.size() >= 5) {
             u32 float_bytes = packet.data[1] | ((u32)packet.data[2] << 8) | ((u32)packet.data[3] << 16) | ((u32)packet.data[4] << 24);
             m_drone_info.attitude_angle = *reinterpret_cast<float*>(&float_bytes);
         } else {
@@ -517,8 +1026,7 @@ void Drone::handle_packet(const DronePacket& packet)
         break;
     }
     case CommandID::GET_COUNTRY_CODE: {
-        if (success) {
-            assert(packet.data.size() >= 3);
+        if (success && packet.data.size() >= 3) {
             m_drone_info.country_code = std::string(packet.data.begin() + 1, packet.data.begin() + 3);
         } else {
             std::cerr << "GET_COUNTRY_CODE failed" << std::endl;
@@ -526,8 +1034,7 @@ void Drone::handle_packet(const DronePacket& packet)
         break;
     }
     case CommandID::GET_ACTIVATION_DATA: {
-        if (success) {
-            assert(packet.data.size() >= 58);
+        if (success && packet.data.size() >= 58) {
             // FIXME: Parse DATA
         } else {
             std::cerr << "GET_ACTIVATION_DATA failed" << std::endl;
@@ -535,8 +1042,7 @@ void Drone::handle_packet(const DronePacket& packet)
         break;
     }
     case CommandID::GET_UNIQUE_IDENTIFIER: {
-        if (success) {
-            assert(packet.data.size() >= 17);
+        if (success && packet.data.size() >= 17) {
             std::stringstream stream;
             for (size_t i = 0; i < 16; ++i)
                 stream << std::hex << packet.data[i + 1];
@@ -550,213 +1056,316 @@ void Drone::handle_packet(const DronePacket& packet)
         m_drone_info.activation_status = success;
         break;
     }
-    case CommandID::WIFI_STATE: {
-        m_drone_info.wifi_strength = packet.data[0];
-        m_drone_info.wifi_disturb = packet.data[1];
-        break;
-    }
+    case CommandID::WIFI_STATE:
     case CommandID::LIGHT_STRENGTH: {
-        m_drone_info.light_strength = packet.data[0];
+        m_drone_info.wifi_strength = m_signal_data.data.wifi_strength;
+        m_drone_info.wifi_disturb = m_signal_data.data.wifi_disturb;
+        m_drone_info.light_strength = m_signal_data.data.light_strength;
         break;
     }
     default:
-        if constexpr (DRONE_DEBUG_LOGGING)
-            std::cerr << "Unhandled packet with cmd_id=" << static_cast<u16>(packet.cmd_id) << std::endl;
         break;
     }
+}
 
-    std::unique_lock<std::mutex> lock(m_received_acks_mutex);
-    m_received_acks[packet.seq_num] = true;
-    lock.unlock();
-    if constexpr (VERBOSE_DRONE_DEBUG_LOGGING)
-        std::cout << "Received ack for packet " << packet.seq_num << std::endl;
-    m_received_acks_cv.notify_all();
-}
-
-void Drone::decode_flight_data(const std::vector<u8>& data)
-{
-    assert(data.size() >= 18);
-    m_flight_data.height = static_cast<i16>((i16)data[0] | ((i16)data[1] << 8));
-    m_flight_data.north_speed = static_cast<i16>((i16)data[2] | ((i16)data[3] << 8));
-    m_flight_data.east_speed = static_cast<i16>((i16)data[4] | ((i16)data[5] << 8));
-    m_flight_data.ground_speed = static_cast<i16>((i16)data[6] | ((i16)data[7] << 8));
-    m_flight_data.flight_time = static_cast<i16>((i16)data[8] | ((i16)data[9] << 8));
-    m_flight_data.imu_state = data[10] & 1;
-    m_flight_data.pressure_state = (data[10] >> 1) & 1;
-    m_flight_data.down_visual_state = (data[10] >> 2) & 1;
-    m_flight_data.power_state = (data[10] >> 3) & 1;
-    m_flight_data.battery_state = (data[10] >> 4) & 1;
-    m_flight_data.gravity_state = (data[10] >> 5) & 1;
-    m_flight_data.down_visual_state = (data[10] >> 7) & 1;
+template<typename T>
+void Drone::publish_telemetry(TelemetrySnapshot<T>& snapshot, TelemetryStream<T>& stream)
+{
+    snapshot.version++;
+    snapshot.timestamp = m_packet_receive_time;
+    stream.publish(snapshot);
+}
+
+void Drone::decode_signal_data(const DronePacketView& packet)
+{
+    if (packet.cmd_id == CommandID::WIFI_STATE && packet.data.size() >= 2) {
+        m_signal_data.data.wifi_strength = packet.data[0];
+        m_signal_data.data.wifi_disturb = packet.data[1];
+    } else if (packet.cmd_id == CommandID::LIGHT_STRENGTH && !packet.data.empty()) {
+        m_signal_data.data.light_strength = packet.data[0];
+    }
+}
+
+bool Drone::decode_flight_data(std::span<const u8> data)
+{
+    // The payload is untrusted, shorter ones carry fewer fields
+    if (data.size() < 11)
+        return false;
+    m_flight_data.data.height = static_cast<i16>((i16)data[0] | ((i16)data[1] << 8));
+    m_flight_data.data.north_speed = static_cast<i16>((i16)data[2] | ((i16)data[3] << 8));
+    m_flight_data.data.east_speed = static_cast<i16>((i16)data[4] | ((i16)data[5] << 8));
+    m_flight_data.data.ground_speed = static_cast<i16>((i16)data[6] | ((i16)data[7] << 8));
+    m_flight_data.data.flight_time = static_cast<i16>((i16)data[8] | ((i16)data[9] << 8));
+    m_flight_data.data.imu_state = data[10] & 1;
+    m_flight_data.data.pressure_state = (data[10] >> 1) & 1;
+    m_flight_data.data.down_visual_state = (data[10] >> 2) & 1;
+    m_flight_data.data.power_state = (data[10] >> 3) & 1;
+    m_flight_data.data.battery_state = (data[10] >> 4) & 1;
+    m_flight_data.data.gravity_state = (data[10] >> 5) & 1;
+    m_flight_data.data.wind_state = (data[10] >> 7) & 1;
     if (data.size() < 19)
-        return;
-    assert(data.size() >= 21);
-    m_flight_data.imu_calibration_state = static_cast<i8>(data[11]);
-    m_flight_data.battery_percentage = static_cast<i8>(data[12]);
-    m_flight_data.flight_time_left = static_cast<i16>((i16)data[13] | ((i16)data[14] << 8));
-    m_flight_data.battery_left = static_cast<i16>((i16)data[15] | ((i16)data[16] << 8));
-    m_flight_data.eMSky = data[17] & 1;
-    m_flight_data.eMGround = (data[17] >> 1) & 1;
-    m_flight_data.eMOpen = (data[17] >> 2) & 1;
-    m_flight_data.drone_hover = (data[17] >> 3) & 1;
-    m_flight_data.outage_recording = (data[17] >> 4) & 1;
-    m_flight_data.battery_low = (data[17] >> 5) & 1;
-    m_flight_data.batery_lower = (data[17] >> 6) & 1;
-    m_flight_data.factory_mode = (data[17] >> 7) & 1;
-    m_flight_data.flight_mode = data[18];
-    m_flight_data.throw_fly_timer = data[19];
-    m_flight_data.camera_state = data[20];
+        return true;
+    m_flight_data.data.imu_calibration_state = static_cast<i8>(data[11]);
+    m_flight_data.data.battery_percentage = static_cast<i8>(data[12]);
+    m_flight_data.data.flight_time_left = static_cast<i16>((i16)data[13] | ((i16)data[14] << 8));
+    m_flight_data.data.battery_left = static_cast<i16>((i16)data[15] | ((i16)data[16] << 8));
+    m_flight_data.data.eMSky = data[17] & 1;
+    m_flight_data.data.eMGround = (data[17] >> 1) & 1;
+    m_flight_data.data.eMOpen = (data[17] >> 2) & 1;
+    m_flight_data.data.drone_hover = (data[17] >> 3) & 1;
+    m_flight_data.data.outage_recording = (data[17] >> 4) & 1;
+    m_flight_data.data.battery_low = (data[17] >> 5) & 1;
+    m_flight_data.data.batery_lower = (data[17] >> 6) & 1;
+    m_flight_data.data.factory_mode = (data[17] >> 7) & 1;
+    m_flight_data.data.flight_mode = data[18];
+    if (data.size() < 21)
+        return true;
+    m_flight_data.data.throw_fly_timer = data[19];
+    m_flight_data.data.camera_state = data[20];
     if (data.size() < 22)
-        return;
-    m_flight_data.electrical_machinery_state = data[21];
+        return true;
+    m_flight_data.data.electrical_machinery_state = data[21];
     if (data.size() < 23)
-        return;
-    m_flight_data.front_in = data[22] & 1;
-    m_flight_data.front_out = (data[22] >> 1) & 1;
-    m_flight_data.front_LSC = (data[22] >> 2) & 1;
-    m_flight_data.center_gravity_calibration_status = (data[22] >> 3) & 3;
-    m_flight_data.soaring_up_into_the_sky = (data[22] >> 5) & 1;
-    m_flight_data.temperature_height = (data[22] >> 7) & 1;
+        return true;
+    m_flight_data.data.front_in = data[22] & 1;
+    m_flight_data.data.front_out = (data[22] >> 1) & 1;
+    m_flight_data.data.front_LSC = (data[22] >> 2) & 1;
+    m_flight_data.data.center_gravity_calibration_status = (data[22] >> 3) & 3;
+    m_flight_data.data.soaring_up_into_the_sky = (data[22] >> 5) & 1;
+    m_flight_data.data.temperature_height = (data[22] >> 7) & 1;
+    return true;
 }
 
-void Drone::decode_log_data(const std::vector<u8>& data)
+// Little endian fields of a decrypted log record
+static i16 read_log_i16(std::span<const u8> record, usize offset)
 {
-    if (data.size() < 6)
+    return static_cast<i16>(record[offset] | (record[offset + 1] << 8));
+}
+
+static float read_log_float(std::span<const u8> record, usize offset)
+{
+    u32 float_bytes = record[offset] | ((u32)record[offset + 1] << 8) | ((u32)record[offset + 2] << 16) | ((u32)record[offset + 3] << 24);
+    return std::bit_cast<float>(float_bytes);
+}
+
+// FIXME: There's a bunch more data to be extracted, see: https://pastebin.com/raw/TsMDx4az
+//  These are in the DJI log format, search online for more information
+// The minimum lengths are one past the last field read, the checksum is not part of the decrypted record
+const Drone::LogRecordDecoder Drone::LOG_RECORD_DECODERS[] = {
+    { LogRecordType::MVO, 87, &Drone::decode_mvo_record },
+    { LogRecordType::IMU, 118, &Drone::decode_imu_record },
+};
+
+void Drone::decode_mvo_record(std::span<const u8> record)
+{
+    auto flags = record[86];
+    if (flags & 0x01)
+        m_mvo_data.data.velocity_x = read_log_i16(record, 12);
+    if (flags & 0x02)
+        m_mvo_data.data.velocity_y = read_log_i16(record, 14);
+    if (flags & 0x04)
+        m_mvo_data.data.velocity_z = -read_log_i16(record, 16);
+    if ((flags & 0x10) && (flags & 0x20) && (flags & 0x40)) {
+        m_mvo_data.data.position_y = read_log_float(record, 18);
+        m_mvo_data.data.position_x = read_log_float(record, 22);
+        m_mvo_data.data.position_z = read_log_float(record, 26);
+    }
+}
+
+void Drone::decode_imu_record(std::span<const u8> record)
+{
+    m_imu_data.data.quaternion_w = read_log_float(record, 58);
+    m_imu_data.data.quaternion_x = read_log_float(record, 62);
+    m_imu_data.data.quaternion_y = read_log_float(record, 66);
+    m_imu_data.data.quaternion_z = read_log_float(record, 70);
+    m_imu_data.data.temperature = read_log_i16(record, 116) / 100;
+}
+
+void Drone::decode_log_data(std::span<const u8> data)
+{
+    if (data.empty())
         return;
-    for (size_t i = 1; i < data.size() - 6; ++i) {
-        if (data[i] != 'U')
-            break;
-        auto record_length = (u16)data[i + 1] | ((u16)data[i + 2] << 8);
-        auto record_type = (u16)data[i + 4] | ((u16)data[i + 5] << 8);
-        auto xor_key = data[i + 6];
-        std::vector<u8> decrypted_data(record_length);
-        for(size_t j = 0; j < record_length && j + i < data.size(); ++j)
-            decrypted_data[j] = data[i + j] ^ xor_key;
-        // FIXME: There's a bunch more data to be extracted, see: https://pastebin.com/raw/TsMDx4az
-        //  These are in the DJI log format, search online for more information
-        switch (static_cast<LogRecordType>(record_type)) {
-        case LogRecordType::MVO: {
-            auto flags = data[86];
-            if (flags & 1)
-                m_mvo_data.velocity_x = (i16)decrypted_data[12] | ((i16)decrypted_data[13] << 8);
-            if (flags & 2)
-                m_mvo_data.velocity_y = (i16)decrypted_data[14] | ((i16)decrypted_data[15] << 8);
-            if (flags & 4)
-                m_mvo_data.velocity_z = -((i16)decrypted_data[14] | ((i16)decrypted_data[15] << 8));
-            if ((flags & 10) && (flags & 20) && (flags & 40)) {
-                u32 float_bytes = decrypted_data[18] | ((u32)decrypted_data[19] << 8) | ((u32)decrypted_data[20] << 16) | ((u32)decrypted_data[21] << 24);
-                m_mvo_data.position_y = *reinterpret_cast<float*>(&float_bytes);
-                float_bytes = decrypted_data[22] | ((u32)decrypted_data[23] << 8) | ((u32)decrypted_data[24] << 16) | ((u32)decrypted_data[25] << 24);
-                m_mvo_data.position_x = *reinterpret_cast<float*>(&float_bytes);
-                float_bytes = decrypted_data[26] | ((u32)decrypted_data[27] << 8) | ((u32)decrypted_data[28] << 16) | ((u32)decrypted_data[29] << 24);
-                m_mvo_data.position_z = *reinterpret_cast<float*>(&float_bytes);
-            }
-            break;
-        }
-        case LogRecordType::IMU: {
-            u32 float_bytes = decrypted_data[58] | ((u32)decrypted_data[59] << 8) | ((u32)decrypted_data[60] << 16) | ((u32)decrypted_data[61] << 24);
-            m_imu_data.quaternion_w = *reinterpret_cast<float*>(&float_bytes);
-            float_bytes = decrypted_data[62] | ((u32)decrypted_data[63] << 8) | ((u32)decrypted_data[64] << 16) | ((u32)decrypted_data[65] << 24);
-            m_imu_data.quaternion_x = *reinterpret_cast<float*>(&float_bytes);
-            float_bytes = decrypted_data[66] | ((u32)decrypted_data[67] << 8) | ((u32)decrypted_data[68] << 16) | ((u32)decrypted_data[69] << 24);
-            m_imu_data.quaternion_y = *reinterpret_cast<float*>(&float_bytes);
-            float_bytes = decrypted_data[70] | ((u32)decrypted_data[71] << 8) | ((u32)decrypted_data[72] << 16) | ((u32)decrypted_data[73] << 24);
-            m_imu_data.quaternion_z = *reinterpret_cast<float*>(&float_bytes);
-            m_imu_data.temperature = ((i16)decrypted_data[116] | ((i16)data[117] << 8)) / 100;
-            break;
+    bool mvo_data_decoded = false;
+    bool imu_data_decoded = false;
+    // The records start after the first byte
+    LogRecordIterator records(data.subspan(1));
+    while (auto record = records.next()) {
+        auto* decoder = std::find_if(std::begin(LOG_RECORD_DECODERS), std::end(LOG_RECORD_DECODERS),
+            [&](auto& decoder) { return decoder.type == record->type; });
+        if (decoder == std::end(LOG_RECORD_DECODERS) || record->decrypted_length() < decoder->minimum_length) {
+            // Most record types have no decoder, so this fires for nearly every log packet
+            if constexpr (VERBOSE_DRONE_DEBUG_LOGGING)
+                std::cerr << "Unhandled log record with type=" << static_cast<u16>(record->type)
+                          << " length=" << record->bytes.size() << std::endl;
+            continue;
         }
-        default:
+        if (m_log_record_scratch.size() < record->decrypted_length())
+            m_log_record_scratch.resize(record->decrypted_length());
+        (this->*decoder->decode)(record->decrypt(m_log_record_scratch));
+        mvo_data_decoded |= decoder->type == LogRecordType::MVO;
+        imu_data_decoded |= decoder->type == LogRecordType::IMU;
+    }
+    if (mvo_data_decoded) {
+        publish_telemetry(m_mvo_data, m_mvo_data_stream);
+        auto& mvo = m_mvo_data.data;
+        m_mvo_data_history.record(m_mvo_data.timestamp, { static_cast<float>(mvo.velocity_x),
+            static_cast<float>(mvo.velocity_y), static_cast<float>(mvo.velocity_z), mvo.position_x, mvo.position_y,
+            mvo.position_z });
+    }
+    if (imu_data_decoded) {
+        publish_telemetry(m_imu_data, m_imu_data_stream);
+        auto& imu = m_imu_data.data;
+        m_imu_data_history.record(m_imu_data.timestamp, { imu.quaternion_w, imu.quaternion_x, imu.quaternion_y,
+            imu.quaternion_z });
+    }
+}
+
+template<typename T>
+T Drone::get_drone_info_field(std::optional<T> DroneInfo::*field, CommandID cmd_id)
+{
+    std::unique_lock lock(m_drone_info_mutex);
+    if (!(m_drone_info.*field).has_value()) [[unlikely]] {
+        lock.unlock();
+        // No free request slot or no response in time, either way the field stays missing
+        if (!send_packet_and_wait_until_ack(DronePacket(72, cmd_id))) {
             if constexpr (DRONE_DEBUG_LOGGING)
-                std::cerr << "Unhandled log record with type=" << record_type << std::endl;
-            break;
+                std::cerr << "No response to drone info query " << static_cast<u16>(cmd_id) << std::endl;
         }
-        i += record_length;
+        lock.lock();
     }
+    return (m_drone_info.*field).value_or(T {});
 }
 
 std::string Drone::get_ssid()
 {
-    if (!m_drone_info.ssid.has_value()) [[unlikely]]
-        send_packet_and_assert_ack(DronePacket(72, CommandID::GET_SSID));
-    return *m_drone_info.ssid;
+    return get_drone_info_field(&DroneInfo::ssid, CommandID::GET_SSID);
 }
 
 std::string Drone::get_firmware_version()
 {
-    if (!m_drone_info.firmware_version.has_value()) [[unlikely]]
-        send_packet_and_assert_ack(DronePacket(72, CommandID::GET_FIRMWARE_VERSION));
-    return *m_drone_info.firmware_version;
+    return get_drone_info_field(&DroneInfo::firmware_version, CommandID::GET_FIRMWARE_VERSION);
 }
 
 std::string Drone::get_loader_version()
 {
-    if (!m_drone_info.loader_version.has_value()) [[unlikely]]
-        send_packet_and_assert_ack(DronePacket(72, CommandID::GET_LOADER_VERSION));
-    return *m_drone_info.loader_version;
+    return get_drone_info_field(&DroneInfo::loader_version, CommandID::GET_LOADER_VERSION);
 }
 
 u8 Drone::get_bitrate()
 {
-    if (!m_drone_info.bitrate.has_value()) [[unlikely]]
-        send_packet_and_assert_ack(DronePacket(72, CommandID::GET_BITRATE));
-    return *m_drone_info.bitrate;
+    return get_drone_info_field(&DroneInfo::bitrate, CommandID::GET_BITRATE);
 }
 
 u16 Drone::get_flight_height_limit()
 {
-    if (!m_drone_info.flight_height_limit.has_value()) [[unlikely]]
-        send_packet_and_assert_ack(DronePacket(72, CommandID::GET_FLIGHT_HEIGHT_LIMIT));
-    return *m_drone_info.flight_height_limit;
+    return get_drone_info_field(&DroneInfo::flight_height_limit, CommandID::GET_FLIGHT_HEIGHT_LIMIT);
 }
 
 u16 Drone::get_low_battery_warning()
 {
-    if (!m_drone_info.low_battery_warning.has_value()) [[unlikely]]
-        send_packet_and_assert_ack(DronePacket(72, CommandID::GET_LOW_BATTERY_WARNING));
-    return *m_drone_info.low_battery_warning;
+    return get_drone_info_field(&DroneInfo::low_battery_warning, CommandID::GET_LOW_BATTERY_WARNING);
 }
 
 float Drone::get_attitude_angle()
 {
-    if (!m_drone_info.attitude_angle.has_value()) [[unlikely]]
-        send_packet_and_assert_ack(DronePacket(72, CommandID::GET_ATTITUDE_ANGLE));
-    return *m_drone_info.attitude_angle;
+    return get_drone_info_field(&DroneInfo::attitude_angle, CommandID::GET_ATTITUDE_ANGLE);
 }
 
 std::string Drone::get_country_code()
 {
-    if (!m_drone_info.country_code.has_value()) [[unlikely]]
-        send_packet_and_assert_ack(DronePacket(72, CommandID::GET_COUNTRY_CODE));
-    return *m_drone_info.country_code;
+    return get_drone_info_field(&DroneInfo::country_code, CommandID::GET_COUNTRY_CODE);
 }
 
 std::string Drone::get_unique_identifier()
 {
-    if (!m_drone_info.unique_identifier.has_value()) [[unlikely]]
-        send_packet_and_assert_ack(DronePacket(72, CommandID::GET_UNIQUE_IDENTIFIER));
-    return *m_drone_info.unique_identifier;
+    return get_drone_info_field(&DroneInfo::unique_identifier, CommandID::GET_UNIQUE_IDENTIFIER);
 }
 
 bool Drone::get_activation_status()
 {
-    if (!m_drone_info.activation_status.has_value()) [[unlikely]]
-        send_packet_and_assert_ack(DronePacket(72, CommandID::GET_ACTIVATION_STATUS));
-    return *m_drone_info.activation_status;
+    return get_drone_info_field(&DroneInfo::activation_status, CommandID::GET_ACTIVATION_STATUS);
 }
 
-const FlightData& Drone::get_flight_data()
+struct DroneInfoQuery {
+    DroneInfoField field;
+    CommandID cmd_id;
+    bool (*has_value)(const DroneInfo&);
+};
+
+static constexpr DroneInfoQuery DRONE_INFO_QUERIES[] = {
+    { DroneInfoField::Ssid, CommandID::GET_SSID, [](const DroneInfo& info) { return info.ssid.has_value(); } },
+    { DroneInfoField::FirmwareVersion, CommandID::GET_FIRMWARE_VERSION, [](const DroneInfo& info) { return info.firmware_version.has_value(); } },
+    { DroneInfoField::LoaderVersion, CommandID::GET_LOADER_VERSION, [](const DroneInfo& info) { return info.loader_version.has_value(); } },
+    { DroneInfoField::Bitrate, CommandID::GET_BITRATE, [](const DroneInfo& info) { return info.bitrate.has_value(); } },
+    { DroneInfoField::FlightHeightLimit, CommandID::GET_FLIGHT_HEIGHT_LIMIT, [](const DroneInfo& info) { return info.flight_height_limit.has_value(); } },
+    { DroneInfoField::LowBatteryWarning, CommandID::GET_LOW_BATTERY_WARNING, [](const DroneInfo& info) { return info.low_battery_warning.has_value(); } },
+    { DroneInfoField::AttitudeAngle, CommandID::GET_ATTITUDE_ANGLE, [](const DroneInfo& info) { return info.attitude_angle.has_value(); } },
+    { DroneInfoField::CountryCode, CommandID::GET_COUNTRY_CODE, [](const DroneInfo& info) { return info.country_code.has_value(); } },
+    { DroneInfoField::UniqueIdentifier, CommandID::GET_UNIQUE_IDENTIFIER, [](const DroneInfo& info) { return info.unique_identifier.has_value(); } },
+    { DroneInfoField::ActivationStatus, CommandID::GET_ACTIVATION_STATUS, [](const DroneInfo& info) { return info.activation_status.has_value(); } },
+};
+static_assert(std::size(DRONE_INFO_QUERIES) == static_cast<usize>(DroneInfoField::Count));
+
+DroneInfoSnapshot Drone::refresh_info(std::chrono::steady_clock::time_point deadline)
 {
-    return m_flight_data;
+    DroneInfoSnapshot snapshot;
+    {
+        std::lock_guard lock(m_drone_info_mutex);
+        snapshot.info = m_drone_info;
+    }
+
+    std::vector<PendingRequest> requests;
+    requests.reserve(std::size(DRONE_INFO_QUERIES));
+    std::array<usize, std::size(DRONE_INFO_QUERIES)> request_of_field {};
+    for (auto& query : DRONE_INFO_QUERIES) {
+        auto field = static_cast<usize>(query.field);
+        if (query.has_value(snapshot.info)) {
+            snapshot.status[field] = DroneInfoStatus::Cached;
+            continue;
+        }
+        request_of_field[field] = requests.size();
+        auto& request = requests.emplace_back(DronePacket(72, query.cmd_id));
+        if (!send_request(request))
+            snapshot.status[field] = DroneInfoStatus::NotSent;
+    }
+    wait_for_responses(requests, deadline);
+
+    // The receive path stored the responses before completing the requests
+    {
+        std::lock_guard lock(m_drone_info_mutex);
+        snapshot.info = m_drone_info;
+    }
+    for (auto& query : DRONE_INFO_QUERIES) {
+        auto field = static_cast<usize>(query.field);
+        if (snapshot.status[field] == DroneInfoStatus::Cached || snapshot.status[field] == DroneInfoStatus::NotSent)
+            continue;
+        auto& request = requests[request_of_field[field]];
+        if (request.timed_out)
+            snapshot.status[field] = DroneInfoStatus::TimedOut;
+        else
+            snapshot.status[field] = query.has_value(snapshot.info) ? DroneInfoStatus::Received : DroneInfoStatus::Failed;
+    }
+    return snapshot;
 }
 
-const MVOData& Drone::get_mvo_data()
+TelemetrySnapshot<FlightData> Drone::get_flight_data() const
 {
-    return m_mvo_data;
+    return m_flight_data_stream.latest();
 }
 
-const IMUData& Drone::get_imu_data()
+TelemetrySnapshot<MVOData> Drone::get_mvo_data() const
 {
-    return m_imu_data;
+    return m_mvo_data_stream.latest();
+}
+
+TelemetrySnapshot<IMUData> Drone::get_imu_data() const
+{
+    return m_imu_data_stream.latest();
+}
+
+TelemetrySnapshot<SignalData> Drone::get_signal_data() const
+{
+    return m_signal_data_stream.latest();
 }
 
 void Drone::set_flight_height_limit(u16 flight_height_limit)
@@ -769,6 +1378,16 @@ void Drone::set_low_battery_warning(u16 low_battery_warning)
     send_packet_and_assert_ack(DronePacket(104, CommandID::SET_LOW_BATTERY_WARNING, { static_cast<u8>(low_battery_warning & 0xFF), static_cast<u8>(low_battery_warning >> 8) }));
 }
 
+Drone::AckAwaiter Drone::set_flight_height_limit_async(u16 flight_height_limit)
+{
+    return AckAwaiter(*this, DronePacket(72, CommandID::SET_FLIGHT_HEIGHT_LIMIT, { static_cast<u8>(flight_height_limit & 0xFF), static_cast<u8>(flight_height_limit >> 8) }));
+}
+
+Drone::AckAwaiter Drone::set_low_battery_warning_async(u16 low_battery_warning)
+{
+    return AckAwaiter(*this, DronePacket(104, CommandID::SET_LOW_BATTERY_WARNING, { static_cast<u8>(low_battery_warning & 0xFF), static_cast<u8>(low_battery_warning >> 8) }));
+}
+
 bool Drone::take_off()
 {
     return send_packet_and_wait_until_ack(DronePacket(104, CommandID::TAKE_OFF));
@@ -830,6 +1449,62 @@ bool Drone::stop_smart_video(SmartVideoAction smart_video_action)
     return send_packet_and_wait_until_ack(DronePacket(104, CommandID::SET_SMART_VIDEO_MODE, { static_cast<u8>(smart_video_action) }));
 }
 
+Drone::AckAwaiter Drone::take_off_async()
+{
+    return AckAwaiter(*this, DronePacket(104, CommandID::TAKE_OFF));
+}
+
+Drone::AckAwaiter Drone::throw_take_off_async()
+{
+    return AckAwaiter(*this, DronePacket(72, CommandID::THROW_AND_FLY));
+}
+
+Drone::AckAwaiter Drone::land_async()
+{
+    return AckAwaiter(*this, DronePacket(104, CommandID::LAND_DRONE, { 0x00 }));
+}
+
+Drone::AckAwaiter Drone::palm_land_async()
+{
+    return AckAwaiter(*this, DronePacket(72, CommandID::PALM_LAND, { 0x00 }));
+}
+
+Drone::AckAwaiter Drone::cancel_landing_async()
+{
+    return AckAwaiter(*this, DronePacket(104, CommandID::LAND_DRONE, { 0x01 }));
+}
+
+Drone::AckAwaiter Drone::start_bouncing_async()
+{
+    return AckAwaiter(*this, DronePacket(104, CommandID::SET_BOUNCE_MODE, { 0x30 }));
+}
+
+Drone::AckAwaiter Drone::stop_bouncing_async()
+{
+    return AckAwaiter(*this, DronePacket(104, CommandID::SET_BOUNCE_MODE, { 0x31 }));
+}
+
+Drone::AckAwaiter Drone::flip_async(FlipDirection direction)
+{
+    return AckAwaiter(*this, DronePacket(112, CommandID::FLIP_DRONE, { static_cast<u8>(direction) }));
+}
+
+Drone::AckAwaiter Drone::start_smart_video_async(SmartVideoAction smart_video_action)
+{
+    u8 payload = static_cast<u8>(smart_video_action) | 0x1;
+    return AckAwaiter(*this, DronePacket(104, CommandID::SET_SMART_VIDEO_MODE, { payload }));
+}
+
+Drone::AckAwaiter Drone::stop_smart_video_async(SmartVideoAction smart_video_action)
+{
+    return AckAwaiter(*this, DronePacket(104, CommandID::SET_SMART_VIDEO_MODE, { static_cast<u8>(smart_video_action) }));
+}
+
+Drone::DelayAwaiter Drone::delay_async(std::chrono::milliseconds delay)
+{
+    return DelayAwaiter(*this, delay);
+}
+
 void Drone::shutdown()
 {
     queue_packet(DronePacket(80, CommandID::SHUTDOWN_DRONE, { 0, 0 }));
@@ -1,13 +1,28 @@
 #pragma once
 
+#include "DroneConfig.h"
 #include "DroneData.h"
 #include "DronePacket.h"
+#include "DroneStatistics.h"
+#include "FramePool.h"
+#include "H264Parser.h"
+#include "PacketCapture.h"
+#include "PendingRequestTable.h"
+#include "Retransmission.h"
+#include "TelemetryHistory.h"
+#include "TelemetryStream.h"
+#include "VideoFrameQueue.h"
+#include "VideoReassembler.h"
+#include "VideoRecorder.h"
+#include "Utils/DatagramBatch.h"
+#include "Utils/Task.h"
 #include "Utils/Types.h"
 #include <arpa/inet.h>
 #include <atomic>
-#include <bitset>
 #include <chrono>
 #include <condition_variable>
+#include <coroutine>
+#include <functional>
 #include <mutex>
 #include <netinet/in.h>
 #include <sys/socket.h>
@@ -20,15 +35,65 @@ namespace Tello {
 #define VIDEO_DEBUG_LOGGING 0
 #define VERBOSE_VIDEO_DEBUG_LOGGING 0
 
+class Fleet;
+class PacketReplay;
+
 class Drone {
 public:
-    Drone();
+    explicit Drone(DroneConfig config = {});
     ~Drone();
 
+    // False if the sockets could not be set up, in which case the drone will never connect
+    [[nodiscard]] bool is_initialized() const { return m_initialized; }
+    [[nodiscard]] const DroneConfig& get_config() const { return m_config; }
+    [[nodiscard]] u16 get_video_port() const { return m_video_port; }
+    [[nodiscard]] SocketStatistics get_cmd_socket_statistics() const { return m_cmd_socket_counters.snapshot(); }
+    [[nodiscard]] SocketStatistics get_video_socket_statistics() const { return m_video_socket_counters.snapshot(); }
+    [[nodiscard]] PendingRequestStatistics get_request_statistics() const { return m_pending_requests.get_statistics(); }
+    // Round trip times of blocking requests and the resulting retransmit timeout
+    [[nodiscard]] RoundTripStatistics get_round_trip_statistics() const { return m_round_trip_estimator.get_statistics(); }
+    [[nodiscard]] FramePoolStatistics get_frame_pool_statistics() const { return m_frame_pool->get_statistics(); }
+    [[nodiscard]] VideoReassemblyStatistics get_video_reassembly_statistics() const { return m_video_reassembler.get_statistics(); }
+    [[nodiscard]] VideoStreamStatistics get_video_stream_statistics() const { return m_video_stream_counters.snapshot(); }
+    [[nodiscard]] VideoLatencyStatistics get_video_latency_statistics() const { return m_video_latency_histograms.snapshot(); }
+    // Kernel receive timestamp to the packet being handled, for every packet on the cmd socket
+    [[nodiscard]] LatencySummary get_cmd_receive_latency() const { return m_cmd_receive_latency_histogram.summary(); }
+    void reset_latency_statistics();
+    // Profile, level and resolution from the latest sequence parameter set, if one was received yet
+    [[nodiscard]] std::optional<H264SequenceParameterSet> get_video_stream_info();
+
     [[nodiscard]] bool is_connected();
-    void wait_until_connected();
+    bool wait_until_connected();
+
+    // Video frames - callbacks run on the video receive thread, for every complete access unit from the
+    // first sequence parameter set on. The frame's buffer stays valid for as long as a copy of it is kept.
+    // Once unsubscribing returns the callback is not running anymore, so callbacks must not subscribe or
+    // unsubscribe themselves.
+    using VideoFrameCallback = std::function<void(const VideoFrame&)>;
+    u32 subscribe_video_frames(VideoFrameCallback callback);
+    // Hands the frames to a consumer thread through the queue, the queue's policy decides what happens when
+    // the consumer falls behind. The queue is closed on unsubscribing and when the drone is closed, so neither
+    // waits on a consumer that stopped popping.
+    u32 subscribe_video_frames(std::shared_ptr<VideoFrameQueue> queue);
+    void unsubscribe_video_frames(u32 subscription_id);
+
+    // Records the video to a file from a writer thread of its own, starting at the next IDR frame (which is
+    // requested right away). A recording that is already running is stopped first. Returns nothing if the
+    // file could not be created.
+    std::shared_ptr<VideoRecorder> start_recording(VideoRecorderConfig config);
+    void stop_recording();
+
+    // Records every datagram received on both sockets, with its receive timestamp, to a capture file that
+    // PacketReplay plays back. A capture that is already running is stopped first. Returns nothing if the file
+    // could not be created.
+    std::shared_ptr<PacketCaptureWriter> start_capture(const std::string& path);
+    void stop_capture();
 
-    // Drone Info getters - BLOCKING
+    // For frame consumers that lost frames of their own, e.g. a decoder that fell behind: keyframes are
+    // requested (rate limited) until the next one arrives
+    void request_keyframe_soon() { m_keyframe_requested = true; }
+
+    // Drone Info getters - BLOCKING, a default value if the drone does not answer
     [[nodiscard]] std::string get_ssid();
     [[nodiscard]] std::string get_firmware_version();
     [[nodiscard]] std::string get_loader_version();
@@ -39,11 +104,29 @@ public:
     [[nodiscard]] std::string get_country_code();
     [[nodiscard]] std::string get_unique_identifier();
     [[nodiscard]] bool get_activation_status();
+    // Sends the queries for every field that is still missing back to back and waits for all of them at
+    // once, so filling in the whole DroneInfo takes about one round trip instead of one per field
+    [[nodiscard]] DroneInfoSnapshot refresh_info(std::chrono::steady_clock::time_point deadline);
+
+    // Drone info getters - NON-BLOCKING, never wait for the receive thread, even while it is publishing
+    [[nodiscard]] TelemetrySnapshot<FlightData> get_flight_data() const;
+    [[nodiscard]] TelemetrySnapshot<MVOData> get_mvo_data() const;
+    [[nodiscard]] TelemetrySnapshot<IMUData> get_imu_data() const;
+    [[nodiscard]] TelemetrySnapshot<SignalData> get_signal_data() const;
+
+    // Telemetry streams - subscribe to every new sample or wait for the next one instead of polling the getters
+    // above, e.g. `drone.get_flight_data_stream().wait_for_next(last.version, deadline)`
+    [[nodiscard]] TelemetryStream<FlightData>& get_flight_data_stream() { return m_flight_data_stream; }
+    [[nodiscard]] TelemetryStream<MVOData>& get_mvo_data_stream() { return m_mvo_data_stream; }
+    [[nodiscard]] TelemetryStream<IMUData>& get_imu_data_stream() { return m_imu_data_stream; }
+    [[nodiscard]] TelemetryStream<SignalData>& get_signal_data_stream() { return m_signal_data_stream; }
 
-    // Drone info getters - NON-BLOCKING
-    [[nodiscard]] const FlightData& get_flight_data();
-    [[nodiscard]] const MVOData& get_mvo_data();
-    [[nodiscard]] const IMUData& get_imu_data();
+    // Telemetry history - the latest samples as columns, e.g. the heights of the last minute, with `range`
+    // from `history.range(now - std::chrono::minutes(1), now)`: `history.copy_column(FlightDataColumn::Height,
+    // range, heights)`
+    [[nodiscard]] const TelemetryHistory<FlightDataColumn>& get_flight_data_history() const { return m_flight_data_history; }
+    [[nodiscard]] const TelemetryHistory<MVODataColumn>& get_mvo_data_history() const { return m_mvo_data_history; }
+    [[nodiscard]] const TelemetryHistory<IMUDataColumn>& get_imu_data_history() const { return m_imu_data_history; }
 
     // Drone info setters - BLOCKING
     void set_flight_height_limit(u16);
@@ -79,54 +162,200 @@ public:
     void clockwise(float speed);
     void counterclockwise(float speed);
 
+    // Actions - AWAITABLE, e.g. `bool took_off = co_await drone.take_off_async();`. Nothing is sent before it is
+    // co_awaited. The awaiting coroutine is resumed on the cmd receive thread once the ack arrives, or on the
+    // control thread once ack_timeout passed, so it must not block and should await the next step instead.
+    // The drone has to outlive the coroutines awaiting it, and they must not be destroyed while suspended.
+    // Await the result into a variable first as in the example, GCC 12 miscompiles coroutines with a co_await
+    // inside a condition like `if (co_await drone.take_off_async())`.
+    class AckAwaiter;
+    class DelayAwaiter;
+    [[nodiscard]] AckAwaiter take_off_async();
+    [[nodiscard]] AckAwaiter throw_take_off_async();
+    [[nodiscard]] AckAwaiter land_async();
+    [[nodiscard]] AckAwaiter palm_land_async();
+    [[nodiscard]] AckAwaiter cancel_landing_async();
+    [[nodiscard]] AckAwaiter start_bouncing_async();
+    [[nodiscard]] AckAwaiter stop_bouncing_async();
+    [[nodiscard]] AckAwaiter flip_async(FlipDirection);
+    [[nodiscard]] AckAwaiter start_smart_video_async(SmartVideoAction);
+    [[nodiscard]] AckAwaiter stop_smart_video_async(SmartVideoAction);
+    [[nodiscard]] AckAwaiter set_flight_height_limit_async(u16);
+    [[nodiscard]] AckAwaiter set_low_battery_warning_async(u16);
+    // Resumes on the control thread after the delay, in control_tick steps
+    [[nodiscard]] DelayAwaiter delay_async(std::chrono::milliseconds delay);
+
 private:
+    friend class Fleet;
+    friend class PacketReplay;
+
+    // Drones owned by a Fleet are driven by its reactor instead of their own threads, a PacketReplay feeds its
+    // drone itself
+    Drone(DroneConfig config, bool spawn_threads);
+
+    bool open_sockets();
+    bool bind_socket(int socket_fd, u16 port, char const* socket_name);
     void close();
 
     void send_setup_packet();
     void send_initialization_sequence();
     void send_timed_requests_if_needed();
+    void request_keyframe();
+
+    // A blocking request, from sending it to its response
+    struct PendingRequest {
+        DronePacket packet;
+        PendingRequestTable::Slot* slot { nullptr };
+        std::chrono::steady_clock::time_point sent_at;
+        u8 max_retransmits { 0 };
+        std::optional<RequestResponse> response;
+        bool timed_out { false };
+    };
 
-    void queue_packet_internal(DronePacket& packet);
+    void send_packet_bytes(std::span<const u8> packet_bytes);
+    // Sends the packet as is, e.g. again with the same sequence number
+    void send_packet(const DronePacket& packet);
+    // Returns the slot to wait on for the response, if `wait_for_response` is set and a slot was free
+    PendingRequestTable::Slot* queue_packet_internal(DronePacket& packet, bool wait_for_response = false);
     void queue_packet(DronePacket packet) { queue_packet_internal(packet); }
-    bool send_packet_and_wait_until_ack(DronePacket packet);
+    [[nodiscard]] RetransmitPolicy retransmit_policy(CommandID cmd_id) const;
+    // Resends the packet according to its RetransmitPolicy until the response arrives or ack_timeout passes
+    std::optional<RequestResponse> send_packet_and_wait_for_response(DronePacket packet);
+    // Returns false if no slot was free to wait for the response on, the packet is sent regardless
+    bool send_request(PendingRequest& request);
+    class ResponseAwaiter;
+    // Resends awaited requests, and resumes the coroutines whose request or delay timed out
+    void process_async_waiters();
+    void close_async_waiters();
+    // Waits for all the requests at once, resending them according to their RetransmitPolicy
+    void wait_for_responses(std::span<PendingRequest> requests, std::chrono::steady_clock::time_point deadline);
+    bool send_packet_and_wait_until_ack(DronePacket packet) { return send_packet_and_wait_for_response(std::move(packet)).has_value(); }
     void send_packet_and_assert_ack(DronePacket packet);
 
-    void handle_packet(const DronePacket& packet);
+    void handle_packet(const DronePacketView& packet);
+    void update_drone_info(const DronePacketView& packet, bool success);
+    // Queries the field with a blocking request if it is still missing, T {} if it still is afterwards
+    template<typename T>
+    T get_drone_info_field(std::optional<T> DroneInfo::*field, CommandID cmd_id);
 
-    void decode_flight_data(const std::vector<u8>& data);
-    void decode_log_data(const std::vector<u8>& data);
+    // False if the payload is too short to hold even the first fields
+    bool decode_flight_data(std::span<const u8> data);
+    void decode_log_data(std::span<const u8> data);
+    // The records are decrypted and bounds checked against the decoder's minimum length before these are called
+    void decode_mvo_record(std::span<const u8> record);
+    void decode_imu_record(std::span<const u8> record);
+    struct LogRecordDecoder {
+        LogRecordType type;
+        usize minimum_length;
+        void (Drone::*decode)(std::span<const u8> record);
+    };
+    static const LogRecordDecoder LOG_RECORD_DECODERS[];
+    void decode_signal_data(const DronePacketView&);
+    template<typename T>
+    void publish_telemetry(TelemetrySnapshot<T>&, TelemetryStream<T>&);
 
     void drone_controls_thread_routine();
     void cmd_receive_thread_routine();
     void video_receive_thread_routine();
 
+    // Single steps of the routines above, returning false once there was nothing to receive
+    void control_tick();
+    bool receive_cmd_packets(int flags);
+    bool receive_video_packets(int flags);
+    void handle_cmd_datagram(std::span<const u8> datagram, std::chrono::steady_clock::time_point receive_time);
+    std::shared_ptr<PacketCaptureWriter> get_packet_capture();
+    void handle_video_frame(VideoFrame frame);
+    void forward_video_frame(const VideoFrame& frame);
+    // Closes the queue of one queue subscription, or of all of them for good, as the drone closes
+    void close_video_queues(std::optional<u32> subscription_id = {});
+
+    DroneConfig m_config;
+    bool m_initialized { false };
+    bool m_threads_spawned { false };
+
     std::thread m_cmd_receive_thread;
-    int m_cmd_socket_fd;
+    int m_cmd_socket_fd { -1 };
+    DatagramBatch m_cmd_batch;
+    SocketCounters m_cmd_socket_counters;
+    LatencyHistogram m_cmd_receive_latency_histogram;
     sockaddr_in m_cmd_addr {};
 
     std::atomic<u16> m_cmd_seq_num { 1 };
-    std::bitset<65536> m_received_acks;
-    std::mutex m_received_acks_mutex;
-    std::condition_variable m_received_acks_cv;
+    PendingRequestTable m_pending_requests;
+    RoundTripEstimator m_round_trip_estimator;
 
     std::thread m_video_receive_thread;
-    int m_video_socket_fd;
-    int m_ffmpeg_socket_fd;
+    int m_video_socket_fd { -1 };
+    DatagramBatch m_video_batch;
+    SocketCounters m_video_socket_counters;
+    VideoLatencyHistograms m_video_latency_histograms;
+    u16 m_video_port { 0 };
+    int m_ffmpeg_socket_fd { -1 };
     sockaddr_in m_ffmpeg_addr {};
 
+    std::shared_ptr<FramePool> m_frame_pool;
+    VideoReassembler m_video_reassembler;
+
+    struct VideoSubscriber {
+        u32 id;
+        VideoFrameCallback callback;
+    };
+    std::mutex m_video_subscribers_mutex;
+    std::vector<VideoSubscriber> m_video_subscribers;
+    // The queues of queue subscriptions, under a lock of their own so they can be closed while a push holds
+    // m_video_subscribers_mutex
+    std::mutex m_video_queue_subscribers_mutex;
+    std::vector<std::pair<u32, std::shared_ptr<VideoFrameQueue>>> m_video_queue_subscribers;
+    bool m_video_queues_closed { false };
+    // Taken outside of m_video_subscribers_mutex, so a queue can be recorded before its push callback is added
+    std::atomic<u32> m_next_video_subscription_id { 1 };
+    H264Parser m_h264_parser;
+    i16 m_last_video_frame_num { -1 };
+    std::atomic<bool> m_keyframe_needed { true };
+    VideoStreamCounters m_video_stream_counters;
+    std::mutex m_video_stream_info_mutex;
+    std::optional<H264SequenceParameterSet> m_video_stream_info;
+    std::mutex m_video_recorder_mutex;
+    std::shared_ptr<VideoRecorder> m_video_recorder;
+    u32 m_video_recorder_subscription_id { 0 };
+    std::mutex m_packet_capture_mutex;
+    std::shared_ptr<PacketCaptureWriter> m_packet_capture;
+    std::atomic<bool> m_packet_capture_running { false };
+    std::atomic<bool> m_recording_keyframe_needed { false };
+    std::atomic<bool> m_keyframe_requested { false };
+
     std::thread m_drone_controls_thread;
+    DronePacketTemplate m_controls_packet { 96, CommandID::SET_CURRENT_FLIGHT_CONTROLS, 0, 11 };
 
-    // These may need locking...
+    std::mutex m_drone_info_mutex;
     DroneInfo m_drone_info;
-    FlightData m_flight_data;
-    MVOData m_mvo_data;
-    IMUData m_imu_data;
+    // Decoded into by the receive thread only, then published as a whole to the streams
+    TelemetrySnapshot<FlightData> m_flight_data;
+    TelemetrySnapshot<MVOData> m_mvo_data;
+    TelemetrySnapshot<IMUData> m_imu_data;
+    TelemetrySnapshot<SignalData> m_signal_data;
+    // Log records are decrypted into this, it only ever grows
+    std::vector<u8> m_log_record_scratch;
+    TelemetryStream<FlightData> m_flight_data_stream;
+    TelemetryStream<MVOData> m_mvo_data_stream;
+    TelemetryStream<IMUData> m_imu_data_stream;
+    TelemetryStream<SignalData> m_signal_data_stream;
+    TelemetryHistory<FlightDataColumn> m_flight_data_history;
+    TelemetryHistory<MVODataColumn> m_mvo_data_history;
+    TelemetryHistory<IMUDataColumn> m_imu_data_history;
+    // Kernel receive time of the packet being handled, stamped onto the telemetry decoded from it
+    std::chrono::steady_clock::time_point m_packet_receive_time;
 
     std::chrono::system_clock::time_point m_last_update_time;
     bool m_connected { false };
     std::mutex m_connected_mutex;
     std::condition_variable m_connected_cv;
-    u8 m_timed_request_ticks { 0 };
+    u32 m_timed_request_ticks { 0 };
+    // DroneConfig::timed_request_interval in control ticks
+    u32 m_timed_request_interval_ticks { 1 };
+    u32 m_keyframe_request_ticks { 0 };
+    u32 m_keyframe_request_interval_ticks { 1 };
+    u64 m_video_frames_at_last_timed_request { 0 };
 
     std::mutex m_controls_mutex;
     u16 m_right_stick_x { 1024 };
@@ -136,6 +365,75 @@ private:
     bool m_quick_mode { false };
 
     bool m_shutting_down { false };
+
+    struct AsyncDelay {
+        std::chrono::steady_clock::time_point resume_time;
+        std::coroutine_handle<> handle;
+    };
+    std::mutex m_async_waiters_mutex;
+    std::vector<ResponseAwaiter*> m_async_requests;
+    std::vector<AsyncDelay> m_async_delays;
+    // Only touched by the control thread, to resume coroutines after letting go of the lock
+    std::vector<std::coroutine_handle<>> m_async_resumptions;
+    bool m_async_waiters_closed { false };
+};
+
+class Drone::ResponseAwaiter {
+public:
+    ResponseAwaiter(const ResponseAwaiter&) = delete;
+    ResponseAwaiter& operator=(const ResponseAwaiter&) = delete;
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    std::optional<RequestResponse> await_resume();
+
+protected:
+    friend class Drone;
+
+    ResponseAwaiter(Drone& drone, DronePacket packet)
+        : m_drone(drone)
+        , m_request { std::move(packet) }
+    {
+    }
+
+    Drone& m_drone;
+    PendingRequest m_request;
+    // Guarded by Drone::m_async_waiters_mutex while the request is in flight
+    std::chrono::steady_clock::time_point m_deadline;
+    std::chrono::steady_clock::time_point m_retransmit_time;
+    u32 m_attempt { 0 };
+};
+
+class Drone::AckAwaiter : public ResponseAwaiter {
+public:
+    bool await_resume() { return ResponseAwaiter::await_resume().has_value(); }
+
+private:
+    friend class Drone;
+
+    AckAwaiter(Drone& drone, DronePacket packet)
+        : ResponseAwaiter(drone, std::move(packet))
+    {
+    }
+};
+
+class Drone::DelayAwaiter {
+public:
+    bool await_ready() const noexcept { return m_delay.count() <= 0; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    void await_resume() noexcept { }
+
+private:
+    friend class Drone;
+
+    DelayAwaiter(Drone& drone, std::chrono::milliseconds delay)
+        : m_drone(drone)
+        , m_delay(delay)
+    {
+    }
+
+    Drone& m_drone;
+    std::chrono::milliseconds m_delay;
 };
 
 }
@@ -1,14 +1,92 @@
 #pragma once
 
+#include <array>
+#include <bit>
+#include <cstring>
 #include <span>
 
 static constexpr u8 CRC8_SEED = 119;
 static constexpr u16 CRC16_SEED = 13970;
 
-static constexpr u8 CRC8_LOOKUP_TABLE[256] = { 0, 94, 188, 226, 97, 63, 221, 131, 194, 156, 126, 32, 163, 253, 31, 65, 157, 195, 33, 127, 252, 162, 64, 30, 95, 1, 227, 189, 62, 96, 130, 220, 35, 125, 159, 193, 66, 28, 254, 160, 225, 191, 93, 3, 128, 222, 60, 98, 190, 224, 2, 92, 223, 129, 99, 61, 124, 34, 192, 158, 29, 67, 161, 255, 70, 24, 250, 164, 39, 121, 155, 197, 132, 218, 56, 102, 229, 187, 89, 7, 219, 133, 103, 57, 186, 228, 6, 88, 25, 71, 165, 251, 120, 38, 196, 154, 101, 59, 217, 135, 4, 90, 184, 230, 167, 249, 27, 69, 198, 152, 122, 36, 248, 166, 68, 26, 153, 199, 37, 123, 58, 100, 134, 216, 91, 5, 231, 185, 140, 210, 48, 110, 237, 179, 81, 15, 78, 16, 242, 172, 47, 113, 147, 205, 17, 79, 173, 243, 112, 46, 204, 146, 211, 141, 111, 49, 178, 236, 14, 80, 175, 241, 19, 77, 206, 144, 114, 44, 109, 51, 209, 143, 12, 82, 176, 238, 50, 108, 142, 208, 83, 13, 239, 177, 240, 174, 76, 18, 145, 207, 45, 115, 202, 148, 118, 40, 171, 245, 23, 73, 8, 86, 180, 234, 105, 55, 213, 139, 87, 9, 235, 181, 54, 104, 138, 212, 149, 203, 41, 119, 244, 170, 72, 22, 233, 183, 85, 11, 136, 214, 52, 106, 43, 117, 151, 201, 74, 20, 246, 168, 116, 42, 200, 150, 21, 75, 169, 247, 182, 232, 10, 84, 215, 137, 107, 53 };
-static constexpr u16 CRC16_LOOKUP_TABLE[256] = { 0, 4489, 8978, 12955, 17956, 22445, 25910, 29887, 35912, 40385, 44890, 48851, 51820, 56293, 59774, 63735, 4225, 264, 13203, 8730, 22181, 18220, 30135, 25662, 40137, 36160, 49115, 44626, 56045, 52068, 63999, 59510, 8450, 12427, 528, 5017, 26406, 30383, 17460, 21949, 44362, 48323, 36440, 40913, 60270, 64231, 51324, 55797, 12675, 8202, 4753, 792, 30631, 26158, 21685, 17724, 48587, 44098, 40665, 36688, 64495, 60006, 55549, 51572, 16900, 21389, 24854, 28831, 1056, 5545, 10034, 14011, 52812, 57285, 60766, 64727, 34920, 39393, 43898, 47859, 21125, 17164, 29079, 24606, 5281, 1320, 14259, 9786, 57037, 53060, 64991, 60502, 39145, 35168, 48123, 43634, 25350, 29327, 16404, 20893, 9506, 13483, 1584, 6073, 61262, 65223, 52316, 56789, 43370, 47331, 35448, 39921, 29575, 25102, 20629, 16668, 13731, 9258, 5809, 1848, 65487, 60998, 56541, 52564, 47595, 43106, 39673, 35696, 33800, 38273, 42778, 46739, 49708, 54181, 57662, 61623, 2112, 6601, 11090, 15067, 20068, 24557, 28022, 31999, 38025, 34048, 47003, 42514, 53933, 49956, 61887, 57398, 6337, 2376, 15315, 10842, 24293, 20332, 32247, 27774, 42250, 46211, 34328, 38801, 58158, 62119, 49212, 53685, 10562, 14539, 2640, 7129, 28518, 32495, 19572, 24061, 46475, 41986, 38553, 34576, 62383, 57894, 53437, 49460, 14787, 10314, 6865, 2904, 32743, 28270, 23797, 19836, 50700, 55173, 58654, 62615, 32808, 37281, 41786, 45747, 19012, 23501, 26966, 30943, 3168, 7657, 12146, 16123, 54925, 50948, 62879, 58390, 37033, 33056, 46011, 41522, 23237, 19276, 31191, 26718, 7393, 3432, 16371, 11898, 59150, 63111, 50204, 54677, 41258, 45219, 33336, 37809, 27462, 31439, 18516, 23005, 11618, 15595, 3696, 8185, 63375, 58886, 54429, 50452, 45483, 40994, 37561, 33584, 31687, 27214, 22741, 18780, 15843, 11370, 7921, 3960 };
+// Both CRCs are reflected: CRC8 uses the Dallas/Maxim polynomial (0x31), CRC16 the CCITT polynomial (0x1021)
+static constexpr u8 CRC8_REFLECTED_POLYNOMIAL = 0x8C;
+static constexpr u16 CRC16_REFLECTED_POLYNOMIAL = 0x8408;
+static constexpr usize CRC16_SLICES = 8;
 
-static u8 fast_crc8(std::span<u8> bytes)
+static constexpr std::array<u8, 256> generate_crc8_table()
+{
+    std::array<u8, 256> table {};
+    for (usize i = 0; i < 256; ++i) {
+        u8 crc = i;
+        for (usize bit = 0; bit < 8; ++bit)
+            crc = (crc & 1) ? (crc >> 1) ^ CRC8_REFLECTED_POLYNOMIAL : crc >> 1;
+        table[i] = crc;
+    }
+    return table;
+}
+
+// Table k advances the CRC over a byte followed by k zero bytes, which is what slice-by-N needs
+static constexpr std::array<std::array<u16, 256>, CRC16_SLICES> generate_crc16_tables()
+{
+    std::array<std::array<u16, 256>, CRC16_SLICES> tables {};
+    for (usize i = 0; i < 256; ++i) {
+        u16 crc = i;
+        for (usize bit = 0; bit < 8; ++bit)
+            crc = (crc & 1) ? (crc >> 1) ^ CRC16_REFLECTED_POLYNOMIAL : crc >> 1;
+        tables[0][i] = crc;
+    }
+    for (usize slice = 1; slice < CRC16_SLICES; ++slice) {
+        for (usize i = 0; i < 256; ++i)
+            tables[slice][i] = (tables[slice - 1][i] >> 8) ^ tables[0][tables[slice - 1][i] & 0xFF];
+    }
+    return tables;
+}
+
+static constexpr auto CRC8_LOOKUP_TABLE = generate_crc8_table();
+static constexpr auto CRC16_LOOKUP_TABLES = generate_crc16_tables();
+static constexpr auto& CRC16_LOOKUP_TABLE = CRC16_LOOKUP_TABLES[0];
+
+// Spot checks against the tables the protocol was originally reversed with
+static_assert(CRC8_LOOKUP_TABLE[1] == 94 && CRC8_LOOKUP_TABLE[128] == 140 && CRC8_LOOKUP_TABLE[255] == 53);
+static_assert(CRC16_LOOKUP_TABLE[1] == 4489 && CRC16_LOOKUP_TABLE[128] == 33800 && CRC16_LOOKUP_TABLE[255] == 3960);
+
+// Independent reference for every table entry: the unreflected, MSB-first CRC over the bit reversed register,
+// shifted one bit at a time. This also checks that the reflected polynomials above match the documented ones
+template<typename T>
+static constexpr T reverse_crc_bits(T value)
+{
+    T reversed = 0;
+    for (usize bit = 0; bit < sizeof(T) * 8; ++bit)
+        reversed |= ((value >> bit) & 1) << (sizeof(T) * 8 - 1 - bit);
+    return reversed;
+}
+
+template<typename T>
+static constexpr T crc_reference_shift(T value, T polynomial, usize bits)
+{
+    constexpr T top_bit = T(1) << (sizeof(T) * 8 - 1);
+    T crc = reverse_crc_bits(value);
+    for (usize bit = 0; bit < bits; ++bit)
+        crc = (crc & top_bit) ? T(crc << 1) ^ polynomial : T(crc << 1);
+    return reverse_crc_bits(crc);
+}
+
+static constexpr bool crc_tables_match_reference()
+{
+    for (usize i = 0; i < 256; ++i) {
+        if (CRC8_LOOKUP_TABLE[i] != crc_reference_shift<u8>(i, 0x31, 8))
+            return false;
+        // Table k shifts the register by the byte plus k zero bytes
+        for (usize slice = 0; slice < CRC16_SLICES; ++slice) {
+            if (CRC16_LOOKUP_TABLES[slice][i] != crc_reference_shift<u16>(i, 0x1021, 8 * (slice + 1)))
+                return false;
+        }
+    }
+    return true;
+}
+static_assert(crc_tables_match_reference());
+
+static u8 fast_crc8(std::span<const u8> bytes)
 {
     u8 crc = CRC8_SEED;
     for (u8 byte : bytes) {
@@ -17,11 +95,39 @@ static u8 fast_crc8(std::span<u8> bytes)
     return crc;
 }
 
-static u16 fast_crc16(std::span<u8> bytes)
+// One byte per iteration, kept as the reference the sliced version is verified against
+static u16 crc16_update_bytewise(u16 crc, std::span<const u8> bytes)
 {
-    u16 crc = CRC16_SEED;
     for (u8 byte : bytes) {
         crc = CRC16_LOOKUP_TABLE[(crc ^ (u16)byte) & 0xFF] ^ (crc >> 8);
     }
     return crc;
 }
+
+// Continues a CRC16 over more bytes, so a packet whose prefix never changes only needs its
+// checksum state after the prefix to be cached, see `DronePacketTemplate`
+static u16 crc16_update(u16 crc, std::span<const u8> bytes)
+{
+    if constexpr (std::endian::native != std::endian::little)
+        return crc16_update_bytewise(crc, bytes);
+
+    auto* data = bytes.data();
+    auto remaining = bytes.size();
+    while (remaining >= CRC16_SLICES) {
+        u64 chunk;
+        memcpy(&chunk, data, sizeof(chunk));
+        chunk ^= crc;
+        crc = CRC16_LOOKUP_TABLES[7][chunk & 0xFF] ^ CRC16_LOOKUP_TABLES[6][(chunk >> 8) & 0xFF]
+            ^ CRC16_LOOKUP_TABLES[5][(chunk >> 16) & 0xFF] ^ CRC16_LOOKUP_TABLES[4][(chunk >> 24) & 0xFF]
+            ^ CRC16_LOOKUP_TABLES[3][(chunk >> 32) & 0xFF] ^ CRC16_LOOKUP_TABLES[2][(chunk >> 40) & 0xFF]
+            ^ CRC16_LOOKUP_TABLES[1][(chunk >> 48) & 0xFF] ^ CRC16_LOOKUP_TABLES[0][chunk >> 56];
+        data += CRC16_SLICES;
+        remaining -= CRC16_SLICES;
+    }
+    return crc16_update_bytewise(crc, { data, remaining });
+}
+
+static u16 fast_crc16(std::span<const u8> bytes)
+{
+    return crc16_update(CRC16_SEED, bytes);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Types.h"
+#include <atomic>
+
+namespace Tello {
+
+// For counters that only ever one thread bumps: a relaxed load and store instead of a read-modify-write
+// atomic, which any other thread can still read (and snapshot) at any time
+inline void increment_counter(std::atomic<u64>& counter, u64 amount = 1)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Types.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <optional>
+#include <span>
+#include <sys/socket.h>
+#include <vector>
+
+namespace Tello {
+
+// A preallocated ring of datagram buffers, filled by a single recvmmsg() call per `receive`. Kernel
+// receive timestamps are picked up as well when the socket has SO_TIMESTAMPNS enabled.
+class DatagramBatch {
+public:
+    DatagramBatch(usize depth, usize buffer_size)
+        : m_depth(std::max<usize>(depth, 1))
+        , m_buffer_size(buffer_size)
+        , m_buffers(std::make_unique<u8[]>(m_depth * buffer_size))
+        , m_control_buffers(std::make_unique<u8[]>(m_depth * CONTROL_BUFFER_SIZE))
+        , m_iovecs(m_depth)
+        , m_headers(m_depth)
+    {
+        for (usize i = 0; i < m_depth; ++i) {
+            m_iovecs[i].iov_base = m_buffers.get() + i * buffer_size;
+            m_iovecs[i].iov_len = buffer_size;
+            m_headers[i].msg_hdr.msg_iov = &m_iovecs[i];
+            m_headers[i].msg_hdr.msg_iovlen = 1;
+            m_headers[i].msg_hdr.msg_control = m_control_buffers.get() + i * CONTROL_BUFFER_SIZE;
+        }
+    }
+
+    // Blocks (unless `flags` contains MSG_DONTWAIT) until at least one datagram is available, then takes
+    // as many as are queued up to the batch depth. Returns the number of datagrams, or -1 with errno set.
+    isize receive(int socket_fd, int flags)
+    {
+        // The kernel shrinks these to what it actually wrote
+        for (auto& header : m_headers)
+            header.msg_hdr.msg_controllen = CONTROL_BUFFER_SIZE;
+        int received = recvmmsg(socket_fd, m_headers.data(), m_depth, flags | MSG_WAITFORONE, nullptr);
+        m_count = received < 0 ? 0 : received;
+        return received;
+    }
+
+    // When the kernel received the datagram, if the socket has SO_TIMESTAMPNS enabled
+    [[nodiscard]] std::optional<std::chrono::system_clock::time_point> timestamp(usize index)
+    {
+        auto& header = m_headers[index].msg_hdr;
+        for (auto* control = CMSG_FIRSTHDR(&header); control; control = CMSG_NXTHDR(&header, control)) {
+            if (control->cmsg_level == SOL_SOCKET && control->cmsg_type == SCM_TIMESTAMPNS) {
+                timespec time;
+                std::memcpy(&time, CMSG_DATA(control), sizeof(time));
+                return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                    std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec)));
+            }
+        }
+        return {};
+    }
+
+    [[nodiscard]] usize depth() const { return m_depth; }
+    [[nodiscard]] usize size() const { return m_count; }
+
+    [[nodiscard]] std::span<u8> datagram(usize index)
+    {
+        return { m_buffers.get() + index * m_buffer_size, m_headers[index].msg_len };
+    }
+
+private:
+    static constexpr usize CONTROL_BUFFER_SIZE = CMSG_SPACE(sizeof(timespec));
+
+    usize m_depth;
+    usize m_buffer_size;
+    usize m_count { 0 };
+    std::unique_ptr<u8[]> m_buffers;
+    std::unique_ptr<u8[]> m_control_buffers;
+    std::vector<iovec> m_iovecs;
+    std::vector<mmsghdr> m_headers;
+};
+
+}
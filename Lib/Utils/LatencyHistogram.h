@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Counter.h"
+#include "Types.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+
+namespace Tello {
+
+struct LatencySummary {
+    u64 count { 0 };
+    std::chrono::nanoseconds mean {};
+    std::chrono::nanoseconds p50 {};
+    std::chrono::nanoseconds p99 {};
+    std::chrono::nanoseconds max {};
+};
+
+// Log-linear histogram of durations: every power of two is split into 16 buckets, so percentiles are
+// within ~6% of the recorded values. Written by a single thread, read from any.
+class LatencyHistogram {
+public:
+    void record(std::chrono::nanoseconds duration)
+    {
+        u64 value = std::max<i64>(duration.count(), 0);
+        increment_counter(m_buckets[bucket_index(value)]);
+        increment_counter(m_count);
+        increment_counter(m_sum, value);
+        if (value > m_max.load(std::memory_order_relaxed))
+            m_max.store(value, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] LatencySummary summary() const
+    {
+        LatencySummary summary;
+        summary.count = m_count.load(std::memory_order_relaxed);
+        if (summary.count == 0)
+            return summary;
+        summary.mean = std::chrono::nanoseconds(m_sum.load(std::memory_order_relaxed) / summary.count);
+        summary.max = std::chrono::nanoseconds(m_max.load(std::memory_order_relaxed));
+        summary.p50 = std::min(percentile(summary.count, 0.50), summary.max);
+        summary.p99 = std::min(percentile(summary.count, 0.99), summary.max);
+        return summary;
+    }
+
+    // Not synchronized with `record`, a racing sample may survive the reset
+    void reset()
+    {
+        for (auto& bucket : m_buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        m_count.store(0, std::memory_order_relaxed);
+        m_sum.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr u8 SUB_BUCKET_BITS = 4;
+    static constexpr usize SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr usize BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static usize bucket_index(u64 value)
+    {
+        if (value < SUB_BUCKETS)
+            return value;
+        u8 shift = std::bit_width(value) - 1 - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    // The largest value that falls into the bucket
+    static u64 bucket_upper_bound(usize index)
+    {
+        if (index < SUB_BUCKETS)
+            return index;
+        u8 shift = index / SUB_BUCKETS - 1;
+        u64 lower_bound = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+        return lower_bound + ((u64(1) << shift) - 1);
+    }
+
+    std::chrono::nanoseconds percentile(u64 count, double fraction) const
+    {
+        auto rank = std::max<u64>(static_cast<u64>(count * fraction + 0.5), 1);
+        u64 seen = 0;
+        for (usize i = 0; i < BUCKET_COUNT; ++i) {
+            seen += m_buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+                return std::chrono::nanoseconds(bucket_upper_bound(i));
+        }
+        return std::chrono::nanoseconds(m_max.load(std::memory_order_relaxed));
+    }
+
+    std::array<std::atomic<u64>, BUCKET_COUNT> m_buckets {};
+    std::atomic<u64> m_count { 0 };
+    std::atomic<u64> m_sum { 0 };
+    std::atomic<u64> m_max { 0 };
+};
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Types.h"
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+namespace Tello {
+
+// Publishes a value from a single writer to any number of readers without either side blocking: the writer
+// bumps the sequence to odd, stores the value and bumps it back to even, readers copy the value and retry if
+// the sequence was odd or changed meanwhile. The value is stored as relaxed atomic words, so a read that races
+// with a write is a retry rather than a data race.
+template<typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>);
+
+public:
+    Seqlock() { store(T {}); }
+
+    void store(const T& value)
+    {
+        std::array<u64, WORD_COUNT> words {};
+        std::memcpy(words.data(), &value, sizeof(T));
+        auto sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (usize i = 0; i < WORD_COUNT; ++i)
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    [[nodiscard]] T load() const
+    {
+        std::array<u64, WORD_COUNT> words;
+        u64 sequence_before;
+        u64 sequence_after;
+        do {
+            sequence_before = m_sequence.load(std::memory_order_acquire);
+            for (usize i = 0; i < WORD_COUNT; ++i)
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            sequence_after = m_sequence.load(std::memory_order_relaxed);
+        } while ((sequence_before & 1) || sequence_before != sequence_after);
+        T value;
+        std::memcpy(&value, words.data(), sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr usize WORD_COUNT = (sizeof(T) + sizeof(u64) - 1) / sizeof(u64);
+
+    std::atomic<u64> m_sequence { 0 };
+    std::array<std::atomic<u64>, WORD_COUNT> m_words;
+};
+
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace Tello {
+
+template<typename T>
+class Task;
+
+namespace Detail {
+
+struct TaskPromiseBase {
+    // Resumes whoever awaited the task once it finished
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept { return handle.promise().continuation; }
+        void await_resume() noexcept { }
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    // Everything is built with -fno-exceptions
+    void unhandled_exception() noexcept { std::terminate(); }
+
+    std::coroutine_handle<> continuation { std::noop_coroutine() };
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase {
+    Task<T> get_return_object();
+    void return_value(T value) { result.emplace(std::move(value)); }
+    T take_result() { return std::move(*result); }
+
+    std::optional<T> result;
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() { }
+    void take_result() { }
+};
+
+// Runs eagerly and frees itself once done, for starting tasks from outside a coroutine
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() { }
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+}
+
+// A coroutine that starts once it is co_awaited (or handed to sync_wait) and resumes its awaiter when it
+// finishes, on whichever thread it finished on
+template<typename T = void>
+class [[nodiscard]] Task {
+public:
+    using promise_type = Detail::TaskPromise<T>;
+
+    Task(Task&& other) noexcept
+        : m_handle(std::exchange(other.m_handle, {}))
+    {
+    }
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            if (m_handle)
+                m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+    ~Task()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+    T await_resume() { return m_handle.promise().take_result(); }
+
+private:
+    friend promise_type;
+
+    explicit Task(std::coroutine_handle<promise_type> handle)
+        : m_handle(handle)
+    {
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+namespace Detail {
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object()
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object()
+{
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+struct SyncWaitState {
+    std::mutex mutex;
+    std::condition_variable finished_cv;
+    bool finished { false };
+};
+
+template<typename T>
+DetachedTask run_and_signal(Task<T>& task, std::optional<T>& result, SyncWaitState& state)
+{
+    result.emplace(co_await task);
+    // Signalled under the lock, the state is gone as soon as the waiting thread sees `finished`
+    std::lock_guard lock(state.mutex);
+    state.finished = true;
+    state.finished_cv.notify_one();
+}
+
+inline DetachedTask run_and_signal(Task<void>& task, SyncWaitState& state)
+{
+    co_await task;
+    std::lock_guard lock(state.mutex);
+    state.finished = true;
+    state.finished_cv.notify_one();
+}
+
+struct WhenAllAwaiter {
+    static DetachedTask run_and_count(Task<void>& task, WhenAllAwaiter& awaiter)
+    {
+        co_await task;
+        if (awaiter.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            awaiter.continuation.resume();
+    }
+
+    bool await_ready() const noexcept { return tasks.empty(); }
+    bool await_suspend(std::coroutine_handle<> awaiting)
+    {
+        continuation = awaiting;
+        // One extra count keeps tasks that finish right away from resuming the awaiter before it suspended
+        remaining.store(tasks.size() + 1, std::memory_order_relaxed);
+        for (auto& task : tasks)
+            run_and_count(task, *this);
+        return remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+    void await_resume() noexcept { }
+
+    std::vector<Task<void>>& tasks;
+    std::atomic<std::size_t> remaining { 0 };
+    std::coroutine_handle<> continuation;
+};
+
+}
+
+// Runs the task on the calling thread until it first suspends, then blocks until it finished
+template<typename T>
+T sync_wait(Task<T> task)
+{
+    Detail::SyncWaitState state;
+    std::optional<T> result;
+    Detail::run_and_signal(task, result, state);
+    std::unique_lock lock(state.mutex);
+    state.finished_cv.wait(lock, [&] { return state.finished; });
+    return std::move(*result);
+}
+
+inline void sync_wait(Task<void> task)
+{
+    Detail::SyncWaitState state;
+    Detail::run_and_signal(task, state);
+    std::unique_lock lock(state.mutex);
+    state.finished_cv.wait(lock, [&] { return state.finished; });
+}
+
+// Runs the tasks concurrently, finishing once all of them did
+inline Task<void> when_all(std::vector<Task<void>> tasks)
+{
+    co_await Detail::WhenAllAwaiter { tasks };
+}
+
+}
@@ -0,0 +1,221 @@
+#include "VideoDecoder.h"
+#include "H264Parser.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+namespace Tello {
+
+static void print_av_error(char const* function, int error)
+{
+    char message[AV_ERROR_MAX_STRING_SIZE] {};
+    av_strerror(error, message, sizeof(message));
+    std::cerr << function << ": " << message << std::endl;
+}
+
+std::unique_ptr<VideoDecoder> VideoDecoder::create(VideoDecoderConfig config, DecodedFrameCallback callback,
+    KeyframeNeededCallback keyframe_needed)
+{
+    std::unique_ptr<VideoDecoder> decoder(new VideoDecoder(std::move(config), std::move(callback), std::move(keyframe_needed)));
+    if (!decoder->open_codec())
+        return nullptr;
+    decoder->m_decode_thread = std::thread(&VideoDecoder::decode_thread_routine, decoder.get());
+    return decoder;
+}
+
+VideoDecoder::VideoDecoder(VideoDecoderConfig config, DecodedFrameCallback callback, KeyframeNeededCallback keyframe_needed)
+    : m_config(std::move(config))
+    , m_callback(std::move(callback))
+    , m_keyframe_needed(std::move(keyframe_needed))
+    , m_queue(m_config.queue_capacity, FrameQueuePolicy::DropOldest)
+{
+}
+
+VideoDecoder::~VideoDecoder()
+{
+    close();
+    sws_freeContext(m_conversion_context);
+    av_frame_free(&m_converted_picture);
+    av_frame_free(&m_picture);
+    av_packet_free(&m_packet);
+    avcodec_free_context(&m_codec_context);
+}
+
+bool VideoDecoder::open_codec()
+{
+    auto* codec = avcodec_find_decoder(AV_CODEC_ID_H264);
+    if (!codec) {
+        std::cerr << "libavcodec was built without an H264 decoder" << std::endl;
+        return false;
+    }
+    m_codec_context = avcodec_alloc_context3(codec);
+    m_packet = av_packet_alloc();
+    m_picture = av_frame_alloc();
+    m_converted_picture = av_frame_alloc();
+    if (!m_codec_context || !m_packet || !m_picture || !m_converted_picture) {
+        std::cerr << "Failed to allocate the video decoder" << std::endl;
+        return false;
+    }
+
+    m_codec_context->thread_count = m_config.thread_count;
+    if (m_config.low_delay) {
+        m_codec_context->flags |= AV_CODEC_FLAG_LOW_DELAY;
+        m_codec_context->thread_type = FF_THREAD_SLICE;
+    }
+    if (m_config.fast)
+        m_codec_context->flags2 |= AV_CODEC_FLAG2_FAST;
+
+    if (auto error = avcodec_open2(m_codec_context, codec, nullptr); error < 0) {
+        print_av_error("avcodec_open2()", error);
+        return false;
+    }
+    return true;
+}
+
+void VideoDecoder::submit(const VideoFrame& frame)
+{
+    m_queue.push(frame);
+}
+
+void VideoDecoder::close()
+{
+    m_queue.close();
+    if (m_decode_thread.joinable())
+        m_decode_thread.join();
+}
+
+void VideoDecoder::decode_thread_routine()
+{
+    // The stream may be anywhere in between two IDR frames when decoding starts
+    if (m_keyframe_needed)
+        m_keyframe_needed();
+
+    while (auto queued_frame = m_queue.pop()) {
+        auto& frame = queued_frame->frame;
+
+        if (m_keyframe_gate.note_popped(*queued_frame) && m_keyframe_needed)
+            m_keyframe_needed();
+
+        if (m_keyframe_gate.is_waiting()) {
+            bool has_idr_slice = false;
+            bool has_slice = false;
+            H264NALUnitReader reader(frame.data());
+            H264NALUnit nal_unit;
+            while (reader.next(nal_unit)) {
+                has_idr_slice |= nal_unit.type == H264NALUnitType::IDRSlice;
+                has_slice |= nal_unit.type == H264NALUnitType::IDRSlice || nal_unit.type == H264NALUnitType::NonIDRSlice
+                    || nal_unit.type == H264NALUnitType::SliceDataPartitionA;
+            }
+            switch (m_keyframe_gate.admit(has_idr_slice, has_slice)) {
+            case KeyframeGate::Decision::Skip:
+                increment_counter(m_counters.frames_skipped);
+                continue;
+            case KeyframeGate::Decision::Resume:
+                // Drops the references to the pictures before the gap
+                avcodec_flush_buffers(m_codec_context);
+                break;
+            case KeyframeGate::Decision::Pass:
+                // Parameter sets are passed on regardless, the IDR frame needs them
+                break;
+            }
+        }
+
+        decode(frame);
+    }
+}
+
+void VideoDecoder::decode(const VideoFrame& frame)
+{
+    auto data = frame.data();
+    m_input_buffer.resize(data.size() + AV_INPUT_BUFFER_PADDING_SIZE);
+    memcpy(m_input_buffer.data(), data.data(), data.size());
+    memset(m_input_buffer.data() + data.size(), 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+    auto pts = m_next_pts++;
+    m_submitted_frames[pts % SUBMITTED_FRAME_HISTORY] = { frame.frame_num(), frame.timestamps(), std::chrono::steady_clock::now() };
+
+    m_packet->data = m_input_buffer.data();
+    m_packet->size = static_cast<int>(data.size());
+    m_packet->pts = pts;
+    m_packet->dts = pts;
+    auto error = avcodec_send_packet(m_codec_context, m_packet);
+    av_packet_unref(m_packet);
+    if (error < 0) {
+        if constexpr (VIDEO_DECODER_DEBUG_LOGGING)
+            print_av_error("avcodec_send_packet()", error);
+        increment_counter(m_counters.decode_errors);
+        return;
+    }
+
+    while (true) {
+        error = avcodec_receive_frame(m_codec_context, m_picture);
+        if (error == AVERROR(EAGAIN) || error == AVERROR_EOF)
+            break;
+        if (error < 0) {
+            if constexpr (VIDEO_DECODER_DEBUG_LOGGING)
+                print_av_error("avcodec_receive_frame()", error);
+            increment_counter(m_counters.decode_errors);
+            break;
+        }
+        deliver(m_picture);
+        av_frame_unref(m_picture);
+    }
+}
+
+void VideoDecoder::deliver(AVFrame* picture)
+{
+    auto* output = picture;
+    auto format = m_config.pixel_format == DecodedPixelFormat::BGR24 ? AV_PIX_FMT_BGR24 : AV_PIX_FMT_YUV420P;
+    if (picture->format != format) {
+        if (m_converted_picture->width != picture->width || m_converted_picture->height != picture->height
+            || m_converted_picture->format != format) {
+            av_frame_unref(m_converted_picture);
+            m_converted_picture->width = picture->width;
+            m_converted_picture->height = picture->height;
+            m_converted_picture->format = format;
+            if (auto error = av_frame_get_buffer(m_converted_picture, 0); error < 0) {
+                print_av_error("av_frame_get_buffer()", error);
+                increment_counter(m_counters.decode_errors);
+                return;
+            }
+        }
+        m_conversion_context = sws_getCachedContext(m_conversion_context, picture->width, picture->height,
+            static_cast<AVPixelFormat>(picture->format), picture->width, picture->height, format, SWS_BILINEAR, nullptr,
+            nullptr, nullptr);
+        if (!m_conversion_context) {
+            std::cerr << "sws_getCachedContext() failed" << std::endl;
+            increment_counter(m_counters.decode_errors);
+            return;
+        }
+        sws_scale(m_conversion_context, picture->data, picture->linesize, 0, picture->height, m_converted_picture->data,
+            m_converted_picture->linesize);
+        output = m_converted_picture;
+    }
+
+    auto& submitted = m_submitted_frames[static_cast<u64>(picture->pts) % SUBMITTED_FRAME_HISTORY];
+    DecodedVideoFrame decoded;
+    decoded.width = output->width;
+    decoded.height = output->height;
+    decoded.pixel_format = m_config.pixel_format;
+    usize plane_count = m_config.pixel_format == DecodedPixelFormat::BGR24 ? 1 : 3;
+    for (usize i = 0; i < plane_count; ++i) {
+        usize rows = i == 0 ? output->height : (output->height + 1) / 2;
+        decoded.strides[i] = output->linesize[i];
+        decoded.planes[i] = { output->data[i], decoded.strides[i] * rows };
+    }
+    decoded.frame_num = submitted.frame_num;
+    decoded.timestamps = submitted.timestamps;
+    decoded.decode_time = std::chrono::steady_clock::now() - submitted.submit_time;
+
+    m_counters.decode_time.record(decoded.decode_time);
+    increment_counter(m_counters.frames_decoded);
+    m_callback(decoded);
+}
+
+}
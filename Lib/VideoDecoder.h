@@ -0,0 +1,124 @@
+#pragma once
+
+#include "DroneStatistics.h"
+#include "FramePool.h"
+#include "VideoFrameQueue.h"
+#include "Utils/Types.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Only built when libavcodec is found, see CMakeLists.txt
+
+struct AVCodecContext;
+struct AVFrame;
+struct AVPacket;
+struct SwsContext;
+
+namespace Tello {
+
+#define VIDEO_DECODER_DEBUG_LOGGING 0
+
+enum class DecodedPixelFormat {
+    // Planar Y, U and V, what the drone's encoder produces, so no conversion is needed
+    YUV420P,
+    // Packed 8 bit B, G, R, e.g. for a cv::Mat of type CV_8UC3
+    BGR24,
+};
+
+struct DecodedVideoFrame {
+    u32 width { 0 };
+    u32 height { 0 };
+    DecodedPixelFormat pixel_format { DecodedPixelFormat::YUV420P };
+    // Y, U and V for DecodedPixelFormat::YUV420P, only the first plane for DecodedPixelFormat::BGR24
+    std::array<std::span<const u8>, 3> planes {};
+    std::array<usize, 3> strides {};
+    u8 frame_num { 0 };
+    VideoFrameTimestamps timestamps;
+    std::chrono::nanoseconds decode_time {};
+};
+
+struct VideoDecoderConfig {
+    DecodedPixelFormat pixel_format { DecodedPixelFormat::YUV420P };
+    // Outputs every picture as soon as it is decoded (AV_CODEC_FLAG_LOW_DELAY), and only uses slice threads
+    // as frame threads hold back one frame each
+    bool low_delay { true };
+    // Allows speedups that are not bit exact (AV_CODEC_FLAG2_FAST)
+    bool fast { false };
+    // 0 lets libavcodec pick
+    int thread_count { 1 };
+    // Access units waiting for the decode thread, they hold on to frame pool buffers
+    usize queue_capacity { 4 };
+};
+
+// Decodes reassembled access units in-process on a thread of its own and hands the pictures to a callback,
+// without going through a UDP socket and a probing ffmpeg. Decoding is allowed to fall behind the stream:
+// access units it has no time for are dropped from its queue, and a KeyframeGate keeps the pictures that
+// depend on them away from libavcodec.
+class VideoDecoder {
+public:
+    // Runs on the decode thread. The planes are only valid during the call.
+    using DecodedFrameCallback = std::function<void(const DecodedVideoFrame&)>;
+    // Runs on the decode thread when it starts waiting for an IDR frame, e.g. Drone::request_keyframe_soon
+    using KeyframeNeededCallback = std::function<void()>;
+
+    // Returns nothing if libavcodec has no H264 decoder or it failed to open
+    static std::unique_ptr<VideoDecoder> create(VideoDecoderConfig config, DecodedFrameCallback callback,
+        KeyframeNeededCallback keyframe_needed = {});
+    ~VideoDecoder();
+
+    VideoDecoder(const VideoDecoder&) = delete;
+    VideoDecoder& operator=(const VideoDecoder&) = delete;
+
+    // Called from the video receive thread (e.g. as a Drone video frame subscriber), never blocks
+    void submit(const VideoFrame& frame);
+
+    // Decodes what is still queued and stops the decode thread
+    void close();
+
+    [[nodiscard]] const VideoDecoderConfig& config() const { return m_config; }
+    [[nodiscard]] VideoDecoderStatistics get_statistics() const { return m_counters.snapshot(m_queue.get_statistics().frames_dropped); }
+
+private:
+    // Matches the frames coming out of the decoder with the access units that went in, by pts
+    struct SubmittedFrame {
+        u8 frame_num { 0 };
+        VideoFrameTimestamps timestamps;
+        std::chrono::steady_clock::time_point submit_time;
+    };
+    static constexpr usize SUBMITTED_FRAME_HISTORY = 16;
+
+    VideoDecoder(VideoDecoderConfig config, DecodedFrameCallback callback, KeyframeNeededCallback keyframe_needed);
+
+    bool open_codec();
+    void decode_thread_routine();
+    void decode(const VideoFrame& frame);
+    void deliver(AVFrame* picture);
+
+    VideoDecoderConfig m_config;
+    DecodedFrameCallback m_callback;
+    KeyframeNeededCallback m_keyframe_needed;
+    VideoFrameQueue m_queue;
+    std::thread m_decode_thread;
+    VideoDecoderCounters m_counters;
+
+    // Everything below is only touched by the decode thread
+    AVCodecContext* m_codec_context { nullptr };
+    AVPacket* m_packet { nullptr };
+    AVFrame* m_picture { nullptr };
+    AVFrame* m_converted_picture { nullptr };
+    SwsContext* m_conversion_context { nullptr };
+    // Access units are copied here as libavcodec wants zeroed padding after its input
+    std::vector<u8> m_input_buffer;
+
+    std::array<SubmittedFrame, SUBMITTED_FRAME_HISTORY> m_submitted_frames {};
+    i64 m_next_pts { 0 };
+    KeyframeGate m_keyframe_gate;
+};
+
+}
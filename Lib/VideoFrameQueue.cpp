@@ -0,0 +1,189 @@
+#include "VideoFrameQueue.h"
+#include <bit>
+#include <thread>
+
+namespace Tello {
+
+VideoFrameQueue::VideoFrameQueue(usize capacity, FrameQueuePolicy policy)
+    : m_policy(policy)
+    , m_capacity(policy == FrameQueuePolicy::LatestOnly ? 2 : std::bit_ceil(std::max<usize>(capacity, 2)))
+    , m_slots(std::make_unique<Slot[]>(m_capacity))
+{
+    for (usize i = 0; i < m_capacity; ++i)
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+VideoFrameQueue::~VideoFrameQueue()
+{
+    close();
+}
+
+// Every slot carries a sequence number (as in Dmitry Vyukov's bounded queue): `position` when it is free
+// for the push at that position, `position + 1` once that push filled it, and `position + capacity` once
+// the frame was taken out again, which frees it for the next lap. This needs at least two slots to tell a
+// filled slot from a free one, which is also why FrameQueuePolicy::LatestOnly uses two.
+
+bool VideoFrameQueue::try_push(VideoFrame& frame)
+{
+    auto& slot = m_slots[m_push_position & (m_capacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != m_push_position)
+        return false;
+
+    slot.frame = std::move(frame);
+    slot.push_time = std::chrono::steady_clock::now();
+    slot.sequence.store(m_push_position + 1, std::memory_order_release);
+    m_push_position++;
+    return true;
+}
+
+std::optional<usize> VideoFrameQueue::try_take(VideoFrame& frame, std::chrono::steady_clock::time_point& push_time)
+{
+    auto position = m_pop_position.load(std::memory_order_relaxed);
+    while (true) {
+        auto& slot = m_slots[position & (m_capacity - 1)];
+        auto sequence = slot.sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<isize>(sequence - (position + 1));
+        if (difference < 0)
+            return {};
+        if (difference > 0) {
+            // Someone else took this frame already
+            position = m_pop_position.load(std::memory_order_relaxed);
+            continue;
+        }
+        if (m_pop_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+            frame = std::move(slot.frame);
+            push_time = slot.push_time;
+            slot.sequence.store(position + m_capacity, std::memory_order_release);
+            return position;
+        }
+    }
+}
+
+bool VideoFrameQueue::push(VideoFrame frame)
+{
+    VideoFrame stale_frame;
+    std::chrono::steady_clock::time_point push_time;
+    while (!is_closed()) {
+        if (m_policy == FrameQueuePolicy::LatestOnly) {
+            while (try_take(stale_frame, push_time))
+                increment_counter(m_frames_dropped);
+        }
+
+        auto pop_count = m_pop_count.load(std::memory_order_acquire);
+        if (try_push(frame)) {
+            increment_counter(m_frames_pushed);
+            m_push_count.fetch_add(1, std::memory_order_release);
+            m_push_count.notify_one();
+            notify_timed_waiter();
+            return true;
+        }
+
+        if (m_policy == FrameQueuePolicy::Block) {
+            m_pop_count.wait(pop_count, std::memory_order_acquire);
+            continue;
+        }
+
+        // The slot may also still be held by a consumer that is just moving its frame out, in which case
+        // this goes around again once the consumer had a chance to finish
+        if (try_take(stale_frame, push_time))
+            increment_counter(m_frames_dropped);
+        else
+            std::this_thread::yield();
+    }
+    return false;
+}
+
+std::optional<QueuedVideoFrame> VideoFrameQueue::try_pop()
+{
+    VideoFrame frame;
+    std::chrono::steady_clock::time_point push_time;
+    auto position = try_take(frame, push_time);
+    if (!position)
+        return {};
+    bool frames_dropped_before = *position != m_next_expected_position;
+    m_next_expected_position = *position + 1;
+
+    increment_counter(m_frames_popped);
+    m_pop_count.fetch_add(1, std::memory_order_release);
+    if (m_policy == FrameQueuePolicy::Block)
+        m_pop_count.notify_one();
+    return QueuedVideoFrame { std::move(frame), std::chrono::steady_clock::now() - push_time, frames_dropped_before };
+}
+
+std::optional<QueuedVideoFrame> VideoFrameQueue::pop()
+{
+    while (true) {
+        auto push_count = m_push_count.load(std::memory_order_acquire);
+        if (auto frame = try_pop())
+            return frame;
+        if (is_closed())
+            return {};
+        m_push_count.wait(push_count, std::memory_order_acquire);
+    }
+}
+
+std::optional<QueuedVideoFrame> VideoFrameQueue::pop_until(std::chrono::steady_clock::time_point deadline)
+{
+    if (auto frame = try_pop())
+        return frame;
+    m_timed_waiter.store(true, std::memory_order_relaxed);
+    // Pairs with the fence in notify_timed_waiter: either the push sees the waiter or we see the frame
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::optional<QueuedVideoFrame> frame;
+    std::unique_lock lock(m_timed_wait_mutex);
+    bool ready = m_timed_wait_cv.wait_until(lock, deadline, [&] {
+        frame = try_pop();
+        return frame || is_closed();
+    });
+    lock.unlock();
+    m_timed_waiter.store(false, std::memory_order_relaxed);
+    // Closed after the deadline passed, whatever was pushed before still has to come out
+    if (!ready && is_closed())
+        frame = try_pop();
+    return frame;
+}
+
+void VideoFrameQueue::notify_timed_waiter()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_timed_waiter.load(std::memory_order_relaxed)) {
+        { std::lock_guard lock(m_timed_wait_mutex); }
+        m_timed_wait_cv.notify_one();
+    }
+}
+
+void VideoFrameQueue::close()
+{
+    m_closed.store(true, std::memory_order_release);
+    m_push_count.fetch_add(1, std::memory_order_release);
+    m_push_count.notify_all();
+    m_pop_count.fetch_add(1, std::memory_order_release);
+    m_pop_count.notify_all();
+    notify_timed_waiter();
+}
+
+FrameQueueStatistics VideoFrameQueue::get_statistics() const
+{
+    return { m_frames_pushed.load(std::memory_order_relaxed), m_frames_dropped.load(std::memory_order_relaxed),
+        m_frames_popped.load(std::memory_order_relaxed) };
+}
+
+bool KeyframeGate::note_popped(const QueuedVideoFrame& queued_frame)
+{
+    if (!queued_frame.frames_dropped_before)
+        return false;
+    return !m_waiting.exchange(true, std::memory_order_relaxed);
+}
+
+KeyframeGate::Decision KeyframeGate::admit(bool has_idr_slice, bool has_slice, bool can_resume)
+{
+    if (!is_waiting())
+        return Decision::Pass;
+    if (has_idr_slice && can_resume) {
+        m_waiting.store(false, std::memory_order_relaxed);
+        return Decision::Resume;
+    }
+    return has_slice ? Decision::Skip : Decision::Pass;
+}
+
+}
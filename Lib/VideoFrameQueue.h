@@ -0,0 +1,130 @@
+#pragma once
+
+#include "DroneStatistics.h"
+#include "FramePool.h"
+#include "Utils/Types.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace Tello {
+
+enum class FrameQueuePolicy {
+    // The producer waits for the consumer when the queue is full, for consumers that must see every frame.
+    // This stalls the video receive thread, so it is not meant for consumers that can fall behind.
+    Block,
+    // The oldest queued frame makes room for the new one
+    DropOldest,
+    // Only the newest frame is kept, for vision consumers that want the freshest frame and nothing else
+    LatestOnly,
+};
+
+struct QueuedVideoFrame {
+    VideoFrame frame;
+    // Time between the frame being pushed and popped
+    std::chrono::nanoseconds queue_residency;
+    // Whether frames pushed after the previously popped one were dropped. Set by position in the queue rather
+    // than from the drop counter, which a producer only bumps after the frame is already gone.
+    bool frames_dropped_before { false };
+};
+
+// A bounded lock-free queue between the video receive thread (the single producer) and one consumer. With
+// the dropping policies the producer never waits: it takes the oldest frame off the queue itself, racing the
+// consumer for it.
+class VideoFrameQueue {
+public:
+    // The capacity is rounded up to a power of two (at least 2), FrameQueuePolicy::LatestOnly ignores it
+    VideoFrameQueue(usize capacity, FrameQueuePolicy policy);
+    ~VideoFrameQueue();
+
+    VideoFrameQueue(const VideoFrameQueue&) = delete;
+    VideoFrameQueue& operator=(const VideoFrameQueue&) = delete;
+
+    // Producer side, returns false if the queue was closed
+    bool push(VideoFrame frame);
+
+    // Consumer side. `pop` waits for a frame and only returns nothing once the queue is closed and drained.
+    std::optional<QueuedVideoFrame> try_pop();
+    std::optional<QueuedVideoFrame> pop();
+    // Like `pop`, but also returns nothing once the deadline passed, check is_closed() to tell the two apart
+    std::optional<QueuedVideoFrame> pop_until(std::chrono::steady_clock::time_point deadline);
+
+    // Wakes up a waiting producer or consumer, later pushes fail
+    void close();
+    [[nodiscard]] bool is_closed() const { return m_closed.load(std::memory_order_acquire); }
+
+    [[nodiscard]] usize capacity() const { return m_policy == FrameQueuePolicy::LatestOnly ? 1 : m_capacity; }
+    [[nodiscard]] FrameQueuePolicy policy() const { return m_policy; }
+    [[nodiscard]] FrameQueueStatistics get_statistics() const;
+
+private:
+    struct Slot {
+        std::atomic<usize> sequence { 0 };
+        VideoFrame frame;
+        std::chrono::steady_clock::time_point push_time {};
+    };
+
+    bool try_push(VideoFrame& frame);
+    void notify_timed_waiter();
+    // Returns the position the frame was pushed at
+    std::optional<usize> try_take(VideoFrame& frame, std::chrono::steady_clock::time_point& push_time);
+
+    static constexpr usize CACHE_LINE_SIZE = 64;
+
+    const FrameQueuePolicy m_policy;
+    const usize m_capacity;
+    std::unique_ptr<Slot[]> m_slots;
+
+    // Only touched by the producer
+    alignas(CACHE_LINE_SIZE) usize m_push_position { 0 };
+    // Claimed by the consumer, and by the producer when it drops the oldest frame
+    alignas(CACHE_LINE_SIZE) std::atomic<usize> m_pop_position { 0 };
+    // Only touched by the consumer, the position right after the frame it popped last
+    usize m_next_expected_position { 0 };
+
+    // Bumped on every push and pop respectively, for the blocking sides to wait on
+    alignas(CACHE_LINE_SIZE) std::atomic<u32> m_push_count { 0 };
+    alignas(CACHE_LINE_SIZE) std::atomic<u32> m_pop_count { 0 };
+    std::atomic<bool> m_closed { false };
+    // Atomic waits cannot time out, so pop_until waits on a condition variable that pushes only notify while
+    // it is in use
+    std::atomic<bool> m_timed_waiter { false };
+    std::mutex m_timed_wait_mutex;
+    std::condition_variable m_timed_wait_cv;
+
+    std::atomic<u64> m_frames_pushed { 0 };
+    std::atomic<u64> m_frames_dropped { 0 };
+    std::atomic<u64> m_frames_popped { 0 };
+};
+
+// For consumers of a dropping queue that decode the frames, or write them out to be decoded later: after a
+// drop the pictures up to the next IDR frame reference pictures that are gone, so they are held back.
+// Decoding starts out waiting for an IDR frame too, as the stream may be anywhere in between two of them.
+class KeyframeGate {
+public:
+    enum class Decision {
+        Pass,
+        // A picture while waiting for an IDR frame
+        Skip,
+        // The IDR frame that ends the wait, the consumer restarts decoding from it
+        Resume,
+    };
+
+    // Returns true if frames were dropped in front of this one while the gate was open, which is worth a
+    // keyframe request
+    bool note_popped(const QueuedVideoFrame& queued_frame);
+    // Access units without a picture, e.g. bare parameter sets, always pass. An IDR frame only ends the wait if
+    // `can_resume` is set, e.g. once the parameter sets it needs are known.
+    Decision admit(bool has_idr_slice, bool has_slice, bool can_resume = true);
+
+    // May be read from any thread
+    [[nodiscard]] bool is_waiting() const { return m_waiting.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> m_waiting { true };
+};
+
+}
@@ -0,0 +1,208 @@
+#include "VideoReassembler.h"
+#include <algorithm>
+#include <iostream>
+
+namespace Tello {
+
+#define VIDEO_REASSEMBLY_DEBUG_LOGGING 0
+
+VideoReassembler::VideoReassembler(std::shared_ptr<FramePool> frame_pool, usize window_size, FrameHandler frame_handler)
+    : m_frame_pool(std::move(frame_pool))
+    , m_frame_handler(std::move(frame_handler))
+    , m_slots(std::clamp<usize>(window_size, 1, MAX_WINDOW_SIZE))
+{
+}
+
+void VideoReassembler::add_segment(std::span<const u8> datagram, std::chrono::steady_clock::time_point receive_time)
+{
+    if (datagram.size() < 2) {
+        if constexpr (VIDEO_REASSEMBLY_DEBUG_LOGGING)
+            std::cerr << "Received invalid video packet, less than 2 bytes of data!" << std::endl;
+        return;
+    }
+
+    u8 frame_num = datagram[0];
+    u8 segment_num = datagram[1] & 127;
+    bool last_segment_in_frame = (datagram[1] & 128) == 128;
+    auto payload = datagram.subspan(2);
+    increment_counter(m_counters.segments_received);
+
+    if (!m_synchronized) {
+        m_synchronized = true;
+        m_window_start = frame_num;
+        m_newest_frame_num = frame_num;
+    }
+
+    // Frame numbers wrap at 256, so anything more than half the range ahead is taken to be behind the window
+    u8 window_offset = frame_num - m_window_start;
+    if (window_offset >= 128) {
+        increment_counter(m_counters.segments_late);
+        if (++m_consecutive_late_segments <= MAX_SEGMENTS_PER_FRAME)
+            return;
+        // More than a whole frame of segments that all look old, so the stream has most likely restarted
+        if constexpr (VIDEO_REASSEMBLY_DEBUG_LOGGING)
+            std::cout << "Video stream restarted at frame " << static_cast<int>(frame_num) << std::endl;
+        reset();
+        m_synchronized = true;
+        m_window_start = m_newest_frame_num = frame_num;
+        window_offset = 0;
+    }
+    m_consecutive_late_segments = 0;
+
+    if (window_offset >= m_slots.size()) {
+        advance_window_to(frame_num - m_slots.size() + 1);
+        window_offset = m_slots.size() - 1;
+    }
+
+    u8 newest_offset = m_newest_frame_num - m_window_start;
+    bool reordered = newest_offset < 128 && window_offset < newest_offset;
+    if (newest_offset >= 128 || window_offset > newest_offset)
+        m_newest_frame_num = frame_num;
+
+    auto& slot = slot_for(frame_num);
+    if (slot.active && slot.frame_num != frame_num) {
+        // Cannot happen while slots follow the window, but never write one frame's segments into another's buffer
+        if constexpr (VIDEO_REASSEMBLY_DEBUG_LOGGING)
+            std::cerr << "Slot of frame " << static_cast<int>(frame_num) << " still holds frame "
+                      << static_cast<int>(slot.frame_num) << std::endl;
+        increment_counter(m_counters.frames_lost);
+        slot.active = false;
+    }
+    if (!slot.active)
+        open_slot(slot, frame_num);
+
+    if (slot.received_segments[segment_num]) {
+        increment_counter(m_counters.segments_duplicate);
+        return;
+    }
+    reordered |= slot.segments_received > 0 && segment_num < slot.highest_segment_num;
+    if (reordered) {
+        if constexpr (VIDEO_REASSEMBLY_DEBUG_LOGGING)
+            std::cout << "Segment " << static_cast<int>(segment_num) << " of frame " << static_cast<int>(frame_num)
+                      << " arrived out of order" << std::endl;
+        increment_counter(m_counters.segments_reordered);
+    }
+    slot.highest_segment_num = std::max(slot.highest_segment_num, segment_num);
+    slot.received_segments.set(segment_num);
+    slot.segments_received++;
+
+    if (last_segment_in_frame) {
+        if (slot.last_segment_num >= 0 && slot.last_segment_num != segment_num)
+            discard(slot);
+        slot.last_segment_num = segment_num;
+    }
+    if (slot.last_segment_num >= 0 && slot.highest_segment_num > slot.last_segment_num)
+        discard(slot);
+
+    // Every segment but the last one carries a full payload, so each segment has a fixed place in the frame
+    if (!last_segment_in_frame && payload.size() != m_segment_payload_size) {
+        // Segments already written into any open frame are laid out at the old size
+        if (m_segment_payload_size != 0) {
+            for (auto& open_slot : m_slots) {
+                if (open_slot.active)
+                    discard(open_slot);
+            }
+        }
+        m_segment_payload_size = payload.size();
+    }
+    if (last_segment_in_frame && segment_num > 0 && (m_segment_payload_size == 0 || payload.size() > m_segment_payload_size))
+        discard(slot);
+
+    if (!slot.discarded) [[likely]] {
+        auto frame_offset = segment_num * m_segment_payload_size;
+        if (!m_frame_pool->write(slot.frame, frame_offset, payload)) {
+            if constexpr (VIDEO_REASSEMBLY_DEBUG_LOGGING)
+                std::cerr << "Frame " << static_cast<int>(frame_num) << " exceeds the maximum frame size" << std::endl;
+            m_frame_pool->record_oversize();
+            discard(slot);
+        } else if (last_segment_in_frame) {
+            slot.size = frame_offset + payload.size();
+        }
+    }
+
+    if (slot.segments_received == 1)
+        slot.timestamps.first_segment = receive_time;
+    if (is_complete(slot)) {
+        slot.timestamps.last_segment = receive_time;
+        slot.timestamps.reassembled = std::chrono::steady_clock::now();
+    }
+    deliver_completed_frames();
+}
+
+void VideoReassembler::reset()
+{
+    for (auto& slot : m_slots) {
+        if (slot.active)
+            increment_counter(m_counters.frames_lost);
+        slot.active = false;
+    }
+    m_synchronized = false;
+    m_window_head = 0;
+    m_consecutive_late_segments = 0;
+}
+
+void VideoReassembler::open_slot(Slot& slot, u8 frame_num)
+{
+    slot.active = true;
+    slot.discarded = false;
+    slot.frame_num = frame_num;
+    slot.last_segment_num = -1;
+    slot.highest_segment_num = 0;
+    slot.segments_received = 0;
+    slot.size = 0;
+    slot.received_segments.reset();
+
+    // A buffer left over from a lost or dropped frame is simply reused
+    if (!slot.frame)
+        slot.frame = m_frame_pool->acquire();
+    if (!slot.frame) {
+        if constexpr (VIDEO_REASSEMBLY_DEBUG_LOGGING)
+            std::cerr << "No free frame buffer, dropping frame " << static_cast<int>(frame_num) << std::endl;
+        m_frame_pool->record_pool_exhausted();
+        slot.discarded = true;
+    }
+}
+
+void VideoReassembler::discard(Slot& slot)
+{
+    if constexpr (VIDEO_REASSEMBLY_DEBUG_LOGGING) {
+        if (!slot.discarded)
+            std::cout << "Discarding frame " << static_cast<int>(slot.frame_num) << std::endl;
+    }
+    slot.discarded = true;
+}
+
+void VideoReassembler::advance_window_to(u8 frame_num)
+{
+    while (m_window_start != frame_num) {
+        auto& slot = slot_for(m_window_start);
+        if (slot.active && is_complete(slot)) {
+            if (slot.discarded) {
+                increment_counter(m_counters.frames_dropped);
+            } else {
+                m_frame_pool->finish(slot.frame, slot.frame_num, slot.size, slot.timestamps);
+                increment_counter(m_counters.frames_completed);
+                m_frame_handler(std::move(slot.frame));
+            }
+        } else {
+            if constexpr (VIDEO_REASSEMBLY_DEBUG_LOGGING)
+                std::cout << "Lost frame " << static_cast<int>(m_window_start) << std::endl;
+            increment_counter(m_counters.frames_lost);
+        }
+        slot.active = false;
+        ++m_window_start;
+        m_window_head = (m_window_head + 1) % m_slots.size();
+    }
+}
+
+void VideoReassembler::deliver_completed_frames()
+{
+    while (true) {
+        auto& slot = slot_for(m_window_start);
+        if (!slot.active || slot.frame_num != m_window_start || !is_complete(slot))
+            return;
+        advance_window_to(m_window_start + 1);
+    }
+}
+
+}
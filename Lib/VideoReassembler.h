@@ -0,0 +1,80 @@
+#pragma once
+
+#include "DroneStatistics.h"
+#include "FramePool.h"
+#include "Utils/Types.h"
+#include <bitset>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace Tello {
+
+// Reassembles video datagrams ([frame_num, segment_num | 0x80 on the last segment, payload...]) into frames.
+// Segments may arrive in any order within a window of in-flight frame numbers. Frames are delivered in frame
+// number order, and a frame only counts as lost once the window has moved past it.
+class VideoReassembler {
+public:
+    using FrameHandler = std::function<void(VideoFrame)>;
+
+    static constexpr usize MAX_WINDOW_SIZE = 64;
+    static constexpr usize MAX_SEGMENTS_PER_FRAME = 128;
+
+    VideoReassembler(std::shared_ptr<FramePool> frame_pool, usize window_size, FrameHandler frame_handler);
+
+    // `receive_time` is when the datagram was received, ideally the kernel's receive timestamp
+    void add_segment(std::span<const u8> datagram, std::chrono::steady_clock::time_point receive_time);
+    // Forgets every in-flight frame, e.g. when the stream restarts
+    void reset();
+
+    [[nodiscard]] usize window_size() const { return m_slots.size(); }
+    [[nodiscard]] VideoReassemblyStatistics get_statistics() const { return m_counters.snapshot(); }
+
+private:
+    struct Slot {
+        bool active { false };
+        // Set when the frame can no longer be delivered, its segments are still tracked to retire it early
+        bool discarded { false };
+        u8 frame_num { 0 };
+        i16 last_segment_num { -1 };
+        u8 highest_segment_num { 0 };
+        usize segments_received { 0 };
+        usize size { 0 };
+        VideoFrameTimestamps timestamps;
+        std::bitset<MAX_SEGMENTS_PER_FRAME> received_segments;
+        VideoFrame frame;
+    };
+
+    static bool is_complete(const Slot& slot)
+    {
+        return slot.last_segment_num >= 0 && slot.segments_received == static_cast<usize>(slot.last_segment_num) + 1;
+    }
+
+    // Slots form a ring starting at the window start. Indexing by frame number modulo the window size would let
+    // frames on both sides of the 255 -> 0 wrap share a slot whenever the size does not divide 256.
+    Slot& slot_for(u8 frame_num) { return m_slots[(m_window_head + static_cast<u8>(frame_num - m_window_start)) % m_slots.size()]; }
+    void open_slot(Slot& slot, u8 frame_num);
+    void discard(Slot& slot);
+    // Moves the window start past `frame_num`, delivering or losing every frame before it
+    void advance_window_to(u8 frame_num);
+    void deliver_completed_frames();
+
+    std::shared_ptr<FramePool> m_frame_pool;
+    FrameHandler m_frame_handler;
+    std::vector<Slot> m_slots;
+
+    bool m_synchronized { false };
+    // Oldest frame number that is neither delivered nor lost yet
+    u8 m_window_start { 0 };
+    // Index of the slot holding m_window_start
+    usize m_window_head { 0 };
+    u8 m_newest_frame_num { 0 };
+    usize m_segment_payload_size { 0 };
+    usize m_consecutive_late_segments { 0 };
+
+    VideoReassemblyCounters m_counters;
+};
+
+}
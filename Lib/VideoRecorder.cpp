@@ -0,0 +1,495 @@
+#include "VideoRecorder.h"
+#include "H264Parser.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+namespace Tello {
+
+static constexpr u8 START_CODE[] = { 0, 0, 0, 1 };
+
+namespace {
+
+// Appends big-endian fields and ISO BMFF boxes to a byte vector, box sizes are filled in once a box is done
+class Mp4Writer {
+public:
+    explicit Mp4Writer(std::vector<u8>& output)
+        : m_output(output)
+    {
+    }
+
+    void write_u8(u8 value) { m_output.push_back(value); }
+    void write_u16(u16 value)
+    {
+        write_u8(value >> 8);
+        write_u8(value);
+    }
+    void write_u32(u32 value)
+    {
+        write_u16(value >> 16);
+        write_u16(value);
+    }
+    void write_u64(u64 value)
+    {
+        write_u32(value >> 32);
+        write_u32(value);
+    }
+    void write_zeros(usize count) { m_output.insert(m_output.end(), count, 0); }
+    void write_bytes(std::span<const u8> bytes) { m_output.insert(m_output.end(), bytes.begin(), bytes.end()); }
+    void write_fourcc(char const* code) { write_bytes({ reinterpret_cast<const u8*>(code), 4 }); }
+
+    usize begin_box(char const* type)
+    {
+        auto offset = m_output.size();
+        write_u32(0);
+        write_fourcc(type);
+        return offset;
+    }
+    usize begin_full_box(char const* type, u8 version, u32 flags)
+    {
+        auto offset = begin_box(type);
+        write_u32(static_cast<u32>(version) << 24 | flags);
+        return offset;
+    }
+    void end_box(usize offset)
+    {
+        u32 size = m_output.size() - offset;
+        m_output[offset] = size >> 24;
+        m_output[offset + 1] = size >> 16;
+        m_output[offset + 2] = size >> 8;
+        m_output[offset + 3] = size;
+    }
+
+    // The unity matrix of mvhd and tkhd
+    void write_matrix()
+    {
+        for (u32 value : { 0x00010000u, 0u, 0u, 0u, 0x00010000u, 0u, 0u, 0u, 0x40000000u })
+            write_u32(value);
+    }
+
+private:
+    std::vector<u8>& m_output;
+};
+
+}
+
+std::unique_ptr<VideoRecorder> VideoRecorder::open(VideoRecorderConfig config)
+{
+    int file_fd = ::open(config.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file_fd < 0) {
+        perror(("open(" + config.path + ")").c_str());
+        return nullptr;
+    }
+    std::unique_ptr<VideoRecorder> recorder(new VideoRecorder(std::move(config), file_fd));
+    if (!recorder->m_staging_buffer) {
+        std::cerr << "Failed to allocate the " << recorder->m_staging_capacity << " byte recording buffer" << std::endl;
+        return nullptr;
+    }
+    recorder->m_writer_thread = std::thread(&VideoRecorder::writer_thread_routine, recorder.get());
+    return recorder;
+}
+
+VideoRecorder::VideoRecorder(VideoRecorderConfig config, int file_fd)
+    : m_config(std::move(config))
+    , m_file_fd(file_fd)
+    , m_queue(m_config.queue_capacity, FrameQueuePolicy::DropOldest)
+{
+    m_staging_capacity = std::max((m_config.write_batch_size + WRITE_ALIGNMENT - 1) / WRITE_ALIGNMENT, usize(1)) * WRITE_ALIGNMENT;
+    m_staging_buffer.reset(static_cast<u8*>(std::aligned_alloc(WRITE_ALIGNMENT, m_staging_capacity)));
+}
+
+VideoRecorder::~VideoRecorder()
+{
+    close();
+}
+
+void VideoRecorder::set_parameter_sets(std::span<const u8> sequence_parameter_set, std::span<const u8> picture_parameter_set)
+{
+    m_sequence_parameter_set.assign(sequence_parameter_set.begin(), sequence_parameter_set.end());
+    m_picture_parameter_set.assign(picture_parameter_set.begin(), picture_parameter_set.end());
+}
+
+void VideoRecorder::record(const VideoFrame& frame)
+{
+    m_queue.push(frame);
+}
+
+void VideoRecorder::close()
+{
+    m_queue.close();
+    if (m_writer_thread.joinable())
+        m_writer_thread.join();
+    if (m_file_fd >= 0) {
+        ::close(m_file_fd);
+        m_file_fd = -1;
+    }
+}
+
+void VideoRecorder::writer_thread_routine()
+{
+    m_last_flush_time = std::chrono::steady_clock::now();
+
+    while (true) {
+        auto queued_frame = m_queue.pop_until(m_last_flush_time + m_config.flush_interval);
+        if (!queued_frame) {
+            if (m_queue.is_closed())
+                break;
+            // The video stalled, what is staged goes to disk instead of waiting for the next frame
+            flush(true);
+            continue;
+        }
+        auto& frame = queued_frame->frame;
+
+        m_keyframe_gate.note_popped(*queued_frame);
+
+        // Written before the new frame is scanned, as that may replace the parameter sets
+        if (m_pending_frame)
+            write_pending_frame(frame.timestamps().first_segment);
+
+        auto contents = scan_access_unit(frame.data());
+        bool has_parameter_sets = !m_sequence_parameter_set.empty() && !m_picture_parameter_set.empty();
+        auto decision = m_keyframe_gate.admit(contents.has_idr_slice, contents.has_slice, has_parameter_sets);
+        if (decision == KeyframeGate::Decision::Skip) {
+            increment_counter(m_counters.frames_skipped);
+            continue;
+        }
+        bool needs_parameter_sets = decision == KeyframeGate::Decision::Resume;
+
+        // Every MP4 sample is a picture, the parameter sets go along with each IDR frame instead
+        if (m_config.format == VideoRecordingFormat::FragmentedMP4 && !contents.has_slice)
+            continue;
+
+        m_pending_frame = std::move(frame);
+        m_pending_frame_contents = contents;
+        m_pending_frame_needs_parameter_sets = needs_parameter_sets;
+
+        if (std::chrono::steady_clock::now() - m_last_flush_time >= m_config.flush_interval)
+            flush(false);
+    }
+
+    if (m_pending_frame)
+        write_pending_frame({});
+    flush(true);
+}
+
+VideoRecorder::AccessUnitContents VideoRecorder::scan_access_unit(std::span<const u8> access_unit)
+{
+    AccessUnitContents contents;
+    H264NALUnitReader reader(access_unit);
+    H264NALUnit nal_unit;
+    while (reader.next(nal_unit)) {
+        switch (nal_unit.type) {
+        case H264NALUnitType::SequenceParameterSet:
+            contents.has_parameter_sets = true;
+            m_sequence_parameter_set.assign(nal_unit.bytes.begin(), nal_unit.bytes.end());
+            break;
+        case H264NALUnitType::PictureParameterSet:
+            contents.has_parameter_sets = true;
+            m_picture_parameter_set.assign(nal_unit.bytes.begin(), nal_unit.bytes.end());
+            break;
+        case H264NALUnitType::IDRSlice:
+            contents.has_idr_slice = true;
+            contents.has_slice = true;
+            break;
+        case H264NALUnitType::NonIDRSlice:
+        case H264NALUnitType::SliceDataPartitionA:
+            contents.has_slice = true;
+            break;
+        default:
+            break;
+        }
+    }
+    return contents;
+}
+
+void VideoRecorder::write_pending_frame(std::optional<std::chrono::steady_clock::time_point> next_frame_time)
+{
+    auto frame = std::move(m_pending_frame);
+    auto frame_time = frame.timestamps().first_segment;
+
+    if (m_config.format == VideoRecordingFormat::AnnexB) {
+        if (m_pending_frame_needs_parameter_sets && !m_pending_frame_contents.has_parameter_sets) {
+            append(START_CODE);
+            append(m_sequence_parameter_set);
+            append(START_CODE);
+            append(m_picture_parameter_set);
+        }
+        append(frame.data());
+    } else {
+        if (!m_header_written) {
+            write_mp4_header();
+            m_header_written = true;
+            m_recording_start_time = frame_time;
+        }
+
+        auto to_timescale = [](std::chrono::steady_clock::duration duration) {
+            return static_cast<u64>(std::max<i64>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count(), 0))
+                * MP4_TIMESCALE / 1'000'000;
+        };
+        // Placed by arrival time, so the gaps left by dropped frames keep their length
+        auto decode_time = std::max(to_timescale(frame_time - m_recording_start_time), m_decode_time);
+        if (next_frame_time)
+            m_last_frame_duration = std::max<u64>(to_timescale(*next_frame_time - frame_time), 1);
+        write_mp4_fragment(frame.data(), m_pending_frame_contents.has_idr_slice, decode_time, m_last_frame_duration);
+        m_decode_time = decode_time + m_last_frame_duration;
+    }
+    increment_counter(m_counters.frames_written);
+}
+
+void VideoRecorder::write_mp4_header()
+{
+    auto stream_info = parse_h264_sequence_parameter_set(m_sequence_parameter_set).value_or(H264SequenceParameterSet {});
+
+    m_fragment.clear();
+    Mp4Writer writer(m_fragment);
+
+    auto ftyp = writer.begin_box("ftyp");
+    writer.write_fourcc("isom");
+    writer.write_u32(0x200);
+    for (auto* brand : { "isom", "iso5", "iso6", "avc1", "mp41" })
+        writer.write_fourcc(brand);
+    writer.end_box(ftyp);
+
+    auto moov = writer.begin_box("moov");
+    auto mvhd = writer.begin_full_box("mvhd", 0, 0);
+    writer.write_u32(0); // creation_time
+    writer.write_u32(0); // modification_time
+    writer.write_u32(1000);
+    writer.write_u32(0); // duration, unknown up front
+    writer.write_u32(0x00010000); // rate
+    writer.write_u16(0x0100); // volume
+    writer.write_zeros(10);
+    writer.write_matrix();
+    writer.write_zeros(24);
+    writer.write_u32(2); // next_track_ID
+    writer.end_box(mvhd);
+
+    auto trak = writer.begin_box("trak");
+    auto tkhd = writer.begin_full_box("tkhd", 0, 0x3); // enabled, in movie
+    writer.write_u32(0); // creation_time
+    writer.write_u32(0); // modification_time
+    writer.write_u32(1); // track_ID
+    writer.write_u32(0);
+    writer.write_u32(0); // duration
+    writer.write_zeros(8);
+    writer.write_u16(0); // layer
+    writer.write_u16(0); // alternate_group
+    writer.write_u16(0); // volume
+    writer.write_u16(0);
+    writer.write_matrix();
+    writer.write_u32(stream_info.width << 16);
+    writer.write_u32(stream_info.height << 16);
+    writer.end_box(tkhd);
+
+    auto mdia = writer.begin_box("mdia");
+    auto mdhd = writer.begin_full_box("mdhd", 0, 0);
+    writer.write_u32(0); // creation_time
+    writer.write_u32(0); // modification_time
+    writer.write_u32(MP4_TIMESCALE);
+    writer.write_u32(0); // duration
+    writer.write_u16(0x55C4); // language, "und"
+    writer.write_u16(0);
+    writer.end_box(mdhd);
+
+    auto hdlr = writer.begin_full_box("hdlr", 0, 0);
+    writer.write_u32(0);
+    writer.write_fourcc("vide");
+    writer.write_zeros(12);
+    writer.write_bytes({ reinterpret_cast<const u8*>("VideoHandler"), 13 });
+    writer.end_box(hdlr);
+
+    auto minf = writer.begin_box("minf");
+    auto vmhd = writer.begin_full_box("vmhd", 0, 0x1);
+    writer.write_zeros(8); // graphicsmode, opcolor
+    writer.end_box(vmhd);
+
+    auto dinf = writer.begin_box("dinf");
+    auto dref = writer.begin_full_box("dref", 0, 0);
+    writer.write_u32(1);
+    writer.end_box(writer.begin_full_box("url ", 0, 0x1)); // media data is in this file
+    writer.end_box(dref);
+    writer.end_box(dinf);
+
+    auto stbl = writer.begin_box("stbl");
+    auto stsd = writer.begin_full_box("stsd", 0, 0);
+    writer.write_u32(1);
+    auto avc1 = writer.begin_box("avc1");
+    writer.write_zeros(6);
+    writer.write_u16(1); // data_reference_index
+    writer.write_zeros(16);
+    writer.write_u16(stream_info.width);
+    writer.write_u16(stream_info.height);
+    writer.write_u32(0x00480000); // 72dpi
+    writer.write_u32(0x00480000);
+    writer.write_u32(0);
+    writer.write_u16(1); // frame_count
+    writer.write_zeros(32); // compressorname
+    writer.write_u16(0x0018); // depth
+    writer.write_u16(0xFFFF);
+
+    auto avcc = writer.begin_box("avcC");
+    writer.write_u8(1); // configurationVersion
+    // profile, constraints and level, straight from the SPS unless it is too short to hold them
+    if (m_sequence_parameter_set.size() >= 4) {
+        writer.write_bytes(std::span<const u8>(m_sequence_parameter_set).subspan(1, 3));
+    } else {
+        writer.write_u8(stream_info.profile_idc);
+        writer.write_u8(stream_info.constraint_flags);
+        writer.write_u8(stream_info.level_idc);
+    }
+    writer.write_u8(0xFC | 3); // 4 byte NAL unit lengths
+    writer.write_u8(0xE0 | 1);
+    writer.write_u16(m_sequence_parameter_set.size());
+    writer.write_bytes(m_sequence_parameter_set);
+    writer.write_u8(1);
+    writer.write_u16(m_picture_parameter_set.size());
+    writer.write_bytes(m_picture_parameter_set);
+    if (stream_info.profile_idc == 100 || stream_info.profile_idc == 110 || stream_info.profile_idc == 122
+        || stream_info.profile_idc == 144) {
+        writer.write_u8(0xFC | stream_info.chroma_format_idc);
+        // 8 bit luma and chroma, the only depth the drone produces
+        writer.write_u8(0xF8);
+        writer.write_u8(0xF8);
+        writer.write_u8(0);
+    }
+    writer.end_box(avcc);
+    writer.end_box(avc1);
+    writer.end_box(stsd);
+
+    // The sample tables stay empty, every sample is described by its fragment
+    for (auto* table : { "stts", "stsc", "stco" }) {
+        auto box = writer.begin_full_box(table, 0, 0);
+        writer.write_u32(0);
+        writer.end_box(box);
+    }
+    auto stsz = writer.begin_full_box("stsz", 0, 0);
+    writer.write_u32(0);
+    writer.write_u32(0);
+    writer.end_box(stsz);
+    writer.end_box(stbl);
+    writer.end_box(minf);
+    writer.end_box(mdia);
+    writer.end_box(trak);
+
+    auto mvex = writer.begin_box("mvex");
+    auto trex = writer.begin_full_box("trex", 0, 0);
+    writer.write_u32(1); // track_ID
+    writer.write_u32(1); // default_sample_description_index
+    writer.write_u32(0);
+    writer.write_u32(0);
+    writer.write_u32(0);
+    writer.end_box(trex);
+    writer.end_box(mvex);
+    writer.end_box(moov);
+
+    append(m_fragment);
+}
+
+void VideoRecorder::write_mp4_fragment(std::span<const u8> access_unit, bool is_idr, u64 decode_time, u32 duration)
+{
+    static constexpr u32 TRUN_FLAGS = 0x000001 | 0x000100 | 0x000200 | 0x000400; // data offset, duration, size, flags
+    // sample_depends_on = 2 for IDR frames, otherwise sample_depends_on = 1 and sample_is_non_sync_sample
+    static constexpr u32 SYNC_SAMPLE_FLAGS = 0x02000000;
+    static constexpr u32 NON_SYNC_SAMPLE_FLAGS = 0x01010000;
+
+    m_fragment.clear();
+    Mp4Writer writer(m_fragment);
+
+    auto moof = writer.begin_box("moof");
+    auto mfhd = writer.begin_full_box("mfhd", 0, 0);
+    writer.write_u32(m_fragment_sequence_number++);
+    writer.end_box(mfhd);
+
+    auto traf = writer.begin_box("traf");
+    auto tfhd = writer.begin_full_box("tfhd", 0, 0x020000); // default-base-is-moof
+    writer.write_u32(1);
+    writer.end_box(tfhd);
+    auto tfdt = writer.begin_full_box("tfdt", 1, 0);
+    writer.write_u64(decode_time);
+    writer.end_box(tfdt);
+
+    auto trun = writer.begin_full_box("trun", 0, TRUN_FLAGS);
+    writer.write_u32(1); // sample_count
+    auto data_offset_position = m_fragment.size();
+    writer.write_u32(0);
+    writer.write_u32(duration);
+    auto sample_size_position = m_fragment.size();
+    writer.write_u32(0);
+    writer.write_u32(is_idr ? SYNC_SAMPLE_FLAGS : NON_SYNC_SAMPLE_FLAGS);
+    writer.end_box(trun);
+    writer.end_box(traf);
+    writer.end_box(moof);
+
+    auto mdat = writer.begin_box("mdat");
+    auto sample_start = m_fragment.size();
+    auto write_nal_unit = [&](std::span<const u8> nal_unit) {
+        writer.write_u32(nal_unit.size());
+        writer.write_bytes(nal_unit);
+    };
+    if (is_idr) {
+        write_nal_unit(m_sequence_parameter_set);
+        write_nal_unit(m_picture_parameter_set);
+    }
+    H264NALUnitReader reader(access_unit);
+    H264NALUnit nal_unit;
+    while (reader.next(nal_unit)) {
+        if (nal_unit.type != H264NALUnitType::AccessUnitDelimiter && nal_unit.type != H264NALUnitType::SequenceParameterSet
+            && nal_unit.type != H264NALUnitType::PictureParameterSet)
+            write_nal_unit(nal_unit.bytes);
+    }
+    u32 sample_size = m_fragment.size() - sample_start;
+    writer.end_box(mdat);
+
+    u32 data_offset = sample_start - moof;
+    for (usize i = 0; i < 4; ++i) {
+        m_fragment[data_offset_position + i] = data_offset >> (24 - 8 * i);
+        m_fragment[sample_size_position + i] = sample_size >> (24 - 8 * i);
+    }
+
+    append(m_fragment);
+}
+
+void VideoRecorder::append(std::span<const u8> bytes)
+{
+    while (!bytes.empty()) {
+        auto count = std::min(bytes.size(), m_staging_capacity - m_staged_size);
+        memcpy(m_staging_buffer.get() + m_staged_size, bytes.data(), count);
+        m_staged_size += count;
+        bytes = bytes.subspan(count);
+        if (m_staged_size == m_staging_capacity)
+            flush(false);
+    }
+}
+
+void VideoRecorder::flush(bool everything)
+{
+    auto size = everything ? m_staged_size : m_staged_size / WRITE_ALIGNMENT * WRITE_ALIGNMENT;
+    usize written = 0;
+    while (written < size && !m_write_failed) {
+        auto start = std::chrono::steady_clock::now();
+        auto result = ::write(m_file_fd, m_staging_buffer.get() + written, size - written);
+        m_counters.write_latency.record(std::chrono::steady_clock::now() - start);
+        if (result < 0) {
+            if (errno == EINTR)
+                continue;
+            // Everything from here on is dropped, the receive side keeps going regardless
+            perror(("write(" + m_config.path + ")").c_str());
+            increment_counter(m_counters.write_errors);
+            m_write_failed = true;
+            break;
+        }
+        written += result;
+        increment_counter(m_counters.writes);
+        increment_counter(m_counters.bytes_written, result);
+    }
+
+    memmove(m_staging_buffer.get(), m_staging_buffer.get() + size, m_staged_size - size);
+    m_staged_size -= size;
+    m_last_flush_time = std::chrono::steady_clock::now();
+}
+
+}
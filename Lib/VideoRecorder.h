@@ -0,0 +1,129 @@
+#pragma once
+
+#include "DroneStatistics.h"
+#include "FramePool.h"
+#include "VideoFrameQueue.h"
+#include "Utils/Types.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Tello {
+
+enum class VideoRecordingFormat {
+    // The access units as received, playable with e.g. `ffplay -f h264`
+    AnnexB,
+    // One moof/mdat fragment per access unit, so a recording cut short is still playable up to its last frame
+    FragmentedMP4,
+};
+
+struct VideoRecorderConfig {
+    std::string path;
+    VideoRecordingFormat format { VideoRecordingFormat::AnnexB };
+    // Frames waiting for the writer thread. They hold on to frame pool buffers, so this should stay well
+    // below DroneConfig::video_frame_pool_size.
+    usize queue_capacity { 8 };
+    // Data is written in multiples of this, it is rounded up to a multiple of 4KiB
+    usize write_batch_size { 256 * 1024 };
+    // A partial batch is written after this long, also while no frames arrive, so a crash loses at most that
+    // much video plus the last frame, which is only written once the next one gives its duration
+    std::chrono::milliseconds flush_interval { 1000 };
+};
+
+// Writes complete access units to a file from a writer thread of its own, without re-encoding. Frames are
+// handed over through a dropping queue, so the video receive thread never waits on the disk. Every file
+// starts at an IDR frame with its parameter sets, and after frames had to be dropped the recording skips
+// ahead to the next IDR frame (see KeyframeGate).
+class VideoRecorder {
+public:
+    // Returns nothing if the file could not be created
+    static std::unique_ptr<VideoRecorder> open(VideoRecorderConfig config);
+    ~VideoRecorder();
+
+    VideoRecorder(const VideoRecorder&) = delete;
+    VideoRecorder& operator=(const VideoRecorder&) = delete;
+
+    // Parameter sets received before the recording started, for when the stream does not repeat them in
+    // front of the next IDR frame. Only valid before the first frame is recorded.
+    void set_parameter_sets(std::span<const u8> sequence_parameter_set, std::span<const u8> picture_parameter_set);
+
+    // Called from the video receive thread, never blocks
+    void record(const VideoFrame& frame);
+
+    // Writes out what is still queued and closes the file
+    void close();
+
+    // Whether the recording is waiting for an IDR frame, which is worth a keyframe request
+    [[nodiscard]] bool is_waiting_for_keyframe() const { return m_keyframe_gate.is_waiting(); }
+    [[nodiscard]] const VideoRecorderConfig& config() const { return m_config; }
+    [[nodiscard]] VideoRecorderStatistics get_statistics() const { return m_counters.snapshot(m_queue.get_statistics().frames_dropped); }
+
+private:
+    static constexpr usize WRITE_ALIGNMENT = 4096;
+    static constexpr u32 MP4_TIMESCALE = 90000;
+    // Used for the last frame of a recording, 30fps
+    static constexpr u32 DEFAULT_FRAME_DURATION = MP4_TIMESCALE / 30;
+
+    VideoRecorder(VideoRecorderConfig config, int file_fd);
+
+    struct AccessUnitContents {
+        bool has_parameter_sets { false };
+        bool has_idr_slice { false };
+        bool has_slice { false };
+    };
+
+    void writer_thread_routine();
+    // Also takes over the parameter sets found in the access unit
+    AccessUnitContents scan_access_unit(std::span<const u8> access_unit);
+    // The pending frame is only written once the next one arrived, which gives its duration
+    void write_pending_frame(std::optional<std::chrono::steady_clock::time_point> next_frame_time);
+
+    void write_mp4_header();
+    void write_mp4_fragment(std::span<const u8> access_unit, bool is_idr, u64 decode_time, u32 duration);
+
+    void append(std::span<const u8> bytes);
+    // Writes the staged data, only whole multiples of WRITE_ALIGNMENT unless `everything` is set
+    void flush(bool everything);
+
+    VideoRecorderConfig m_config;
+    int m_file_fd { -1 };
+    VideoFrameQueue m_queue;
+    std::thread m_writer_thread;
+    KeyframeGate m_keyframe_gate;
+    VideoRecorderCounters m_counters;
+
+    // Set by set_parameter_sets on the video receive thread before the first frame is recorded, the queue
+    // hands them over to the writer thread along with that frame. Afterwards only the writer thread touches
+    // them, as it takes over the parameter sets found in the stream.
+    std::vector<u8> m_sequence_parameter_set;
+    std::vector<u8> m_picture_parameter_set;
+
+    // Everything below is only touched by the writer thread
+    bool m_header_written { false };
+    VideoFrame m_pending_frame;
+    AccessUnitContents m_pending_frame_contents;
+    // The pending frame starts the file or follows dropped frames, so it is written with the parameter sets
+    bool m_pending_frame_needs_parameter_sets { false };
+    bool m_write_failed { false };
+
+    std::unique_ptr<u8, decltype(&std::free)> m_staging_buffer { nullptr, &std::free };
+    usize m_staging_capacity { 0 };
+    usize m_staged_size { 0 };
+    std::chrono::steady_clock::time_point m_last_flush_time;
+
+    // The fragmented MP4 state, times are in units of MP4_TIMESCALE
+    std::vector<u8> m_fragment;
+    u32 m_fragment_sequence_number { 1 };
+    std::chrono::steady_clock::time_point m_recording_start_time;
+    // Where the previous sample ended
+    u64 m_decode_time { 0 };
+    u32 m_last_frame_duration { DEFAULT_FRAME_DURATION };
+};
+
+}
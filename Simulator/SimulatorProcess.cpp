@@ -0,0 +1,46 @@
+#include "SimulatorProcess.h"
+#include <cstdio>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace Tello {
+
+std::unique_ptr<SimulatorProcess> SimulatorProcess::spawn(std::vector<SimulatorConfig> configs)
+{
+    int lifetime_pipe[2];
+    if (pipe(lifetime_pipe) < 0) {
+        perror("pipe()");
+        return nullptr;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork()");
+        ::close(lifetime_pipe[0]);
+        ::close(lifetime_pipe[1]);
+        return nullptr;
+    }
+    if (pid == 0) {
+        ::close(lifetime_pipe[1]);
+        std::vector<std::unique_ptr<Simulator>> simulators;
+        for (auto& config : configs)
+            simulators.push_back(std::make_unique<Simulator>(std::move(config)));
+        // Returns once the parent closed its end, or died
+        char byte;
+        while (read(lifetime_pipe[0], &byte, 1) > 0) { }
+        simulators.clear();
+        _exit(0);
+    }
+    ::close(lifetime_pipe[0]);
+    return std::unique_ptr<SimulatorProcess>(new SimulatorProcess(pid, lifetime_pipe[1]));
+}
+
+void SimulatorProcess::stop()
+{
+    if (m_lifetime_fd == -1)
+        return;
+    ::close(m_lifetime_fd);
+    m_lifetime_fd = -1;
+    waitpid(m_pid, nullptr, 0);
+}
+
+}
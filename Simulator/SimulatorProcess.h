@@ -0,0 +1,39 @@
+#pragma once
+
+#include "TelloSimulator.h"
+#include <memory>
+#include <sys/types.h>
+#include <vector>
+
+namespace Tello {
+
+// Runs simulators in a forked child process, so that their threads neither share the CPU accounting (rusage,
+// context switches) nor the allocator of the drones under test. The child exits once the SimulatorProcess is
+// stopped or destroyed, and also when this process dies, as it waits on the read end of a pipe.
+class SimulatorProcess {
+public:
+    // Has to be called before this process starts any threads of its own. Returns nothing if the child could
+    // not be started.
+    static std::unique_ptr<SimulatorProcess> spawn(std::vector<SimulatorConfig> configs);
+    static std::unique_ptr<SimulatorProcess> spawn(SimulatorConfig config) { return spawn(std::vector { std::move(config) }); }
+    ~SimulatorProcess() { stop(); }
+
+    SimulatorProcess(const SimulatorProcess&) = delete;
+    SimulatorProcess& operator=(const SimulatorProcess&) = delete;
+
+    // Stops the simulators and waits for the child to exit
+    void stop();
+
+private:
+    SimulatorProcess(pid_t pid, int lifetime_fd)
+        : m_pid(pid)
+        , m_lifetime_fd(lifetime_fd)
+    {
+    }
+
+    pid_t m_pid { -1 };
+    // Write end of the pipe the child waits on
+    int m_lifetime_fd { -1 };
+};
+
+}
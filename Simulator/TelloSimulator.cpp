@@ -0,0 +1,587 @@
+#include "TelloSimulator.h"
+#include "Utils/Types.h"
+#include "Utils/CRCHelpers.h"
+#include <arpa/inet.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace Tello {
+
+static constexpr u8 SIMULATOR_PACKET_TYPE = 80;
+static constexpr u16 MVO_RECORD_LENGTH = 92;
+static constexpr u16 IMU_RECORD_LENGTH = 120;
+static constexpr usize MAX_SEGMENTS_PER_FRAME = 128;
+static constexpr std::chrono::milliseconds CMD_RECEIVE_TIMEOUT = std::chrono::milliseconds(100);
+
+namespace {
+
+// Minimal RBSP writer, enough to produce parameter sets that real H264 parsers accept
+class BitWriter {
+public:
+    void write_bits(u32 value, u8 count)
+    {
+        for (i32 bit = count - 1; bit >= 0; --bit) {
+            m_current = (m_current << 1) | ((value >> bit) & 1);
+            if (++m_bit_count == 8)
+                flush_byte();
+        }
+    }
+
+    void write_ue(u32 value)
+    {
+        u32 code = value + 1;
+        u8 length = 0;
+        while ((code >> length) > 1)
+            length++;
+        write_bits(0, length);
+        write_bits(code, length + 1);
+    }
+
+    void write_se(i32 value)
+    {
+        write_ue(value <= 0 ? -2 * value : 2 * value - 1);
+    }
+
+    std::vector<u8> finish()
+    {
+        write_bits(1, 1);
+        while (m_bit_count != 0)
+            write_bits(0, 1);
+        return std::move(m_bytes);
+    }
+
+private:
+    void flush_byte()
+    {
+        if (m_zero_run >= 2 && m_current <= 3) {
+            m_bytes.push_back(0x03); // Emulation prevention byte
+            m_zero_run = 0;
+        }
+        m_bytes.push_back(m_current);
+        m_zero_run = m_current == 0 ? m_zero_run + 1 : 0;
+        m_current = 0;
+        m_bit_count = 0;
+    }
+
+    std::vector<u8> m_bytes;
+    u8 m_current { 0 };
+    u8 m_bit_count { 0 };
+    u8 m_zero_run { 0 };
+};
+
+std::vector<u8> build_sequence_parameter_set()
+{
+    BitWriter writer;
+    writer.write_bits(77, 8); // profile_idc: Main
+    writer.write_bits(0, 8);  // constraint flags
+    writer.write_bits(40, 8); // level_idc: 4.0
+    writer.write_ue(0);       // seq_parameter_set_id
+    writer.write_ue(0);       // log2_max_frame_num_minus4
+    writer.write_ue(2);       // pic_order_cnt_type
+    writer.write_ue(1);       // max_num_ref_frames
+    writer.write_bits(0, 1);  // gaps_in_frame_num_value_allowed_flag
+    writer.write_ue(59);      // pic_width_in_mbs_minus1: 960
+    writer.write_ue(44);      // pic_height_in_map_units_minus1: 720
+    writer.write_bits(1, 1);  // frame_mbs_only_flag
+    writer.write_bits(1, 1);  // direct_8x8_inference_flag
+    writer.write_bits(0, 1);  // frame_cropping_flag
+    writer.write_bits(0, 1);  // vui_parameters_present_flag
+    return writer.finish();
+}
+
+std::vector<u8> build_picture_parameter_set()
+{
+    BitWriter writer;
+    writer.write_ue(0);      // pic_parameter_set_id
+    writer.write_ue(0);      // seq_parameter_set_id
+    writer.write_bits(0, 1); // entropy_coding_mode_flag
+    writer.write_bits(0, 1); // bottom_field_pic_order_in_frame_present_flag
+    writer.write_ue(0);      // num_slice_groups_minus1
+    writer.write_ue(0);      // num_ref_idx_l0_default_active_minus1
+    writer.write_ue(0);      // num_ref_idx_l1_default_active_minus1
+    writer.write_bits(0, 1); // weighted_pred_flag
+    writer.write_bits(0, 2); // weighted_bipred_idc
+    writer.write_se(0);      // pic_init_qp_minus26
+    writer.write_se(0);      // pic_init_qs_minus26
+    writer.write_se(0);      // chroma_qp_index_offset
+    writer.write_bits(1, 1); // deblocking_filter_control_present_flag
+    writer.write_bits(0, 1); // constrained_intra_pred_flag
+    writer.write_bits(0, 1); // redundant_pic_cnt_present_flag
+    return writer.finish();
+}
+
+void append_nal_unit(std::vector<u8>& frame, u8 nal_header, const std::vector<u8>& rbsp)
+{
+    static constexpr u8 start_code[] = { 0x00, 0x00, 0x00, 0x01 };
+    frame.insert(frame.end(), start_code, start_code + sizeof(start_code));
+    frame.push_back(nal_header);
+    frame.insert(frame.end(), rbsp.begin(), rbsp.end());
+}
+
+void write_u16(std::vector<u8>& bytes, usize offset, u16 value)
+{
+    bytes[offset] = value & 0xFF;
+    bytes[offset + 1] = value >> 8;
+}
+
+void write_float(std::vector<u8>& bytes, usize offset, float value)
+{
+    u32 float_bytes;
+    memcpy(&float_bytes, &value, sizeof(float_bytes));
+    bytes[offset] = float_bytes & 0xFF;
+    bytes[offset + 1] = (float_bytes >> 8) & 0xFF;
+    bytes[offset + 2] = (float_bytes >> 16) & 0xFF;
+    bytes[offset + 3] = (float_bytes >> 24) & 0xFF;
+}
+
+// Wraps a log record payload in the DJI log record framing, XOR-ing it with the tick's low byte
+std::vector<u8> seal_log_record(std::vector<u8> record, LogRecordType type, u32 tick)
+{
+    u8 xor_key = tick & 0xFF;
+    record[0] = 'U';
+    write_u16(record, 1, record.size());
+    record[3] = fast_crc8({ record.begin(), 3 });
+    write_u16(record, 4, static_cast<u16>(type));
+    record[6] = tick & 0xFF;
+    record[7] = (tick >> 8) & 0xFF;
+    record[8] = (tick >> 16) & 0xFF;
+    record[9] = (tick >> 24) & 0xFF;
+    for (usize i = 10; i < record.size() - 2; ++i)
+        record[i] ^= xor_key;
+    write_u16(record, record.size() - 2, fast_crc16({ record.begin(), record.size() - 2 }));
+    return record;
+}
+
+}
+
+Simulator::Simulator(SimulatorConfig config)
+    : m_config(std::move(config))
+    , m_start_time(std::chrono::steady_clock::now())
+{
+    m_cmd_socket_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (m_cmd_socket_fd == -1) {
+        perror("socket() -> m_cmd_socket_fd");
+        return;
+    }
+    sockaddr_in cmd_addr {};
+    cmd_addr.sin_family = AF_INET;
+    cmd_addr.sin_port = htons(m_config.cmd_port);
+    cmd_addr.sin_addr.s_addr = inet_addr(m_config.bind_ip.c_str());
+    if (bind(m_cmd_socket_fd, reinterpret_cast<sockaddr*>(&cmd_addr), sizeof(cmd_addr)) < 0) {
+        perror("bind(m_cmd_socket_fd)");
+        ::close(m_cmd_socket_fd);
+        m_cmd_socket_fd = -1;
+        return;
+    }
+    timeval sock_timeout {};
+    sock_timeout.tv_usec = std::chrono::duration_cast<std::chrono::microseconds>(CMD_RECEIVE_TIMEOUT).count();
+    setsockopt(m_cmd_socket_fd, SOL_SOCKET, SO_RCVTIMEO, &sock_timeout, sizeof(sock_timeout));
+
+    m_video_socket_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (m_video_socket_fd == -1) {
+        perror("socket() -> m_video_socket_fd");
+        ::close(m_cmd_socket_fd);
+        m_cmd_socket_fd = -1;
+        return;
+    }
+
+    m_cmd_receive_thread = std::thread(&Simulator::cmd_receive_thread_routine, this);
+    m_stream_thread = std::thread(&Simulator::stream_thread_routine, this);
+    if (m_config.response_delay.count() > 0)
+        m_response_thread = std::thread(&Simulator::response_thread_routine, this);
+}
+
+Simulator::~Simulator()
+{
+    stop();
+}
+
+void Simulator::stop()
+{
+    if (m_shutting_down.exchange(true) || !is_running())
+        return;
+
+    m_cmd_receive_thread.join();
+    m_stream_thread.join();
+    if (m_response_thread.joinable()) {
+        {
+            std::unique_lock<std::mutex> lock(m_delayed_responses_mutex);
+            m_delayed_responses_cv.notify_one();
+        }
+        m_response_thread.join();
+    }
+    ::close(m_cmd_socket_fd);
+    ::close(m_video_socket_fd);
+}
+
+bool Simulator::is_client_connected()
+{
+    std::unique_lock<std::mutex> lock(m_client_mutex);
+    return m_client_connected;
+}
+
+SimulatorStatistics Simulator::get_statistics()
+{
+    std::unique_lock<std::mutex> lock(m_statistics_mutex);
+    return m_statistics;
+}
+
+void Simulator::cmd_receive_thread_routine()
+{
+    u8 packet_buffer[4096];
+    while (!m_shutting_down) {
+        sockaddr_in sender_addr {};
+        socklen_t sender_addr_size = sizeof(sender_addr);
+        isize bytes_received = recvfrom(m_cmd_socket_fd, packet_buffer, sizeof(packet_buffer), 0,
+            reinterpret_cast<sockaddr*>(&sender_addr), &sender_addr_size);
+        if (bytes_received < 0) {
+            if (errno != EAGAIN)
+                std::cerr << "Simulator failed to receive bytes from cmd socket, errno: " << strerror(errno) << std::endl;
+            continue;
+        }
+
+        if (bytes_received >= 11 && memcmp(packet_buffer, "conn_req:", 9) == 0) {
+            std::unique_lock<std::mutex> lock(m_client_mutex);
+            m_client_cmd_addr = sender_addr;
+            m_client_video_addr = sender_addr;
+            m_client_video_addr.sin_port = htons(packet_buffer[9] | (packet_buffer[10] << 8));
+            m_client_connected = true;
+            lock.unlock();
+
+            u8 conn_ack[11] = { 'c', 'o', 'n', 'n', '_', 'a', 'c', 'k', ':', packet_buffer[9], packet_buffer[10] };
+            sendto(m_cmd_socket_fd, conn_ack, sizeof(conn_ack), 0, reinterpret_cast<const sockaddr*>(&sender_addr),
+                sizeof(sender_addr));
+            m_idr_requested = true;
+            continue;
+        }
+
+        auto packet = DronePacket::deserialize(std::span<u8>(packet_buffer, bytes_received));
+        if (packet.has_value())
+            handle_command(packet.value());
+    }
+}
+
+void Simulator::handle_command(const DronePacket& packet)
+{
+    std::unique_lock<std::mutex> lock(m_statistics_mutex);
+    switch (packet.cmd_id) {
+    case CommandID::SET_CURRENT_FLIGHT_CONTROLS:
+        m_statistics.control_packets_received++;
+        return;
+    case CommandID::REQUEST_VIDEO_SPS_PPS_HEADERS:
+        m_statistics.sps_pps_requests_received++;
+        m_idr_requested = true;
+        return;
+    case CommandID::DRONE_LOG_HEADER:
+    case CommandID::DRONE_LOG_CONFIGURATION:
+    case CommandID::GET_CURRENT_TIME:
+        // These are the app's answers to queries made by the drone, and are never acknowledged
+        return;
+    default:
+        if (is_command_lost()) {
+            m_statistics.commands_dropped++;
+            return;
+        }
+        m_statistics.commands_received++;
+        break;
+    }
+    lock.unlock();
+
+    auto version_response = [](char const* version) {
+        std::vector<u8> data(31);
+        memcpy(data.data() + 1, version, strlen(version));
+        return data;
+    };
+
+    switch (packet.cmd_id) {
+    case CommandID::GET_SSID: {
+        static constexpr char const* ssid = "TELLO-SIM";
+        std::vector<u8> data { 0x00 };
+        data.insert(data.end(), ssid, ssid + strlen(ssid));
+        send_response(packet, std::move(data));
+        break;
+    }
+    case CommandID::GET_FIRMWARE_VERSION:
+        send_response(packet, version_response("01.04.92.01"));
+        break;
+    case CommandID::GET_LOADER_VERSION:
+        send_response(packet, version_response("00.00.00.00"));
+        break;
+    case CommandID::GET_BITRATE:
+        send_response(packet, { 0x00, 0x00 });
+        break;
+    case CommandID::GET_FLIGHT_HEIGHT_LIMIT:
+        send_response(packet, { 0x00, 30, 0 });
+        break;
+    case CommandID::GET_LOW_BATTERY_WARNING:
+        send_response(packet, { 0x00, 10, 0 });
+        break;
+    case CommandID::GET_ATTITUDE_ANGLE: {
+        std::vector<u8> data(5);
+        write_float(data, 1, 25.0f);
+        send_response(packet, std::move(data));
+        break;
+    }
+    case CommandID::GET_COUNTRY_CODE:
+        send_response(packet, { 0x00, 'U', 'S' });
+        break;
+    case CommandID::GET_ACTIVATION_DATA:
+        send_response(packet, std::vector<u8>(58));
+        break;
+    case CommandID::GET_UNIQUE_IDENTIFIER: {
+        std::vector<u8> data(17);
+        for (usize i = 1; i < data.size(); ++i)
+            data[i] = 'a' + i;
+        send_response(packet, std::move(data));
+        break;
+    }
+    default:
+        send_response(packet, { 0x00 });
+        break;
+    }
+}
+
+void Simulator::send_to_client(DronePacket packet)
+{
+    std::unique_lock<std::mutex> lock(m_client_mutex);
+    auto client_addr = m_client_cmd_addr;
+    lock.unlock();
+
+    auto packet_bytes = packet.serialize();
+    sendto(m_cmd_socket_fd, packet_bytes.data(), packet_bytes.size(), 0,
+        reinterpret_cast<const sockaddr*>(&client_addr), sizeof(client_addr));
+}
+
+void Simulator::send_response(const DronePacket& command, std::vector<u8> data)
+{
+    if (is_command_lost()) {
+        std::unique_lock<std::mutex> lock(m_statistics_mutex);
+        m_statistics.responses_dropped++;
+        return;
+    }
+    DronePacket response(command.seq_num, SIMULATOR_PACKET_TYPE, command.cmd_id, std::move(data));
+    if (m_config.response_delay.count() > 0) {
+        std::unique_lock<std::mutex> lock(m_delayed_responses_mutex);
+        m_delayed_responses.push_back({ std::chrono::steady_clock::now() + m_config.response_delay, std::move(response) });
+        m_delayed_responses_cv.notify_one();
+    } else {
+        send_to_client(std::move(response));
+    }
+    std::unique_lock<std::mutex> lock(m_statistics_mutex);
+    m_statistics.commands_acked++;
+}
+
+void Simulator::response_thread_routine()
+{
+    // Every response is delayed by the same amount, so they are due in the order they were queued
+    std::unique_lock<std::mutex> lock(m_delayed_responses_mutex);
+    while (!m_shutting_down) {
+        if (m_delayed_responses.empty()) {
+            m_delayed_responses_cv.wait(lock);
+            continue;
+        }
+        auto send_time = m_delayed_responses.front().send_time;
+        if (std::chrono::steady_clock::now() < send_time) {
+            m_delayed_responses_cv.wait_until(lock, send_time);
+            continue;
+        }
+        auto response = std::move(m_delayed_responses.front().packet);
+        m_delayed_responses.pop_front();
+        lock.unlock();
+        send_to_client(std::move(response));
+        lock.lock();
+    }
+}
+
+bool Simulator::is_command_lost()
+{
+    return m_config.command_loss > 0 && std::uniform_real_distribution<double>(0, 1)(m_command_random) < m_config.command_loss;
+}
+
+void Simulator::stream_thread_routine()
+{
+    using Clock = std::chrono::steady_clock;
+    auto period_of = [](u32 rate) { return std::chrono::nanoseconds(rate == 0 ? 0 : 1'000'000'000 / rate); };
+    const auto flight_data_period = period_of(m_config.flight_data_rate_hz);
+    const auto log_data_period = period_of(m_config.log_data_rate_hz);
+    const auto wifi_state_period = period_of(m_config.wifi_state_rate_hz);
+    const auto video_period = period_of(m_config.video_fps);
+
+    auto now = Clock::now();
+    auto next_flight_data = now, next_log_data = now, next_wifi_state = now, next_video_frame = now;
+    while (!m_shutting_down) {
+        if (!is_client_connected()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            now = next_flight_data = next_log_data = next_wifi_state = next_video_frame = Clock::now();
+            continue;
+        }
+
+        now = Clock::now();
+        if (flight_data_period.count() && now >= next_flight_data) {
+            send_flight_data();
+            next_flight_data += flight_data_period;
+        }
+        if (log_data_period.count() && now >= next_log_data) {
+            send_log_data();
+            next_log_data += log_data_period;
+        }
+        if (wifi_state_period.count() && now >= next_wifi_state) {
+            send_wifi_state();
+            next_wifi_state += wifi_state_period;
+        }
+        if (video_period.count() && now >= next_video_frame) {
+            send_video_frame();
+            next_video_frame += video_period;
+        }
+
+        auto next_event = Clock::time_point::max();
+        if (flight_data_period.count())
+            next_event = std::min(next_event, next_flight_data);
+        if (log_data_period.count())
+            next_event = std::min(next_event, next_log_data);
+        if (wifi_state_period.count())
+            next_event = std::min(next_event, next_wifi_state);
+        if (video_period.count())
+            next_event = std::min(next_event, next_video_frame);
+        std::this_thread::sleep_until(std::min(next_event, Clock::now() + std::chrono::milliseconds(100)));
+    }
+}
+
+void Simulator::send_flight_data()
+{
+    auto elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_start_time).count();
+    std::vector<u8> data(24);
+    write_u16(data, 0, static_cast<i16>(10 + 5 * std::sin(elapsed)));  // height
+    write_u16(data, 2, static_cast<i16>(3 * std::cos(elapsed)));       // north_speed
+    write_u16(data, 4, static_cast<i16>(3 * std::sin(elapsed)));       // east_speed
+    write_u16(data, 8, static_cast<i16>(elapsed * 10));                // flight_time
+    data[10] = 0b00111111;                                             // sensor states
+    data[12] = static_cast<u8>(std::max(5.0f, 100 - elapsed / 10));   // battery_percentage
+    write_u16(data, 13, 600);                                          // flight_time_left
+    write_u16(data, 15, 3800);                                         // battery_left
+    data[17] = 0b00001001;                                             // eMSky, drone_hover
+    data[18] = 6;                                                      // flight_mode
+    send_to_client(DronePacket(0, SIMULATOR_PACKET_TYPE, CommandID::FLIGHT_DATA, std::move(data)));
+
+    std::unique_lock<std::mutex> lock(m_statistics_mutex);
+    m_statistics.flight_data_packets_sent++;
+}
+
+std::vector<u8> Simulator::build_mvo_record()
+{
+    auto elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_start_time).count();
+    std::vector<u8> record(MVO_RECORD_LENGTH);
+    write_u16(record, 12, static_cast<i16>(100 * std::cos(elapsed)));
+    write_u16(record, 14, static_cast<i16>(100 * std::sin(elapsed)));
+    write_u16(record, 16, 0);
+    write_float(record, 18, std::cos(elapsed));
+    write_float(record, 22, std::sin(elapsed));
+    write_float(record, 26, -1.0f);
+    record[86] = 0x77; // Velocity and position validity flags
+    return seal_log_record(std::move(record), LogRecordType::MVO, m_log_record_tick++);
+}
+
+std::vector<u8> Simulator::build_imu_record()
+{
+    auto elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_start_time).count();
+    std::vector<u8> record(IMU_RECORD_LENGTH);
+    write_float(record, 58, std::cos(elapsed / 2));
+    write_float(record, 62, 0.0f);
+    write_float(record, 66, 0.0f);
+    write_float(record, 70, std::sin(elapsed / 2));
+    write_u16(record, 116, 4200);
+    return seal_log_record(std::move(record), LogRecordType::IMU, m_log_record_tick++);
+}
+
+void Simulator::send_log_data()
+{
+    std::vector<u8> data { 0x00 };
+    auto mvo_record = build_mvo_record();
+    auto imu_record = build_imu_record();
+    data.insert(data.end(), mvo_record.begin(), mvo_record.end());
+    data.insert(data.end(), imu_record.begin(), imu_record.end());
+    send_to_client(DronePacket(0, SIMULATOR_PACKET_TYPE, CommandID::DRONE_LOG_DATA, std::move(data)));
+
+    std::unique_lock<std::mutex> lock(m_statistics_mutex);
+    m_statistics.log_data_packets_sent++;
+}
+
+void Simulator::send_wifi_state()
+{
+    send_to_client(DronePacket(0, SIMULATOR_PACKET_TYPE, CommandID::WIFI_STATE, { 90, 0 }));
+    send_to_client(DronePacket(0, SIMULATOR_PACKET_TYPE, CommandID::LIGHT_STRENGTH, { 1 }));
+
+    std::unique_lock<std::mutex> lock(m_statistics_mutex);
+    m_statistics.wifi_state_packets_sent++;
+}
+
+void Simulator::send_video_frame()
+{
+    bool idr_frame = m_idr_requested.exchange(false)
+        || (m_config.video_gop_length != 0 && m_frames_since_idr >= m_config.video_gop_length);
+    usize average_frame_size = m_config.video_bitrate_kbps * 1000 / 8 / std::max<u32>(m_config.video_fps, 1);
+    usize slice_size = idr_frame ? average_frame_size * 4 : average_frame_size * 3 / 4;
+    slice_size = std::min(slice_size, MAX_SEGMENTS_PER_FRAME * m_config.video_segment_payload_size - 64);
+
+    // A slice header up to frame_num, which clients use to detect lost reference frames. Every picture is a
+    // reference picture, so frame_num counts the frames since the IDR frame (modulo 2^log2_max_frame_num).
+    BitWriter slice_header;
+    slice_header.write_ue(0);                           // first_mb_in_slice
+    slice_header.write_ue(idr_frame ? 7 : 5);           // slice_type: I or P, for all slices of the picture
+    slice_header.write_ue(0);                           // pic_parameter_set_id
+    slice_header.write_bits(idr_frame ? 0 : m_frames_since_idr % 16, 4); // frame_num
+    auto slice_data = slice_header.finish();
+
+    // Followed by random slice data that never contains zero bytes, so it cannot emulate a start code
+    auto header_size = slice_data.size();
+    slice_data.resize(std::max(slice_size, header_size));
+    for (usize i = header_size; i < slice_data.size(); ++i)
+        slice_data[i] = 1 + m_random() % 255;
+
+    std::vector<u8> frame;
+    frame.reserve(slice_size + 64);
+    if (idr_frame) {
+        append_nal_unit(frame, 0x67, build_sequence_parameter_set());
+        append_nal_unit(frame, 0x68, build_picture_parameter_set());
+        append_nal_unit(frame, 0x65, slice_data);
+        m_frames_since_idr = 0;
+    } else {
+        append_nal_unit(frame, 0x41, slice_data);
+    }
+    m_frames_since_idr++;
+
+    std::unique_lock<std::mutex> lock(m_client_mutex);
+    auto video_addr = m_client_video_addr;
+    lock.unlock();
+
+    const usize payload_size = m_config.video_segment_payload_size;
+    usize segment_count = (frame.size() + payload_size - 1) / payload_size;
+    std::vector<u8> segment(payload_size + 2);
+    for (usize segment_num = 0; segment_num < segment_count; ++segment_num) {
+        usize offset = segment_num * payload_size;
+        usize length = std::min(payload_size, frame.size() - offset);
+        bool last_segment = segment_num == segment_count - 1;
+        if (m_config.video_segment_loss > 0 && std::uniform_real_distribution<double>(0, 1)(m_random) < m_config.video_segment_loss) {
+            std::unique_lock<std::mutex> statistics_lock(m_statistics_mutex);
+            m_statistics.video_segments_dropped++;
+            continue;
+        }
+        segment[0] = m_video_frame_num;
+        segment[1] = segment_num | (last_segment ? 0x80 : 0x00);
+        memcpy(segment.data() + 2, frame.data() + offset, length);
+        sendto(m_video_socket_fd, segment.data(), length + 2, 0, reinterpret_cast<const sockaddr*>(&video_addr),
+            sizeof(video_addr));
+    }
+    m_video_frame_num++;
+
+    std::unique_lock<std::mutex> statistics_lock(m_statistics_mutex);
+    m_statistics.video_frames_sent++;
+    m_statistics.video_segments_sent += segment_count;
+    m_statistics.video_bytes_sent += frame.size();
+}
+
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "DronePacket.h"
+#include "Utils/Types.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <netinet/in.h>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Tello {
+
+struct SimulatorConfig {
+    std::string bind_ip { "127.0.0.1" };
+    u16 cmd_port { 8889 };
+
+    u32 flight_data_rate_hz { 10 };
+    u32 log_data_rate_hz { 20 };
+    u32 wifi_state_rate_hz { 2 };
+
+    u32 video_fps { 30 };
+    u32 video_bitrate_kbps { 2500 };
+    u32 video_gop_length { 30 }; // Frames between unrequested IDR frames, 0 for IDR frames only on request
+    usize video_segment_payload_size { 1458 };
+    // Fraction of video segments that are not sent, to exercise the client's loss handling
+    double video_segment_loss { 0 };
+    // Fraction of acknowledged commands, and separately of their responses, that are lost, to exercise the
+    // client's retransmission
+    double command_loss { 0 };
+    // Responses are held back this long, as a stand-in for the round trip time of the drone's WIFI link
+    std::chrono::microseconds response_delay { 0 };
+};
+
+struct SimulatorStatistics {
+    u64 commands_received { 0 };
+    u64 commands_acked { 0 };
+    u64 commands_dropped { 0 };
+    u64 responses_dropped { 0 };
+    u64 control_packets_received { 0 };
+    u64 sps_pps_requests_received { 0 };
+    u64 flight_data_packets_sent { 0 };
+    u64 log_data_packets_sent { 0 };
+    u64 wifi_state_packets_sent { 0 };
+    u64 video_frames_sent { 0 };
+    u64 video_segments_sent { 0 };
+    u64 video_bytes_sent { 0 };
+    u64 video_segments_dropped { 0 };
+};
+
+// A local stand-in for a Tello drone, speaking the protocol described in Documentation/protocol.md.
+// It answers connection requests, acknowledges commands, streams telemetry and pushes synthetic
+// segmented H264 to the video port announced in `conn_req:`.
+class Simulator {
+public:
+    explicit Simulator(SimulatorConfig config = {});
+    ~Simulator();
+
+    [[nodiscard]] bool is_running() const { return m_cmd_socket_fd != -1; }
+    [[nodiscard]] bool is_client_connected();
+    [[nodiscard]] SimulatorStatistics get_statistics();
+
+    void stop();
+
+private:
+    void cmd_receive_thread_routine();
+    void stream_thread_routine();
+    void response_thread_routine();
+
+    void handle_command(const DronePacket& packet);
+    void send_to_client(DronePacket packet);
+    void send_response(const DronePacket& command, std::vector<u8> data);
+    bool is_command_lost();
+
+    void send_flight_data();
+    void send_log_data();
+    void send_wifi_state();
+    void send_video_frame();
+
+    std::vector<u8> build_mvo_record();
+    std::vector<u8> build_imu_record();
+
+    SimulatorConfig m_config;
+
+    int m_cmd_socket_fd { -1 };
+    int m_video_socket_fd { -1 };
+    std::thread m_cmd_receive_thread;
+    std::thread m_stream_thread;
+    // Only runs with a response delay
+    std::thread m_response_thread;
+    std::atomic<bool> m_shutting_down { false };
+
+    std::mutex m_client_mutex;
+    bool m_client_connected { false };
+    sockaddr_in m_client_cmd_addr {};
+    sockaddr_in m_client_video_addr {};
+
+    std::atomic<bool> m_idr_requested { true };
+    u8 m_video_frame_num { 0 };
+    u32 m_frames_since_idr { 0 };
+    u32 m_log_record_tick { 0 };
+    std::minstd_rand m_random;
+    // Only used by the cmd receive thread
+    std::minstd_rand m_command_random;
+
+    struct DelayedResponse {
+        std::chrono::steady_clock::time_point send_time;
+        DronePacket packet;
+    };
+    std::mutex m_delayed_responses_mutex;
+    std::condition_variable m_delayed_responses_cv;
+    std::deque<DelayedResponse> m_delayed_responses;
+
+    std::mutex m_statistics_mutex;
+    SimulatorStatistics m_statistics;
+
+    std::chrono::steady_clock::time_point m_start_time;
+};
+
+}
@@ -0,0 +1,81 @@
+#include "TelloSimulator.h"
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+static volatile std::sig_atomic_t s_interrupted = 0;
+
+static void print_usage(char const* program_name)
+{
+    std::cerr << "Usage: " << program_name << " [options]\n"
+              << "  --bind <ip>          Address to listen on (default: 127.0.0.1)\n"
+              << "  --port <port>        Command port to listen on (default: 8889)\n"
+              << "  --fps <fps>          Video frame rate, 0 disables video (default: 30)\n"
+              << "  --bitrate <kbps>     Video bitrate (default: 2500)\n"
+              << "  --gop <frames>       Frames between IDR frames, 0 for on-request only (default: 30)\n"
+              << "  --video-loss <pct>   Percentage of video segments to drop (default: 0)\n"
+              << "  --cmd-loss <pct>     Percentage of commands, and of responses, to drop (default: 0)\n"
+              << "  --response-delay <ms> Delay before every response is sent (default: 0)\n"
+              << "  --duration <sec>     Exit after this many seconds (default: run until interrupted)\n";
+}
+
+int main(int argc, char** argv)
+{
+    Tello::SimulatorConfig config;
+    u32 duration_seconds = 0;
+    for (int i = 1; i < argc; ++i) {
+        auto has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--bind") == 0 && has_value) {
+            config.bind_ip = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && has_value) {
+            config.cmd_port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--fps") == 0 && has_value) {
+            config.video_fps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bitrate") == 0 && has_value) {
+            config.video_bitrate_kbps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--gop") == 0 && has_value) {
+            config.video_gop_length = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--video-loss") == 0 && has_value) {
+            config.video_segment_loss = atof(argv[++i]) / 100;
+        } else if (strcmp(argv[i], "--cmd-loss") == 0 && has_value) {
+            config.command_loss = atof(argv[++i]) / 100;
+        } else if (strcmp(argv[i], "--response-delay") == 0 && has_value) {
+            config.response_delay = std::chrono::microseconds(static_cast<i64>(atof(argv[++i]) * 1000));
+        } else if (strcmp(argv[i], "--duration") == 0 && has_value) {
+            duration_seconds = atoi(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    signal(SIGINT, [](int) { s_interrupted = 1; });
+    signal(SIGTERM, [](int) { s_interrupted = 1; });
+
+    Tello::Simulator simulator(config);
+    if (!simulator.is_running())
+        return 1;
+    std::cout << "Simulating a drone on " << config.bind_ip << ':' << config.cmd_port << ", press Ctrl+C to stop" << std::endl;
+
+    auto start_time = std::chrono::steady_clock::now();
+    while (!s_interrupted) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (duration_seconds != 0 && std::chrono::steady_clock::now() - start_time >= std::chrono::seconds(duration_seconds))
+            break;
+    }
+    simulator.stop();
+
+    auto statistics = simulator.get_statistics();
+    std::cout << "Commands received: " << statistics.commands_received << " (acked " << statistics.commands_acked << ", "
+              << statistics.commands_dropped << " dropped, " << statistics.responses_dropped << " responses dropped)\n"
+              << "Control packets received: " << statistics.control_packets_received << '\n'
+              << "SPS/PPS requests received: " << statistics.sps_pps_requests_received << '\n'
+              << "Flight data packets sent: " << statistics.flight_data_packets_sent << '\n'
+              << "Log data packets sent: " << statistics.log_data_packets_sent << '\n'
+              << "WIFI state packets sent: " << statistics.wifi_state_packets_sent << '\n'
+              << "Video frames sent: " << statistics.video_frames_sent << " (" << statistics.video_segments_sent
+              << " segments, " << statistics.video_bytes_sent << " bytes, " << statistics.video_segments_dropped
+              << " segments dropped)" << std::endl;
+    return 0;
+}